@@ -47,6 +47,19 @@ void DecompressorBase::setFilename(const PPSystemString& fileName)
 	this->fileName = fileName;
 }
 
+bool DecompressorBase::decompressToFile(const PPSystemString& outFileName, Hints hint)
+{
+	XMMemoryFile out;
+	if (!decompress(out, hint))
+		return false;
+	
+	XMFile f(outFileName, true);
+	if (!f.isOpenForWriting())
+		return false;
+	
+	return f.write(out.getBuffer(), 1, out.size()) == (mp_sint32)out.size();
+}
+
 Decompressor::Decompressor(const PPSystemString& fileName) :
 	DecompressorBase(fileName)
 {
@@ -133,6 +146,21 @@ bool Decompressor::decompress(const PPSystemString& outFileName, Hints hint)
 	return result;
 }
 
+bool Decompressor::decompress(XMMemoryFile& out, Hints hint)
+{
+	for (pp_int32 i = 0; i < decompressors.size(); i++)
+	{
+		if (decompressors.get(i)->identify())
+		{
+			out.clear();
+			if (decompressors.get(i)->decompress(out, hint))
+				return true;
+		}
+	}
+	
+	return false;
+}
+
 DecompressorBase* Decompressor::clone()
 {
 	return new Decompressor(fileName);
@@ -35,6 +35,8 @@
 #include "SimpleVector.h"
 
 class XMFile;
+class XMFileBase;
+class XMMemoryFile;
 
 class DecompressorBase
 {
@@ -68,6 +70,10 @@ public:
 	
 	virtual bool decompress(const PPSystemString& outFileName, Hints hint) = 0;
 	
+	// Decompress into memory instead of a file. Returns false if decompression 
+	// failed or if this decompressor can only write files (use the above then)
+	virtual bool decompress(XMMemoryFile& out, Hints hint) { return false; }
+	
 	static void removeFile(const PPSystemString& fileName);
 	
 	virtual void setFilename(const PPSystemString& fileName);
@@ -77,6 +83,10 @@ public:
 protected:
 	PPSystemString fileName;
 
+	// for archives which are extracted into memory anyway, writes the
+	// result of the above to outFileName
+	bool decompressToFile(const PPSystemString& outFileName, Hints hint);
+
 	mutable PPSimpleVector<Descriptor> descriptors;
 };
 
@@ -96,6 +106,8 @@ public:
 
 	virtual bool decompress(const PPSystemString& outFileName, Hints hint);
 	
+	virtual bool decompress(XMMemoryFile& out, Hints hint);
+	
 	virtual DecompressorBase* clone();
 
 	virtual void setFilename(const PPSystemString& fileName);
@@ -55,7 +55,7 @@ const PPSimpleVector<Descriptor>& DecompressorGZIP::getDescriptors(Hints hint) c
 	return descriptors;
 }
 
-bool DecompressorGZIP::decompress(const PPSystemString& outFileName, Hints hint)
+static bool gunzip(const PPSystemString& fileName, XMFileBase& fOut)
 {
 	gzFile gz_input_file = NULL;
 	int len = 0;
@@ -67,8 +67,6 @@ bool DecompressorGZIP::decompress(const PPSystemString& outFileName, Hints hint)
 	if ((buf = new pp_uint8[0x10000]) == NULL)
 		return false;
 
-	XMFile fOut(outFileName, true);
-
 	while (true)
 	{
 		len = gzread (gz_input_file, buf, 0x10000);
@@ -95,6 +93,17 @@ bool DecompressorGZIP::decompress(const PPSystemString& outFileName, Hints hint)
 	return true;
 }
 
+bool DecompressorGZIP::decompress(const PPSystemString& outFileName, Hints hint)
+{
+	XMFile fOut(outFileName, true);
+	return gunzip(fileName, fOut);
+}
+
+bool DecompressorGZIP::decompress(XMMemoryFile& out, Hints hint)
+{
+	return gunzip(fileName, out);
+}
+
 DecompressorBase* DecompressorGZIP::clone()
 {
 	return new DecompressorGZIP(fileName);
@@ -35,6 +35,8 @@
 #include "XModule.h"
 
 #define LHA_BUFFER_SIZE 0x10000
+// limit for reserving the unpacked size up front, relative to the archive
+#define MAXRESERVERATIO 16
 
 namespace
 {
@@ -122,6 +124,11 @@ const PPSimpleVector<Descriptor>& DecompressorLHA::getDescriptors(Hints hint) co
 }		
 	
 bool DecompressorLHA::decompress(const PPSystemString& outFilename, Hints hint)
+{
+	return decompressToFile(outFilename, hint);
+}
+
+bool DecompressorLHA::decompress(XMMemoryFile& out, Hints hint)
 {
 	XMFile f(fileName);
 	
@@ -151,15 +158,17 @@ bool DecompressorLHA::decompress(const PPSystemString& outFilename, Hints hint)
 
 		if (bytes_read > 0 && XModule::identifyModule(buf) != NULL)
 		{
-			// Write to output file
-			XMFile outFile(outFilename, true);
-			if (!outFile.isOpenForWriting())
-				return false;
-
-			// Decompress into outFile
+			// header->length comes from the archive, don't trust it with
+			// more than the packed file can plausibly expand to
+			mp_uint32 hint = (mp_uint32)header->length;
+			if (hint / MAXRESERVERATIO > f.size())
+				hint = f.size() * MAXRESERVERATIO;
+			out.reserve(hint);
+
+			// Decompress into out
 			do
 			{
-				outFile.write(buf, 1, bytes_read);
+				out.write(buf, 1, bytes_read);
 			}
 			while ((bytes_read = reader.read(buf, sizeof(buf))) > 0);
 
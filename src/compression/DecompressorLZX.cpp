@@ -36,14 +36,16 @@
 
 struct ModuleIdentificator : public Unlzx::FileIdentificator 
 {
-	virtual bool identify(const PPSystemString& filename) const
+	virtual bool identify(XMMemoryFile& file) const
 	{
-		XMFile file(filename);
-		
 		mp_ubyte buff[XModule::IdentificationBufferSize];
 		memset(buff, 0, sizeof(buff));
 
-		file.read(buff, 1, sizeof(buff));
+		mp_uint32 size = file.size();
+		if (size > sizeof(buff))
+			size = sizeof(buff);
+		if (size)
+			memcpy(buff, file.getBuffer(), size);
 		
 		return XModule::identifyModule(buff) != NULL;
 	}
@@ -73,6 +75,11 @@ const PPSimpleVector<Descriptor>& DecompressorLZX::getDescriptors(Hints hint) co
 }		
 	
 bool DecompressorLZX::decompress(const PPSystemString& outFilename, Hints hint)
+{
+	return decompressToFile(outFilename, hint);
+}
+
+bool DecompressorLZX::decompress(XMMemoryFile& out, Hints hint)
 {
 	// If client requests something else than a module we can't deal we that
 	if (hint != HintAll &&
@@ -82,7 +89,7 @@ bool DecompressorLZX::decompress(const PPSystemString& outFilename, Hints hint)
 	ModuleIdentificator identificator;
 	Unlzx unlzx(fileName, &identificator);
 	
-	return unlzx.extractFile(true, &outFilename);
+	return unlzx.extractFile(true, &out);
 }
 
 DecompressorBase* DecompressorLZX::clone()
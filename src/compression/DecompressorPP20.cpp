@@ -54,8 +54,10 @@ const PPSimpleVector<Descriptor>& DecompressorPP20::getDescriptors(Hints hint) c
 	return descriptors;
 }	
 	
-bool DecompressorPP20::decompress(const PPSystemString& outFileName, Hints hint)
+static pp_uint8* unpack(const PPSystemString& fileName, unsigned& resultSize)
 {
+	resultSize = 0;
+
 	XMFile f(fileName);	
 	unsigned int size = f.size();
 	unsigned char* buffer = new unsigned char[size];
@@ -67,22 +69,28 @@ bool DecompressorPP20::decompress(const PPSystemString& outFileName, Hints hint)
 	if (!pp20.isCompressed(buffer, size))
 	{
 		delete[] buffer;
-		return false;
+		return NULL;
 	}
 	
-	XMFile fOut(outFileName, true);
-
 	pp_uint8* outBuffer = NULL;
 	 
-	unsigned resultSize = pp20.decompress(buffer, size, &outBuffer);
+	resultSize = pp20.decompress(buffer, size, &outBuffer);
 
 	// delete this, it was allocated
 	delete[] buffer;
 
 	// if resultSize is 0 there is nothing more to deallocate
-	if (resultSize == 0)
+	return resultSize ? outBuffer : NULL;
+}
+	
+bool DecompressorPP20::decompress(const PPSystemString& outFileName, Hints hint)
+{
+	unsigned resultSize;
+	pp_uint8* outBuffer = unpack(fileName, resultSize);
+	if (outBuffer == NULL)
 		return false;
 
+	XMFile fOut(outFileName, true);
 	fOut.write(outBuffer, 1, resultSize);
 
 	delete[] outBuffer;
@@ -90,6 +98,20 @@ bool DecompressorPP20::decompress(const PPSystemString& outFileName, Hints hint)
 	return true;
 }
 
+bool DecompressorPP20::decompress(XMMemoryFile& out, Hints hint)
+{
+	unsigned resultSize;
+	pp_uint8* outBuffer = unpack(fileName, resultSize);
+	if (outBuffer == NULL)
+		return false;
+
+	out.write(outBuffer, 1, resultSize);
+
+	delete[] outBuffer;
+
+	return true;
+}
+
 DecompressorBase* DecompressorPP20::clone()
 {
 	return new DecompressorPP20(fileName);
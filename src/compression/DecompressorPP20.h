@@ -50,6 +50,8 @@ public:
 
 	virtual bool decompress(const PPSystemString& outFileName, Hints hint);
 
+	virtual bool decompress(XMMemoryFile& out, Hints hint);
+
 	virtual DecompressorBase* clone();
 };
 
@@ -63,14 +63,12 @@ const PPSimpleVector<Descriptor>& DecompressorUMX::getDescriptors(Hints hint) co
 #define MAGIC_SCRM	MAGIC4('S','C','R','M')
 #define MAGIC_M_K_	MAGIC4('M','.','K','.')
 	
-bool DecompressorUMX::decompress(const PPSystemString& outFileName, Hints hint)
+// find the embedded module and copy it to fOut
+static bool extractModule(const PPSystemString& fileName, XMFileBase& fOut)
 {
-	// If client requests something else than a module we can't deal we that
-	if (hint != HintAll &&
-		hint != HintModules)
-		return false;
-
 	XMFile f(fileName);	
+	if (!f.isOpen())
+		return false;
 
 	int i;
 	pp_uint8 *buf, *b;
@@ -110,8 +108,6 @@ bool DecompressorUMX::decompress(const PPSystemString& outFileName, Hints hint)
 
 	f.seek(offset);
 	
-	XMFile fOut(outFileName, true);
-
 	do {
 		len = f.read(buf, 1, 0x10000);
 		fOut.write(buf, 1, len);
@@ -122,6 +118,22 @@ bool DecompressorUMX::decompress(const PPSystemString& outFileName, Hints hint)
 	return true;
 }
 
+bool DecompressorUMX::decompress(const PPSystemString& outFileName, Hints hint)
+{
+	// only create the target once a module has been found
+	return decompressToFile(outFileName, hint);
+}
+
+bool DecompressorUMX::decompress(XMMemoryFile& out, Hints hint)
+{
+	// If client requests something else than a module we can't deal we that
+	if (hint != HintAll &&
+		hint != HintModules)
+		return false;
+
+	return extractModule(fileName, out);
+}
+
 DecompressorBase* DecompressorUMX::clone()
 {
 	return new DecompressorUMX(fileName);
@@ -50,7 +50,7 @@ bool DecompressorZIP::identify(XMFile& f)
 	ZipExtractor extractor(filename);
 	
 	pp_int32 error = 0;
-	bool res = extractor.parseZip(error, false, NULL);
+	bool res = extractor.parseZip(error, NULL);
 	return (res && error == 0);
 }	
 	
@@ -66,11 +66,16 @@ const PPSimpleVector<Descriptor>& DecompressorZIP::getDescriptors(Hints hint) co
 }		
 	
 bool DecompressorZIP::decompress(const PPSystemString& outFilename, Hints hint)
+{
+	return decompressToFile(outFilename, hint);
+}
+
+bool DecompressorZIP::decompress(XMMemoryFile& out, Hints hint)
 {
 	ZipExtractor extractor(fileName);
 	
 	pp_int32 error = 0;
-	bool res = extractor.parseZip(error, true, &outFilename);
+	bool res = extractor.parseZip(error, &out);
 	return (res && error == 0);
 }
 
@@ -37,6 +37,10 @@
 #include "MyIO.h"
 #include <zzip/lib.h>
 
+// deflate rarely packs modules better than this, larger sizes claimed
+// by a header aren't reserved up front
+#define MAXRESERVERATIO 16
+
 static const struct zzip_plugin_io milkytracker_zzip_io =
 {
     &Myopen,
@@ -53,10 +57,11 @@ ZipExtractor::ZipExtractor(const PPSystemString& archivePath) :
 {
 }
 
-bool ZipExtractor::parseZip(pp_int32& err, bool extract, const PPSystemString* outFile)
+bool ZipExtractor::parseZip(pp_int32& err, XMMemoryFile* out)
 {
     int i;
 	int fd;
+	mp_uint32 archiveSize;
     
 	ZZIP_DIR * dir;
     zzip_error_t rv;
@@ -73,6 +78,7 @@ bool ZipExtractor::parseZip(pp_int32& err, bool extract, const PPSystemString* o
 			err = 1;
 			return false;
 		}
+		archiveSize = (mp_uint32)Myfsize(fd);
         
 		if (! (dir = zzip_dir_fdopen_ext_io(fd, &rv, NULL, (zzip_plugin_io_t) &milkytracker_zzip_io)))
         {
@@ -153,13 +159,18 @@ bool ZipExtractor::parseZip(pp_int32& err, bool extract, const PPSystemString* o
 
 						if (id)
 						{														
-							if (extract)
+							if (out)
 							{
-								XMFile f(*outFile, true);
-								f.write(buf, 1, i);
+								// the unpacked size is only a hint, write() grows
+								// the buffer when it's wrong or the reserve fails
+								mp_uint32 hint = hdr->d_usize;
+								if (hint / MAXRESERVERATIO > archiveSize)
+									hint = archiveSize * MAXRESERVERATIO;
+								out->reserve(hint);
+								out->write(buf, 1, i);
 								while (0 < (i = zzip_file_read(fp, (char*)buf, 16384)))
 								{
-									f.write(buf, 1, i);
+									out->write(buf, 1, i);
 								}
 								if (i < 0)
 								{
@@ -33,6 +33,8 @@
 
 #include "BasicTypes.h"
 
+class XMMemoryFile;
+
 class ZipExtractor
 {
 private:
@@ -41,7 +43,9 @@ private:
 public:
 	ZipExtractor(const PPSystemString& archivePath);
 
-	bool parseZip(pp_int32& err, bool extract, const PPSystemString* outFile);
+	// finds the first module in the archive and extracts it to out,
+	// only checks whether there is one if out is NULL
+	bool parseZip(pp_int32& err, XMMemoryFile* out);
 };
 
 #endif
@@ -610,21 +610,46 @@ void Unlzx::decrunch(struct UnLZX *unlzx)
 	unlzx->global_shift = shift;
 }
 
-XMFile* Unlzx::open_output(const PPSystemString& filename)
+XMFileBase* Unlzx::open_output(struct UnLZX *unlzx, bool found)
 {
-	XMFile *file = new XMFile(filename, true);
+	if (unlzx->output)
+	{
+		// keep what has been identified already
+		if (found)
+			return NULL;
+		
+		unlzx->output->clear();
+		return unlzx->output;
+	}
+	
+	XMFile *file = new XMFile(PPSystemString((const char*)unlzx->work_buffer), true);
 	
 	if (!file->isOpenForWriting())
+	{
+		delete file;
 		return NULL;
+	}
 	
 	return(file);
 }
 
+void Unlzx::close_output(XMFileBase* out_file, struct UnLZX *unlzx, bool abort, bool& found)
+{
+	if (out_file != unlzx->output)
+	{
+		delete out_file;
+		return;
+	}
+	
+	if (!abort && identificator)
+		found = identificator->identify(*unlzx->output);
+}
+
 signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	found = false;
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned char *pos, *temp;
 	unsigned long count;
 	signed long abort = 0;
@@ -656,7 +681,7 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 #ifdef UNLZX_DEBUG
 			printf("Extracting \"%s\"...", (char *)node->filename);
 #endif			
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(unlzx, found);
 		}
 		else
 		{
@@ -732,7 +757,8 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 #ifdef UNLZX_DEBUG
 					perror("FWrite");
 #endif
-					delete out_file;
+					if (out_file != unlzx->output)
+						delete out_file;
 					out_file = 0;
 				}
 			}
@@ -741,16 +767,11 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			close_output(out_file, unlzx, abort != 0, found);
 		}
 	}
 	return(abort);
@@ -759,7 +780,7 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned long count;
 	signed long abort = 0;
 	
@@ -781,7 +802,7 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 #ifdef UNLZX_DEBUG
 			printf("Storing \"%s\"...", (char *)node->filename);
 #endif
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(unlzx, found);
 		}
 		else
 		{
@@ -817,7 +838,8 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 #ifdef UNLZX_DEBUG
 					perror("FWrite");
 #endif
-					delete out_file;
+					if (out_file != unlzx->output)
+						delete out_file;
 					out_file = 0;
 				}
 			}
@@ -825,16 +847,11 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			close_output(out_file, unlzx, abort != 0, found);
 		}
 	}
 	return(abort);
@@ -1323,7 +1340,7 @@ Unlzx::~Unlzx()
 		unlzx_free(unlzx);
 }
 
-bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
+bool Unlzx::extractFile(bool extract, XMMemoryFile* output)
 {
 	int result = 0;
 	
@@ -1332,7 +1349,7 @@ bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
 		if (extract)
 		{
 			unlzx->mode = 1;
-			unlzx->temporaryFile = outFilename;
+			unlzx->output = output;
 			bool found = false;
 			// TODO: make this all type safe
 			result = process_archive(archiveFilename, unlzx, found);
@@ -26,13 +26,15 @@ LONG mkdir(STRPTR path, UWORD perm);
 #include "BasicTypes.h"
 
 class XMFile;
+class XMFileBase;
+class XMMemoryFile;
 
 class Unlzx
 {
 public:
 	struct FileIdentificator
 	{
-		virtual bool identify(const PPSystemString& filename) const = 0;
+		virtual bool identify(XMMemoryFile& file) const = 0;
 	};
 
 
@@ -97,7 +99,8 @@ private:
 		
 		unsigned long sum;
 		
-		const PPSystemString* temporaryFile;
+		// every file is extracted here in turn until one is identified
+		XMMemoryFile* output;
 	};
 	
 	PPSystemString archiveFilename;
@@ -115,7 +118,8 @@ private:
 	signed long make_decode_table(signed long number_symbols, signed long table_size, unsigned char *length, unsigned short *table);
 	signed long read_literal_table(struct UnLZX *unlzx);
 	void decrunch(struct UnLZX *unlzx);
-	XMFile* open_output(const PPSystemString& filename);
+	XMFileBase* open_output(struct UnLZX *unlzx, bool found);
+	void close_output(XMFileBase* out_file, struct UnLZX *unlzx, bool abort, bool& found);
 	signed long extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& found);
 	signed long extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& found);
 	signed long extract_unknown(XMFile* in_file, struct UnLZX *unlzx, bool& found);
@@ -127,7 +131,7 @@ public:
 	Unlzx(const PPSystemString& archiveFilename, const FileIdentificator* identificator = NULL);
 	~Unlzx();
 	
-	bool extractFile(bool extract, const PPSystemString* outFilename);
+	bool extractFile(bool extract, XMMemoryFile* output);
 };
 
 #define PMATCH_MAXSTRLEN  512    /*  max string length  */
@@ -36,13 +36,14 @@
  *
  *  This class is pretty much emulating a Gravis Ultrasound with a timer set to 250Hz
  *  I.e. the mixer() routine will call a user specified handler 250 times per second
- *  while mixing the audio stream in between.
+ *  while mixing the audio stream in between (see setTimerFrequency for other rates).
  */
 #include "ChannelMixer.h"
 #include "ResamplerFactory.h"
 #include "ResamplerMacros.h"
 #include "AudioDriverManager.h"
 #include <math.h>
+#include <chrono>
  
 // Ramp out will last (THEBEATLENGTH*RAMPDOWNFRACTION)>>8 samples
 #define RAMPDOWNFRACTION 256
@@ -493,7 +494,17 @@ void ChannelMixer::setFrequency(mp_sint32 frequency)
 	mixFrequency = frequency;
 	rMixFrequency = 0x7FFFFFFF / frequency;
 
-	beatPacketSize = (MP_BEATLENGTH*frequency)/MP_BASEFREQ;	
+	updateBeatPacketSize();
+	
+	if (resamplerType != MIXER_INVALID && resamplerTable[resamplerType])
+		resamplerTable[resamplerType]->setFrequency(frequency);
+}
+
+void ChannelMixer::updateBeatPacketSize()
+{
+	beatPacketSize = mixFrequency / timerFrequency;
+	if (!beatPacketSize)
+		beatPacketSize = 1;
 	
 	if (mixbuffBeatPacket)
 	{
@@ -506,9 +517,6 @@ void ChannelMixer::setFrequency(mp_sint32 frequency)
 	// channels contain information based on beatPacketSize so this might
 	// have been changed
 	reallocChannels();
-	
-	if (resamplerType != MIXER_INVALID && resamplerTable[resamplerType])
-		resamplerTable[resamplerType]->setFrequency(frequency);
 }
 
 void ChannelMixer::reallocChannels()
@@ -553,6 +561,9 @@ ChannelMixer::ChannelMixer(mp_uint32 numChannels,
 	mixFrequency(0),
 	mixbuffBeatPacket(NULL),
 	mixBufferSize(0),
+	timerFrequency(MP_TIMERFREQ),
+	cpuBudget(0),
+	mixerLoad(0),
 	channel(NULL),
 	newChannel(NULL),
 	resamplerType(MIXER_INVALID),
@@ -950,6 +961,26 @@ static inline void storeTimeRecordData(mp_sint32 nb, ChannelMixer::TMixerChannel
 	}
 }
 
+static inline mp_int64 getMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ChannelMixer::updateMixerLoad(mp_int64 startTime, mp_uint32 numSamples)
+{
+	// time available for numSamples in microseconds
+	const mp_int64 period = ((mp_int64)numSamples * 1000000) / mixFrequency;
+	if (!period)
+		return;
+	
+	mp_int64 load = ((getMicroseconds() - startTime) * 100) / period;
+	if (load > 1000)
+		load = 1000;
+	
+	// smooth out scheduling hiccups
+	mixerLoad = (mixerLoad*3 + (mp_uint32)load + 3) >> 2;
+}
+
 void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 {
 	updateSampleCounter(bufferSize);
@@ -1043,6 +1074,8 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 					}
 				}
 
+				const mp_int64 startTime = cpuBudget ? getMicroseconds() : 0;
+
 				timer(nb);
 
 				if (!disableMixing)
@@ -1054,6 +1087,9 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 
 					mixBeatPacket(mixerNumActiveChannels, buffer+nb*beatLength*MP_NUMCHANNELS, nb, beatLength);	
 				}
+				
+				if (cpuBudget)
+					updateMixerLoad(startTime, beatLength);
 			}		
 
 			buffer+=numbeats*beatLength*MP_NUMCHANNELS;
@@ -1097,6 +1133,8 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 					}
 				}
 
+				const mp_int64 startTime = cpuBudget ? getMicroseconds() : 0;
+
 				timer(numbeats);
 
 				if (!disableMixing)
@@ -1108,6 +1146,9 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 
 					mixBeatPacket(mixerNumActiveChannels, mixbuffBeatPacket, numbeats, beatLength);	
 				}
+				
+				if (cpuBudget)
+					updateMixerLoad(startTime, beatLength);
 
 				mp_sint32 todo = mixBufferSize - done;
 
@@ -1190,9 +1231,9 @@ mp_sint32 ChannelMixer::adjustFrequency(mp_uint32 frequency)
 	return err;
 }
 
-mp_sint32 ChannelMixer::beatPacketsToBufferSize(mp_uint32 mixFrequency, mp_uint32 numBeats)
+mp_sint32 ChannelMixer::beatPacketsToBufferSize(mp_uint32 mixFrequency, mp_uint32 numBeats, mp_uint32 timerFrequency/* = MP_TIMERFREQ*/)
 {
-	mp_uint32 beatPacketSize = (MP_BEATLENGTH*mixFrequency)/MP_BASEFREQ;
+	mp_uint32 beatPacketSize = mixFrequency/timerFrequency;
 	return numBeats * beatPacketSize;
 }
 
@@ -1210,6 +1251,32 @@ mp_sint32 ChannelMixer::setBufferSize(mp_uint32 bufferSize)
 	return MP_OK;
 }
 
+mp_sint32 ChannelMixer::setTimerFrequency(mp_uint32 timerFrequency)
+{
+	if (timerFrequency < MP_TIMERFREQ_MIN)
+		timerFrequency = MP_TIMERFREQ_MIN;
+	else if (timerFrequency > MP_TIMERFREQ_MAX)
+		timerFrequency = MP_TIMERFREQ_MAX;
+
+	if (this->timerFrequency == timerFrequency)
+		return MP_OK;
+
+	mp_sint32 err = MP_OK;
+	// whatever is left of the last beat packet doesn't fit the new size
+	if (initialized)
+	{
+		err = closeDevice();
+	}
+
+	this->timerFrequency = timerFrequency;
+	
+	updateBeatPacketSize();
+	
+	lastBeatRemainder = 0;
+	
+	return err;
+}
+
 mp_sint32 ChannelMixer::getNumActiveChannels()
 {	
 	mp_sint32 i = 0;
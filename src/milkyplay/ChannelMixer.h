@@ -36,6 +36,7 @@
  *  This class is pretty much emulating a Gravis Ultrasound with a timer set to 250Hz
  *  i.e. mixerHandler() will call a timer routine 250 times per second while mixing 
  *  the audio stream in between.
+ *  The timer frequency can be changed using setTimerFrequency(), 250Hz is the default.
  */
 #ifndef __CHANNELMIXER_H__
 #define __CHANNELMIXER_H__
@@ -127,11 +128,15 @@ public:
 	enum
 	{
 		// This is the basis for timing & mixing
-		// 250hz timer
+		// 250hz timer (default)
 		MP_TIMERFREQ		= 250,	
 		MP_BASEFREQ			= 48000,	// is chosen because (48000 % 250) == 0
 		// period in samples for MP_TIMERFREQ
 		MP_BEATLENGTH		= (MP_BASEFREQ/MP_TIMERFREQ),
+		// valid range for the timer frequency, the lower bound
+		// must stay above the highest tick rate (255 BPM = 102Hz)
+		MP_TIMERFREQ_MIN	= 125,
+		MP_TIMERFREQ_MAX	= 2000,
 		// mixer state flags
 		MP_SAMPLE_FILTERLP	= 65536,
 		MP_SAMPLE_MUTE		= 32768,
@@ -361,9 +366,13 @@ private:
 	mp_sint32*  mixbuffBeatPacket;
 	mp_uint32	mixBufferSize;				// this is the resulting buffer size in 16 bit words
 
-	mp_uint32	beatPacketSize;				// size of 1/250 of a second in samples
+	mp_uint32	timerFrequency;				// how many beat packets per second (default is 250)
+	mp_uint32	beatPacketSize;				// size of 1/timerFrequency of a second in samples
 	mp_uint32	numBeatPackets;				// how many of these fit in our buffer size
 	mp_uint32	lastBeatRemainder;			// used while filling the buffer, if the buffer is not an exact multiple of beatPacketSize
+
+	mp_uint32	cpuBudget;					// allowed processing time in percent of a beat packet (0 = unlimited)
+	mp_uint32	mixerLoad;					// measured processing time in percent of a beat packet
 		
 	TMixerChannel*	channel;
 	TMixerChannel*  newChannel;
@@ -381,6 +390,8 @@ private:
 	bool			allowFilters;
 
 	void			setFrequency(mp_sint32 frequency);
+	void			updateBeatPacketSize();
+	void			updateMixerLoad(mp_int64 startTime, mp_uint32 numSamples);
 	
 	void			mixBeatPacket(mp_uint32 numChannels,
 								  mp_sint32* buffer32,
@@ -431,12 +442,25 @@ public:
 	virtual mp_sint32 adjustFrequency(mp_uint32 frequency);
 	mp_sint32		getMixFrequency() { return mixFrequency; }
 	
-	static mp_sint32 beatPacketsToBufferSize(mp_uint32 mixFrequency, mp_uint32 numBeats);	
+	static mp_sint32 beatPacketsToBufferSize(mp_uint32 mixFrequency, mp_uint32 numBeats, mp_uint32 timerFrequency = MP_TIMERFREQ);	
 	virtual mp_sint32 setBufferSize(mp_uint32 bufferSize);
 	
+	// Higher timer frequencies result in shorter beat packets (more precise
+	// effect timing and shorter volume ramps), lower frequencies reduce
+	// the per packet overhead. The value is clamped to MP_TIMERFREQ_MIN..MP_TIMERFREQ_MAX
+	virtual mp_sint32 setTimerFrequency(mp_uint32 timerFrequency);
+	mp_uint32		getTimerFrequency() const { return timerFrequency; }
+	
 	mp_uint32		getBeatPacketSize() const { return beatPacketSize; }
 	mp_uint32		getNumBeatPackets() const { return mixBufferSize / beatPacketSize; } 
 
+	// Processing time per beat packet (timer + mixing) is only measured 
+	// when a budget is set. The budget is given in percent of the beat packet 
+	// duration, players may drop voices while the load is above the budget
+	void			setCPUBudget(mp_uint32 percent) { cpuBudget = percent; mixerLoad = 0; }
+	mp_uint32		getCPUBudget() const { return cpuBudget; }
+	mp_uint32		getMixerLoad() const { return mixerLoad; }
+
 	// volume control
 	void			setMasterVolume(mp_sint32 vol) { masterVolume = vol; }
 	mp_sint32		getMasterVolume() const { return masterVolume; }	
@@ -1342,6 +1342,16 @@ static void sort(mp_sword* array,mp_sint32 l, mp_sint32 r)
 }
 
 mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName, const char* trackerString/* = NULL*/)
+{
+	XMFile f(fileName, true);
+	
+	if (!f.isOpenForWriting())
+		return MP_DEVICE_ERROR;
+
+	return saveExtendedModule(f, trackerString);
+}
+
+mp_sint32 XModule::saveExtendedModule(XMFileBase& f, const char* trackerString/* = NULL*/)
 {
 	mp_sint32 i,j,k,l;
 	
@@ -1362,11 +1372,6 @@ mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName, const char* track
 		insNum++;
 	
 	// ------ start ---------------------------------
-	XMFile f(fileName, true);
-	
-	if (!f.isOpenForWriting())
-		return MP_DEVICE_ERROR;
-
 	f.write("Extended Module: ",1,17);
 	
 	char titleBuffer[MP_MAXTEXT+1], titleBufferTemp[MP_MAXTEXT+1];
@@ -239,33 +239,15 @@ static mp_sint32 loadAMSSamples(XModule* module, XMFileBase& f)
 			}
 			else
 			{
-				if (!(smp[i].type&16)) {
-					
-					smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen);
-					
-					if (smp[i].sample == NULL)
-					{
-						return MP_OUT_OF_MEMORY;
-					}
-					
-					if (!module->loadSample(f,smp[i].sample,smp[i].samplen,smp[i].samplen))
-					{
-						return MP_OUT_OF_MEMORY;
-					}					
-				}
-				else {
-					
-					smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen*2);
-					
-					if (smp[i].sample == NULL)
-					{
-						return MP_OUT_OF_MEMORY;
-					}
-					
-					if (!module->loadSample(f,smp[i].sample, smp[i].samplen*2, smp[i].samplen, XModule::ST_16BIT))
-					{
-						return MP_OUT_OF_MEMORY;
-					}									
+				mp_sint32 res;
+				if (!(smp[i].type&16))
+					res = module->loadSampleData(f, smp[i].sample, smp[i].samplen, smp[i].samplen, smp[i].samplen);
+				else
+					res = module->loadSampleData(f, smp[i].sample, smp[i].samplen*2, smp[i].samplen*2, smp[i].samplen, XModule::ST_16BIT);
+
+				if (res != MP_OK)
+				{
+					return res;
 				}
 			}
 			
@@ -1261,6 +1243,7 @@ mp_sint32 LoaderAMSv2::load(XMFileBase& f, XModule* module)
 	}
 
 	// duplicate shadowed samples
+	module->decodePendingSamples();
 	for (i = 0; i < header->smpnum; i++)
 	{
 		if ((smp[i].flags & 64))
@@ -1278,6 +1261,10 @@ mp_sint32 LoaderAMSv2::load(XMFileBase& f, XModule* module)
 						// copy sample
 						mp_sint32 size = (smp[i].type & 16)?(smp[i].samplen<<1):smp[i].samplen;
 						
+						// samples are skipped when probing
+						if (smp[shadowInsLut[shadowIns*16+k]].sample == NULL)
+							continue;
+						
 						smp[i].sample = (mp_sbyte*)module->allocSampleMem(size);
 						
 						//memcpy(smp[i].sample, smp[instr[shadowIns].extra[k]].sample, size);
@@ -370,27 +370,22 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 			}
 
 			case 0x494E464F:	// 'INFO'
-				f.read(buffer, 1, 2);
-				header->insnum = BigEndian::GET_WORD(buffer);
-				f.read(buffer, 1, 2);
-				header->smpnum = BigEndian::GET_WORD(buffer);
+				header->insnum = f.readWordBE();
+				header->smpnum = f.readWordBE();
 
 				srcSmp = new DBMSample[header->smpnum];
 
-				f.read(buffer, 1, 2);
-				numSubSongs = BigEndian::GET_WORD(buffer);
+				numSubSongs = f.readWordBE();
 
 				// Allocate order list table
 				orderLists = new mp_uword*[numSubSongs];
 				orderListLengths = new mp_uword[numSubSongs];
 
-				f.read(buffer, 1, 2);
-				header->patnum = BigEndian::GET_WORD(buffer);
+				header->patnum = f.readWordBE();
 				
 				patterns = new mp_ubyte*[header->patnum];
 				
-				f.read(buffer, 1, 2);
-				header->channum = BigEndian::GET_WORD(buffer);
+				header->channum = f.readWordBE();
 				break;
 
 			case 0x534F4E47:	// 'SONG'
@@ -401,15 +396,9 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 					mp_ubyte name[44];
 					f.read(name, 1, 44);
 
-					f.read(buffer, 1, 2);
-					orderListLengths[i] = BigEndian::GET_WORD(buffer);
-					orderLists[i] = new mp_uword[BigEndian::GET_WORD(buffer)];
-
-					for (j = 0; j < orderListLengths[i]; j++)
-					{
-						f.read(buffer, 1, 2);
-						orderLists[i][j] = BigEndian::GET_WORD(buffer);
-					}
+					orderListLengths[i] = f.readWordBE();
+					orderLists[i] = new mp_uword[orderListLengths[i]];
+					f.readWordsBE(orderLists[i], orderListLengths[i]);
 				}
 				break;
 			}
@@ -423,20 +412,13 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 				for (i = 0; i < insNum; i++)
 				{
 					f.read(srcIns[i].name, 1, 30);
-					f.read(buffer, 2, 1);
-					srcIns[i].sampnum = BigEndian::GET_WORD(buffer);
-					f.read(buffer, 2, 1);
-					srcIns[i].volume = BigEndian::GET_WORD(buffer);
-					f.read(buffer, 4, 1);
-					srcIns[i].finetune = BigEndian::GET_DWORD(buffer);
-					f.read(buffer, 4, 1);
-					srcIns[i].repstart = BigEndian::GET_DWORD(buffer);
-					f.read(buffer, 4, 1);
-					srcIns[i].replen = BigEndian::GET_DWORD(buffer);
-					f.read(buffer, 2, 1);
-					srcIns[i].panning = BigEndian::GET_WORD(buffer);
-					f.read(buffer, 2, 1);
-					srcIns[i].flags = BigEndian::GET_WORD(buffer);
+					srcIns[i].sampnum = f.readWordBE();
+					srcIns[i].volume = f.readWordBE();
+					srcIns[i].finetune = f.readDwordBE();
+					srcIns[i].repstart = f.readDwordBE();
+					srcIns[i].replen = f.readDwordBE();
+					srcIns[i].panning = f.readWordBE();
+					srcIns[i].flags = f.readWordBE();
 				
 					srcIns[i].venvnum = srcIns[i].penvnum = -1;
 				}
@@ -447,10 +429,8 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 			{
 				for (i = 0; i < header->patnum; i++)
 				{
-					f.read(buffer, 2, 1);
-					phead[i].rows = BigEndian::GET_WORD(buffer);
-					f.read(buffer, 4, 1);
-					phead[i].len = BigEndian::GET_DWORD(buffer);
+					phead[i].rows = f.readWordBE();
+					phead[i].len = f.readDwordBE();
 
 					patterns[i] = new mp_ubyte[phead[i].len];
 					f.read(patterns[i], 1, phead[i].len);
@@ -462,12 +442,15 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 			{
 				for (i = 0; i < header->smpnum; i++)
 				{
-					f.read(buffer, 4, 1);
-					srcSmp[i].flags = BigEndian::GET_DWORD(buffer);
-					f.read(buffer, 4, 1);
-					srcSmp[i].samplen = BigEndian::GET_DWORD(buffer);
+					srcSmp[i].flags = f.readDwordBE();
+					srcSmp[i].samplen = f.readDwordBE();
+					srcSmp[i].sample = NULL;
 					
-					if (srcSmp[i].flags == 1)
+					if (module->isProbing() && (srcSmp[i].flags == 1 || srcSmp[i].flags == 2))
+					{
+						XModule::skipSample(f, 0, srcSmp[i].samplen, srcSmp[i].flags == 2 ? XModule::ST_16BIT : XModule::ST_DEFAULT);
+					}
+					else if (srcSmp[i].flags == 1)
 					{
 						srcSmp[i].sample = new mp_ubyte[srcSmp[i].samplen];
 						module->loadSample(f, srcSmp[i].sample, srcSmp[i].samplen, srcSmp[i].samplen);
@@ -489,12 +472,10 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 
 			case 0x56454E56:	// 'VENV'
 			{
-				f.read(buffer, 2, 1);
-				mp_uword numEnvelopes = BigEndian::GET_WORD(buffer);
+				mp_uword numEnvelopes = f.readWordBE();
 				for (i = 0; i < numEnvelopes; i++)
 				{
-					f.read(buffer, 2, 1);
-					mp_uword index = BigEndian::GET_WORD(buffer);
+					mp_uword index = f.readWordBE();
 					
 					if (index)
 						srcIns[index-1].venvnum = module->numVEnvs;
@@ -516,12 +497,10 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 
 			case 0x50454E56:	// 'PENV'
 			{
-				f.read(buffer, 2, 1);
-				mp_uword numEnvelopes = BigEndian::GET_WORD(buffer);
+				mp_uword numEnvelopes = f.readWordBE();
 				for (i = 0; i < numEnvelopes; i++)
 				{
-					f.read(buffer, 2, 1);
-					mp_uword index = BigEndian::GET_WORD(buffer);
+					mp_uword index = f.readWordBE();
 					
 					if (index)
 						srcIns[index-1].penvnum = module->numPEnvs;
@@ -687,7 +666,11 @@ mp_sint32 LoaderDBM::load(XMFileBase& f, XModule* module)
 
 				smp[i].samplen = srcSmp[j].samplen;
 
-				if (srcSmp[j].flags == 1)
+				if (srcSmp[j].sample == NULL)
+				{
+					// skipped when probing
+				}
+				else if (srcSmp[j].flags == 1)
 				{
 					smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen);
 					memcpy(smp[i].sample, srcSmp[j].sample, smp[i].samplen);
@@ -860,18 +860,12 @@ mp_sint32 LoaderDSMv2::load(XMFileBase& f, XModule* module)
 					s->pan = 0x80;
 					XModule::convertc4spd(c2spd, &s->finetune, &s->relnote);
 				
-					s->sample = (mp_sbyte*)module->allocSampleMem(length);
-				
-					if (s->sample == NULL)
+					mp_sint32 res = module->loadSampleData(f, s->sample, length, length, length, (flags & 2) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED);
+					if (res != MP_OK)
 					{
-						return MP_OUT_OF_MEMORY;
+						return res;
 					}
 				
-					if (!module->loadSample(f, s->sample, length, length, (flags & 2) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED))
-					{
-						return MP_OUT_OF_MEMORY;
-					}					
-				
 					smpcnt++;
 				}
 
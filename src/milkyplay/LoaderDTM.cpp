@@ -132,19 +132,18 @@ mp_sint32 LoaderDTM_2::load(XMFileBase& f, XModule* module)
 			case 0x442E542E :	// 'D.T.'
 			{
 				mp_sint32 pos = f.posWithBaseOffset();
-				f.read(buffer, 1, 2);
-				mp_uword type = BigEndian::GET_WORD(buffer);
+				mp_uword type = f.readWordBE();
 				if (type)
 				{
 					return MP_LOADER_FAILED;
 				}
-				f.read(buffer, 1, 4);
-				f.read(buffer, 1, 2);
-				if (BigEndian::GET_WORD(buffer))
-					header->tempo = BigEndian::GET_WORD(buffer);
-				f.read(buffer, 1, 2);				
-				if (BigEndian::GET_WORD(buffer))
-					header->speed = BigEndian::GET_WORD(buffer);
+				f.readDword();
+				mp_uword tempo = f.readWordBE();
+				if (tempo)
+					header->tempo = tempo;
+				mp_uword speed = f.readWordBE();
+				if (speed)
+					header->speed = speed;
 				
 				mp_uint32 len = chunkLen - 10;
 				
@@ -178,10 +177,8 @@ mp_sint32 LoaderDTM_2::load(XMFileBase& f, XModule* module)
 			{
 				mp_uint32 pos = f.posWithBaseOffset();
 				
-				f.read(buffer, 1, 2);				
-				header->ordnum = BigEndian::GET_WORD(buffer);				
-				f.read(buffer, 1, 2);				
-				header->restart = BigEndian::GET_WORD(buffer);				
+				header->ordnum = f.readWordBE();
+				header->restart = f.readWordBE();
 				f.read(buffer, 1, 4);				
 
 				f.read(header->ord, 1, header->ordnum);
@@ -193,10 +190,8 @@ mp_sint32 LoaderDTM_2::load(XMFileBase& f, XModule* module)
 			case 0x50415454:	// 'PATT'
 			{
 				mp_uint32 pos = f.posWithBaseOffset();
-				f.read(buffer, 1, 2);				
-				header->channum = BigEndian::GET_WORD(buffer);				
-				f.read(buffer, 1, 2);				
-				header->patnum = BigEndian::GET_WORD(buffer);				
+				header->channum = f.readWordBE();
+				header->patnum = f.readWordBE();
 				f.read(buffer, 1, 4);	
 				
 				if (!BigEndian::GET_DWORD(buffer))
@@ -213,33 +208,27 @@ mp_sint32 LoaderDTM_2::load(XMFileBase& f, XModule* module)
 			case 0x494E5354:	// 'INST'
 			{
 				mp_uint32 pos = f.posWithBaseOffset();
-				f.read(buffer, 1, 2);				
-				header->insnum = BigEndian::GET_WORD(buffer);				
+				header->insnum = f.readWordBE();
 				
 				s = 0;
 				for (i = 0; i < header->insnum; i++)
 				{
 					f.readDword(); // reserved
 
-					f.read(buffer, 1, 4);	
-					smp[s].samplen = BigEndian::GET_DWORD(buffer);
+					smp[s].samplen = f.readDwordBE();
 					mp_ubyte fine = f.readByte();
 					
 					smp[s].vol = module->vol64to255(f.readByte());				
-					f.read(buffer, 1, 4);	
-					smp[s].loopstart = BigEndian::GET_DWORD(buffer);					
-					f.read(buffer, 1, 4);	
-					smp[s].looplen = BigEndian::GET_DWORD(buffer);
+					smp[s].loopstart = f.readDwordBE();
+					smp[s].looplen = f.readDwordBE();
 					f.read(instr[i].name, 1, 22); // instrument name				
 
-					f.read(buffer, 1, 2);	
-					mp_uword type = BigEndian::GET_WORD(buffer);
+					mp_uword type = f.readWordBE();
 
 					mp_ubyte bits = (mp_ubyte)type;		
 
-					f.read(buffer, 1, 4);	// MIDI
-					f.read(buffer, 1, 4);	
-					mp_uint32 c4spd = BigEndian::GET_DWORD(buffer);
+					f.readDword();	// MIDI
+					mp_uint32 c4spd = f.readDwordBE();
 
 					mp_sint32 newC4spd = XModule::sfinetunes[fine & 0xF];
 				
@@ -286,10 +275,8 @@ mp_sint32 LoaderDTM_2::load(XMFileBase& f, XModule* module)
 				mp_uint32 pos = f.posWithBaseOffset();
 				f.readDword(); // reserved
 				
-				f.read(buffer, 1, 2);					
-				i = BigEndian::GET_WORD(buffer);
-				f.read(buffer, 1, 2);					
-				mp_uint32 numRows = BigEndian::GET_WORD(buffer);
+				i = f.readWordBE();
+				mp_uint32 numRows = f.readWordBE();
 				
 				if (i >= 0 && i < header->patnum)
 				{
@@ -401,8 +388,7 @@ mp_sint32 LoaderDTM_2::load(XMFileBase& f, XModule* module)
 			{
 				mp_uint32 pos = f.posWithBaseOffset();
 
-				f.read(buffer, 1, 2);					
-				i = BigEndian::GET_WORD(buffer);
+				i = f.readWordBE();
 				
 				if (instr[i].samp)
 				{
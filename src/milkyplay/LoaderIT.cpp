@@ -622,47 +622,21 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 
 		if ((itSmp.Flg & 1))
 		{
-			if (!(smp[i].type&16)) {
-
-				smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen);
-
-				if (smp[i].sample == NULL)
-				{
-					return MP_OUT_OF_MEMORY;
-				}
-
-				if (itSmp.Flg & 8)
-				{
-					if (!module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? XModule::ST_PACKING_IT215 : XModule::ST_PACKING_IT))
-					{
-						return MP_OUT_OF_MEMORY;
-					}
-				}
-				else if (!module->loadSample(f,smp[i].sample,smp[i].samplen,smp[i].samplen, (itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED))
-				{
-					return MP_OUT_OF_MEMORY;
-				}					
-			}
-			else {
-
-				smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen*2);
-
-				if (smp[i].sample == NULL)
-				{
-					return MP_OUT_OF_MEMORY;
-				}
-
-				if (itSmp.Flg & 8)
-				{
-					if (!module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? (XModule::ST_PACKING_IT215 | XModule::ST_16BIT) : (XModule::ST_PACKING_IT | XModule::ST_16BIT)))
-					{
-						return MP_OUT_OF_MEMORY;
-					}
-				}
-				else if (!module->loadSample(f,smp[i].sample,smp[i].samplen<<1,smp[i].samplen, XModule::ST_16BIT | ((itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED)))
-				{
-					return MP_OUT_OF_MEMORY;
-				}					
+			mp_sint32 loadFlags;
+			if (itSmp.Flg & 8)
+				loadFlags = (itSmp.Cvt & 4) ? XModule::ST_PACKING_IT215 : XModule::ST_PACKING_IT;
+			else
+				loadFlags = (itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED;
+
+			mp_sint32 res;
+			if (!(smp[i].type&16))
+				res = module->loadSampleData(f, smp[i].sample, smp[i].samplen, smp[i].samplen, smp[i].samplen, loadFlags);
+			else
+				res = module->loadSampleData(f, smp[i].sample, smp[i].samplen*2, smp[i].samplen<<1, smp[i].samplen, loadFlags | XModule::ST_16BIT);
+
+			if (res != MP_OK)
+			{
+				return res;
 			}
 		}
 	}
@@ -374,20 +374,7 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 				switch (pb) {
 					case 0:	{
 						if (!(mdlsamp[s].infobyte&1)) {
-							mdlsamp[s].smp = (mp_sbyte*)module->allocSampleMem(mdlsamp[s].samplen);
-							
-							// out of memory
-							if (mdlsamp[s].smp==NULL)
-							{
-								if (mdlins) delete[] mdlins;
-								if (mdlsamp) delete[] mdlsamp;
-								if (trackseq) delete[] trackseq;
-								if (tracks) delete[] tracks;
-								
-								return MP_OUT_OF_MEMORY;
-							}
-							
-							if (!module->loadSample(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen))
+							if (module->loadSampleData(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen,mdlsamp[s].samplen) != MP_OK)
 							{
 								if (mdlins) delete[] mdlins;
 								if (mdlsamp) delete[] mdlsamp;
@@ -399,20 +386,7 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 							
 						}
 						else {
-							mdlsamp[s].smp = (mp_sbyte*)module->allocSampleMem(mdlsamp[s].samplen);
-							
-							// out of memory
-							if (mdlsamp[s].smp==NULL)
-							{
-								if (mdlins) delete[] mdlins;
-								if (mdlsamp) delete[] mdlsamp;
-								if (trackseq) delete[] trackseq;
-								if (tracks) delete[] tracks;
-								
-								return MP_OUT_OF_MEMORY;
-							}
-							
-							if (!module->loadSample(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen>>1,XModule::ST_16BIT))
+							if (module->loadSampleData(f,mdlsamp[s].smp,mdlsamp[s].samplen,mdlsamp[s].samplen,mdlsamp[s].samplen>>1,XModule::ST_16BIT) != MP_OK)
 							{
 								if (mdlins) delete[] mdlins;
 								if (mdlsamp) delete[] mdlsamp;
@@ -430,20 +404,7 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 					case 1: {
 						mp_sint32 size = (mp_sint32)f.readDword();
 						
-						mdlsamp[s].smp = (mp_sbyte*)module->allocSampleMem(mdlsamp[s].samplen);
-						
-						// out of memory
-						if (mdlsamp[s].smp==NULL)
-						{
-							if (mdlins) delete[] mdlins;
-							if (mdlsamp) delete[] mdlsamp;
-							if (trackseq) delete[] trackseq;
-							if (tracks) delete[] tracks;
-							
-							return MP_OUT_OF_MEMORY;
-						}
-						
-						if (!module->loadSample(f,mdlsamp[s].smp,size,mdlsamp[s].samplen,XModule::ST_PACKING_MDL))
+						if (module->loadSampleData(f,mdlsamp[s].smp,mdlsamp[s].samplen,size,mdlsamp[s].samplen,XModule::ST_PACKING_MDL) != MP_OK)
 						{
 							if (mdlins) delete[] mdlins;
 							if (mdlsamp) delete[] mdlsamp;
@@ -457,24 +418,11 @@ mp_sint32 LoaderMDL::load(XMFileBase& f, XModule* module)
 					case 2: {
 						mp_sint32 size = (mp_sint32)f.readDword();
 						
-						mdlsamp[s].smp = (mp_sbyte*)module->allocSampleMem(mdlsamp[s].samplen);					
-						
-						// out of memory
-						if (mdlsamp[s].smp==NULL)
-						{
-							if (mdlins) delete[] mdlins;
-							if (mdlsamp) delete[] mdlsamp;
-							if (trackseq) delete[] trackseq;
-							if (tracks) delete[] tracks;
-							
-							return MP_OUT_OF_MEMORY;
-						}
-						
 						mp_uint32 samplen = mdlsamp[s].samplen>>1;
 						//mp_uint32 loopstart = mdlsamp[s].loopstart>>1;
 						//mp_uint32 looplen = mdlsamp[s].looplen>>1;
 						
-						if (!module->loadSample(f,mdlsamp[s].smp,size,samplen,XModule::ST_PACKING_MDL | XModule::ST_16BIT))
+						if (module->loadSampleData(f,mdlsamp[s].smp,mdlsamp[s].samplen,size,samplen,XModule::ST_PACKING_MDL | XModule::ST_16BIT) != MP_OK)
 						{
 							if (mdlins) delete[] mdlins;
 							if (mdlsamp) delete[] mdlsamp;
@@ -388,17 +388,11 @@ mp_sint32 LoaderOKT::load(XMFileBase& f, XModule* module)
 				if (smp[sc].samplen > allocMem)
 					allocMem = smp[sc].samplen;
 			
-				smp[sc].sample = (mp_sbyte*)module->allocSampleMem(allocMem);
-				memset(smp[sc].sample, 0, allocMem);
-				
-				if (smp[sc].sample == NULL)
-				{
-					return MP_OUT_OF_MEMORY;
-				}
-				
-				if (!module->loadSample(f,smp[sc].sample,sampLen,sampLen))
+				// the part behind the data is cleared as well
+				mp_sint32 res = module->loadSampleData(f, smp[sc].sample, allocMem, allocMem, sampLen);
+				if (res != MP_OK)
 				{
-					return MP_OUT_OF_MEMORY;
+					return res;
 				}
 			
 				sc++;
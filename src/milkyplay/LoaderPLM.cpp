@@ -289,9 +289,10 @@ mp_sint32 LoaderPLM::load(XMFileBase& f, XModule* module)
 				instr[i].snum[j] = i;
 			}
 
-			smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen);
+			mp_sint32 res = module->loadSampleData(f, smp[i].sample, smp[i].samplen, smp[i].samplen, 
+												   (flags&1) ? smp[i].samplen>>1 : smp[i].samplen, XModule::ST_UNSIGNED);
 			
-			if (smp[i].sample == NULL)
+			if (res != MP_OK)
 			{
 				for (j = 0; j < numPatterns; j++)
 					delete[] patterns[j];
@@ -299,21 +300,19 @@ mp_sint32 LoaderPLM::load(XMFileBase& f, XModule* module)
 				delete[] smpOffsets;
 				delete[] patOffsets;
 				delete[] ordHeaders;
-				return MP_OUT_OF_MEMORY;
+				return res;
 			}
 			
 			if (flags&1)
 			{		
-				module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen>>1, XModule::ST_UNSIGNED);
 				smp[i].samplen>>=1;
 			}
 			else 
 			{
-				module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, XModule::ST_UNSIGNED);				
 				// due to some bug in DT2 it seems all samples are starting with
 				// signed byte -47
 				// we're trying to apply some correction to that
-				if (smp[i].samplen)
+				if (smp[i].samplen && smp[i].sample)
 					smp[i].sample[0] = smp[i].sample[1];
 			}
 
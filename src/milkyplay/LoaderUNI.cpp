@@ -903,16 +903,6 @@ mp_sint32 LoaderUNI::load(XMFileBase& f, XModule* module)
 		//if (!smp[i].samplen)
 		//	continue;
 
-		if (smp[i].type & 16)
-			smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen<<1);
-		else
-			smp[i].sample = (mp_sbyte*)module->allocSampleMem(smp[i].samplen);
-		
-		if (smp[i].sample == NULL)
-		{
-			return MP_OUT_OF_MEMORY;
-		}
-		
 		mp_sint32 loadFlags = XModule::ST_DEFAULT;
 		
 		if (smp[i].type & 16)
@@ -922,21 +912,12 @@ mp_sint32 LoaderUNI::load(XMFileBase& f, XModule* module)
 		if (((smp[i].flags >> 6) & 1) == 1)
 			loadFlags |= XModule::ST_UNSIGNED;
 		
-		// 16bit sample
-		if (smp[i].type & 16)
-		{
-			if (!module->loadSample(f,smp[i].sample,smp[i].samplen<<1,smp[i].samplen,loadFlags))
-			{
-				return MP_OUT_OF_MEMORY;
-			}
-		}
-		// 8bit sample
-		else 
+		mp_uint32 size = (smp[i].type & 16) ? smp[i].samplen<<1 : smp[i].samplen;
+		
+		mp_sint32 res = module->loadSampleData(f, smp[i].sample, size, size, smp[i].samplen, loadFlags);
+		if (res != MP_OK)
 		{
-			if (!module->loadSample(f,smp[i].sample,smp[i].samplen,smp[i].samplen,loadFlags))
-			{
-				return MP_OUT_OF_MEMORY;
-			}
+			return res;
 		}
 		
 	}	
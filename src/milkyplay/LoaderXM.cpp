@@ -83,7 +83,7 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 	
 	f.read(&header->sig,1,17);
 	f.read(&header->name,1,20);
-	f.read(&header->whythis1a,1,1);
+	header->whythis1a=(char)f.readByte();
 	header->whythis1a=0;
 	f.read(&header->tracker,1,20);
 	f.readWords(&header->ver,1);
@@ -142,7 +142,7 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 			
 			f.readDwords(&instr[y].size,1);
 			f.read(&instr[y].name,1,22);		
-			f.read(&instr[y].type,1,1);
+			instr[y].type=f.readByte();
 			mp_uword numSamples = 0;
 			f.readWords(&numSamples,1);
 			if(numSamples > MP_MAXINSSAMPS)
@@ -254,14 +254,14 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 					f.readDwords(&smp[g+s].looplen,1);
 					smp[g+s].vol=XModule::vol64to255(f.readByte());
 					//f.read(&smp[g+s].vol,1,1);
-					f.read(&smp[g+s].finetune,1,1);
-					f.read(&smp[g+s].type,1,1);
+					smp[g+s].finetune=(mp_sbyte)f.readByte();
+					smp[g+s].type=f.readByte();
 #ifdef VERBOSE
 					printf("Before: %i, After: %i\n", smp[g+s].type, smp[g+s].type & (3+16));
 #endif
-					f.read(&smp[g+s].pan,1,1);
-					f.read(&smp[g+s].relnote,1,1);
-					f.read(&smp[g+s].res,1,1);
+					smp[g+s].pan=f.readByte();
+					smp[g+s].relnote=(mp_sbyte)f.readByte();
+					smp[g+s].res=f.readByte();
 					f.read(&smp[g+s].name,1,22);
 					
 					char line[30];
@@ -322,14 +322,14 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 		if (header->ver == 0x104 || header->ver == 0x103)
 		{
 			f.readDwords(&phead[y].len,1);
-			f.read(&phead[y].ptype,1,1);
+			phead[y].ptype=f.readByte();
 			f.readWords(&phead[y].rows,1);
 			f.readWords(&phead[y].patdata,1);
 		}
 		else
 		{
 			f.readDwords(&phead[y].len,1);
-			f.read(&phead[y].ptype,1,1);
+			phead[y].ptype=f.readByte();
 			phead[y].rows = (mp_uword)f.readByte()+1;
 			f.readWords(&phead[y].patdata,1);			
 		}
@@ -490,7 +490,7 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 			else
 			{
 				f.read(&instr[y].name,1,22);		
-				f.read(&instr[y].type,1,1);
+				instr[y].type=f.readByte();
 				f.readWords(&instr[y].samp,1);
 			}
 			if (instr[y].samp > MP_MAXINSSAMPS)
@@ -622,14 +622,14 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 					f.readDwords(&smp[g+s].looplen,1);
 					smp[g+s].vol=XModule::vol64to255(f.readByte());
 					//f.read(&smp[g+s].vol,1,1);
-					f.read(&smp[g+s].finetune,1,1);
-					f.read(&smp[g+s].type,1,1);
+					smp[g+s].finetune=(mp_sbyte)f.readByte();
+					smp[g+s].type=f.readByte();
 #ifdef VERBOSE
 					printf("Before: %i, After: %i\n", smp[g+s].type, smp[g+s].type & (3+16));
 #endif
-					f.read(&smp[g+s].pan,1,1);
-					f.read(&smp[g+s].relnote,1,1);
-					f.read(&smp[g+s].res,1,1);
+					smp[g+s].pan=f.readByte();
+					smp[g+s].relnote=(mp_sbyte)f.readByte();
+					smp[g+s].res=f.readByte();
 					f.read(&smp[g+s].name,1,22);
 
 					char line[30];
@@ -748,6 +748,7 @@ mp_sint32 LoaderXM::load(XMFileBase& f, XModule* module)
 	}
 	
 	// convert modplug stereo samples
+	module->decodePendingSamples();
 	for (mp_sint32 s = 0; s < header->smpnum; s++)
 	{
 		if (smp[s].type & 32)
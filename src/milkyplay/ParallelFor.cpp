@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ParallelFor.cpp
+ *  MilkyPlay
+ *
+ */
+#include "ParallelFor.h"
+#include <functional>
+#include <thread>
+#include <vector>
+
+// a few blocks per thread so the progress moves and uneven blocks even out
+#define BLOCKSPERTHREAD 4
+
+ParallelFor::ParallelFor(mp_sint32 start, mp_sint32 end, mp_sint32 minBlockLength/* = 65536*/) :
+	start(start),
+	end(end),
+	nextBlock(0),
+	doneBlocks(0),
+	cancelled(false)
+{
+	mp_sint32 length = end > start ? end - start : 0;
+	mp_sint32 maxBlocks = getNumThreads() * BLOCKSPERTHREAD;
+
+	blockLength = (length + maxBlocks - 1) / maxBlocks;
+	if (blockLength < minBlockLength)
+		blockLength = minBlockLength;
+	if (blockLength < 1)
+		blockLength = 1;
+
+	numBlocks = (length + blockLength - 1) / blockLength;
+}
+
+mp_sint32 ParallelFor::getNumThreads()
+{
+	mp_sint32 numThreads = (mp_sint32)std::thread::hardware_concurrency();
+	return numThreads > 0 ? numThreads : 1;
+}
+
+void ParallelFor::work(Job& job)
+{
+	while (!cancelled)
+	{
+		mp_sint32 block = nextBlock++;
+		if (block >= numBlocks)
+			break;
+
+		job.process(block, getBlockStart(block), getBlockEnd(block));
+		doneBlocks++;
+	}
+}
+
+bool ParallelFor::runJob(Job& job)
+{
+	nextBlock = 0;
+	doneBlocks = 0;
+
+	mp_sint32 numThreads = getNumThreads();
+	if (numThreads > numBlocks)
+		numThreads = numBlocks;
+
+	// the calling thread takes blocks as well
+	std::vector<std::thread> threads;
+	for (mp_sint32 i = 1; i < numThreads; i++)
+		threads.push_back(std::thread(&ParallelFor::work, this, std::ref(job)));
+
+	work(job);
+
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	return doneBlocks == numBlocks;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  ParallelFor.h
+ *  MilkyPlay
+ *
+ *  Splits an index range into blocks and processes them on all cores
+ *
+ */
+#ifndef __PARALLELFOR_H__
+#define __PARALLELFOR_H__
+
+#include "MilkyPlayTypes.h"
+#include <atomic>
+
+class ParallelFor
+{
+public:
+	class Job
+	{
+	public:
+		virtual ~Job() {}
+
+		// called once for every block, from several threads at the same time
+		virtual void process(mp_sint32 block, mp_sint32 from, mp_sint32 to) = 0;
+	};
+
+private:
+	template<class Func>
+	class FuncJob : public Job
+	{
+	private:
+		Func& func;
+
+	public:
+		FuncJob(Func& func) : func(func) {}
+
+		virtual void process(mp_sint32 block, mp_sint32 from, mp_sint32 to) { func(block, from, to); }
+	};
+
+	mp_sint32 start;
+	mp_sint32 end;
+	mp_sint32 blockLength;
+	mp_sint32 numBlocks;
+
+	std::atomic<mp_sint32> nextBlock;
+	std::atomic<mp_sint32> doneBlocks;
+	std::atomic<bool> cancelled;
+
+	void work(Job& job);
+
+public:
+	// ranges shorter than minBlockLength are processed in one block on the calling thread
+	ParallelFor(mp_sint32 start, mp_sint32 end, mp_sint32 minBlockLength = 65536);
+
+	mp_sint32 getLength() const { return end > start ? end - start : 0; }
+	mp_sint32 getNumBlocks() const { return numBlocks; }
+	mp_sint32 getBlockStart(mp_sint32 block) const { return start + block * blockLength; }
+	mp_sint32 getBlockEnd(mp_sint32 block) const { return block == numBlocks - 1 ? end : getBlockStart(block + 1); }
+
+	// process all blocks, returns false when cancelled before all blocks were done
+	bool runJob(Job& job);
+
+	// same for a functor (or lambda) taking (block, from, to)
+	template<class Func>
+	bool run(Func func)
+	{
+		FuncJob<Func> job(func);
+		return runJob(job);
+	}
+
+	// these can be called from other threads while a run is busy,
+	// cancel() stops handing out blocks and affects the following runs as well
+	float getProgress() const { return numBlocks ? (float)doneBlocks / (float)numBlocks : 1.0f; }
+	void cancel() { cancelled = true; }
+	bool isCancelled() const { return cancelled; }
+
+	static mp_sint32 getNumThreads();
+};
+
+#endif
@@ -150,6 +150,24 @@ mp_sint32 PlayerBase::setBufferSize(mp_uint32 bufferSize)
 	return MP_OK;
 }
 
+mp_sint32 PlayerBase::setTimerFrequency(mp_uint32 timerFrequency)
+{
+	mp_uint32 lastNumBeatPackets = getNumBeatPackets()+1;
+
+	mp_sint32 res = ChannelMixer::setTimerFrequency(timerFrequency);
+	
+	if (res < 0)
+		return res;
+		
+	// nothing has changed
+	if (lastNumBeatPackets == getNumBeatPackets()+1)
+		return MP_OK;
+
+	reallocTimeRecord();
+	
+	return MP_OK;
+}
+
 void PlayerBase::restart(mp_uint32 startPosition/* = 0*/, mp_uint32 startRow/* = 0*/, bool resetMixer/* = true*/, const mp_ubyte* customPanningTable/* = NULL*/, bool playOneRowOnly /* = false*/)
 {
 	if (module == NULL) 
@@ -196,6 +196,7 @@ public:
 	
 	virtual mp_sint32 adjustFrequency(mp_uint32 frequency);
 	virtual mp_sint32 setBufferSize(mp_uint32 bufferSize);	
+	virtual mp_sint32 setTimerFrequency(mp_uint32 timerFrequency);
 	
 	void setPlayMode(PlayModes mode) { playMode = mode; }
 
@@ -277,10 +277,10 @@ void PlayerFAR::UpdateTempo(mp_sint32 tps)
 	di+=3;
 	OverFlow=di; OCount=di;
 	
-	// convert timer frequency into 250Hz base
+	// convert timer frequency into our mixer timer base (250Hz by default)
 	float t = (1197255.0f / (float)eax);
 	
-	t = 1.0f/(250.0f/t);
+	t = 1.0f/((float)getTimerFrequency()/t);
 	
 	// for tempo 0 we get a period that is slightly shorter than what we can
 	// do with 250Hz but the difference is very small so just correct it by
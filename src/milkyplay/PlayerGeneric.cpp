@@ -165,6 +165,8 @@ PlayerGeneric::PlayerGeneric(mp_sint32 frequency, AudioDriverInterface* audioDri
 	listener = new MixerNotificationListener(*this);
 
 	bufferSize = 0;
+	timerFrequency = ChannelMixer::MP_TIMERFREQ;
+	cpuBudget = 0;
 	sampleShift = 0;
 	
 	resamplerType = MIXER_NORMAL;
@@ -305,7 +307,7 @@ mp_sint32 PlayerGeneric::getMixFrequency() const
 
 mp_sint32 PlayerGeneric::beatPacketsToBufferSize(mp_uint32 numBeats)
 {
-	return ChannelMixer::beatPacketsToBufferSize(getMixFrequency(), numBeats);
+	return ChannelMixer::beatPacketsToBufferSize(getMixFrequency(), numBeats, getTimerFrequency());
 }
 
 mp_sint32 PlayerGeneric::adjustBufferSize(mp_uint32 numBeats)
@@ -341,6 +343,29 @@ mp_sint32 PlayerGeneric::setBufferSize(mp_uint32 bufferSize)
 	return res;
 }
 	
+mp_sint32 PlayerGeneric::setTimerFrequency(mp_uint32 timerFrequency)
+{
+	this->timerFrequency = timerFrequency;
+	
+	if (player)
+	{
+		mp_sint32 res = player->setTimerFrequency(timerFrequency);
+		// might have been clamped
+		this->timerFrequency = player->getTimerFrequency();
+		return res;
+	}
+	
+	return MP_OK;
+}
+
+mp_uint32 PlayerGeneric::getTimerFrequency() const
+{
+	if (player)
+		return player->getTimerFrequency();
+		
+	return timerFrequency;
+}
+
 mp_sint32 PlayerGeneric::setPowerOfTwoCompensationFlag(bool b)
 {
 	if (mixer && compensateBufferFlag != b)
@@ -575,7 +600,9 @@ mp_sint32 PlayerGeneric::startPlaying(XModule* module,
 			// apply our own "state" to the state of the newly allocated player
 			player->resetMainVolumeOnStartPlay(resetMainVolumeOnStartPlayFlag);
 			player->resetOnStop(resetOnStopFlag);
+			player->setTimerFrequency(timerFrequency);
 			player->setBufferSize(bufferSize);
+			player->setCPUBudget(cpuBudget);
 			player->setResamplerType(resamplerType);
 			player->setMasterVolume(masterVolume);
 			player->setPanningSeparation(panningSeparation);
@@ -965,6 +992,7 @@ mp_sint32 PlayerGeneric::exportToWAV(const SYSCHAR* fileName, XModule* module,
 	{
 		player->adjustFrequency(frequency);
 		player->resetOnStop(resetOnStopFlag);
+		player->setTimerFrequency(timerFrequency);
 		player->setBufferSize(bufferSize);
 		player->setResamplerType(resamplerType);
 		player->setMasterVolume(masterVolume);
@@ -1082,6 +1110,21 @@ mp_sint32 PlayerGeneric::getNumMaxVirChannels() const
 	return numMaxVirChannels;
 }
 
+void PlayerGeneric::setCPUBudget(mp_uint32 percent)
+{
+	cpuBudget = percent;
+	if (player)
+		player->setCPUBudget(percent);
+}
+
+mp_uint32 PlayerGeneric::getMixerLoad() const
+{
+	if (player)
+		return player->getMixerLoad();
+	
+	return 0;
+}
+
 // milkytracker
 void PlayerGeneric::setPanning(mp_ubyte chn, mp_ubyte pan)
 {
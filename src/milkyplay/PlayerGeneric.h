@@ -74,6 +74,10 @@ private:
 	AudioDriverInterface*	audioDriver;
 	// remember buffersize
 	mp_uint32			bufferSize;
+	// remember mixer timer frequency
+	mp_uint32			timerFrequency;
+	// remember CPU budget for live playback
+	mp_uint32			cpuBudget;
 	// remember sample shift
 	mp_uint32			sampleShift;
 	// this flag indicates if audiodriver tries to compensate for 2^n buffer sizes
@@ -207,8 +211,9 @@ public:
 	
 	/**
 	 * Convert number of beat backets to buffer size:
-	 * The ChannelMixer class uses a fixed 250Hz timer so the mixer size is
-	 * always a multiple of CurrentOutputFrequency / 250
+	 * The ChannelMixer class uses a 250Hz timer (unless specified otherwise 
+	 * by setTimerFrequency) so the mixer size is always a multiple of 
+	 * CurrentOutputFrequency / 250
 	 * E.g. if you're mixing at 44100Hz the buffer size is always a multiple
 	 * of 176 samples. 
 	 * Thus specifying a value of 10 will result in a buffer of 1760 samples size.
@@ -237,6 +242,24 @@ public:
 	 */
 	mp_sint32			setBufferSize(mp_uint32 bufferSize);
 
+	/**
+	 * Set the frequency of the mixer timer (default is 250Hz)
+	 * The song is processed in packets of 1/timerFrequency seconds:
+	 * Higher values give more precise effect timing and shorter volume ramps,
+	 * lower values reduce the per packet overhead (e.g. for offline rendering)
+	 * Important: Changing the timer frequency while playing will stop the song
+	 *
+	 * @param  timerFrequency	timer frequency in Hz (ChannelMixer::MP_TIMERFREQ_MIN to MP_TIMERFREQ_MAX)
+	 */
+	mp_sint32			setTimerFrequency(mp_uint32 timerFrequency);
+
+	/**
+	 * Get the current frequency of the mixer timer
+	 * @return			timer frequency in Hz
+	 * @see				setTimerFrequency
+	 */
+	mp_uint32			getTimerFrequency() const;
+
 	/**
 	 * Tell the sound driver to force forcing 2^n buffer blocks if possible
 	 * @param  b		true or false
@@ -683,6 +706,31 @@ public:
 	 */
 	mp_sint32			getNumMaxVirChannels() const;
 
+	/**
+	 * Limit the processing time of the player while playing (not while exporting).
+	 * The mixer measures how long it takes to process each beat packet, if this
+	 * exceeds the given percentage of the beat packet duration, players using
+	 * virtual channels (like PlayerIT) will drop the quietest background voices
+	 * until the load is back within budget instead of underrunning the audio device.
+	 *
+	 * @param  percent	allowed processing time in percent of real time (0 = unlimited, default)
+	 */
+	void				setCPUBudget(mp_uint32 percent);
+
+	/**
+	 * Return the CPU budget
+	 * @return			allowed processing time in percent of real time (0 = unlimited)
+	 * @see				setCPUBudget
+	 */
+	mp_uint32			getCPUBudget() const { return cpuBudget; }
+
+	/**
+	 * Return the measured processing time of the player (only available if a CPU budget is set)
+	 * @return			processing time in percent of real time
+	 * @see				setCPUBudget
+	 */
+	mp_uint32			getMixerLoad() const;
+
 	// ---------------------------- milkytracker ----------------------------
 	/**
 	 * Change panning of a current playing channel
@@ -286,6 +286,14 @@ PlayerIT::PlayerIT(mp_uint32 frequency) :
 	chninfo		= NULL;
 	vchninfo	= NULL;
 	attick		= NULL;	
+	
+	vchnFreeMask	= NULL;
+	vchnHeap		= NULL;
+	vchnHeapPos		= NULL;
+	vchnHeapVol		= NULL;
+	vchnHeapSize	= 0;
+	numBudgetVirChannels = -1;
+
 	// fill in some default values, don't know if this is necessary
 
 	tickSpeed			= 6;				// our tickspeed
@@ -337,6 +345,11 @@ void PlayerIT::timerHandler(mp_sint32 currentBeatPacket)
 	if (module->header.flags & XModule::MODULE_AMSENVELOPES)
 		updateBPMIndependent();
 	
+	if (getCPUBudget())
+		applyCPUBudget();
+	else
+		numBudgetVirChannels = -1;
+	
 	// if the new maximum of virtual channels is greater than the old one
 	// set it to the new one, else keep the old one, because if some channels were
 	// cut by stopSample() the mixer needs to shut these off
@@ -425,6 +438,8 @@ void PlayerIT::reset()
 	curMaxVirChannels = 0;
 	memset(chninfo, 0, sizeof(TModuleChannel)*numModuleChannels);
 	memset(vchninfo, 0, sizeof(TVirtualChannel)*numVirtualChannels);
+	resetVirtualChannelAllocation();
+	numBudgetVirChannels = -1;
 	RESET_ALL_LOOPING
 }
 
@@ -444,6 +459,11 @@ mp_sint32 PlayerIT::allocateStructures()
 	chninfo			= new TModuleChannel[numModuleChannels];
 	vchninfo		= new TVirtualChannel[numVirtualChannels];
 	attick			= new mp_ubyte[numModuleChannels];
+
+	vchnFreeMask	= new mp_uint32[(numVirtualChannels+31) >> 5];
+	vchnHeap		= new mp_sint32[numVirtualChannels];
+	vchnHeapPos		= new mp_sint32[numVirtualChannels];
+	vchnHeapVol		= new mp_sint32[numVirtualChannels];
 	return MP_OK;
 }
 
@@ -464,6 +484,16 @@ void PlayerIT::freeMemory()
 		delete[] attick; 
 		attick = NULL; 
 	}
+	
+	delete[] vchnFreeMask;
+	vchnFreeMask = NULL;
+	delete[] vchnHeap;
+	vchnHeap = NULL;
+	delete[] vchnHeapPos;
+	vchnHeapPos = NULL;
+	delete[] vchnHeapVol;
+	vchnHeapVol = NULL;
+	vchnHeapSize = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////
@@ -500,53 +530,183 @@ void PlayerIT::clearEffectMemory()
 		visitRow(poscnt*256+i);
 }
 
-PlayerIT::TVirtualChannel* PlayerIT::allocateVirtualChannel()
+void PlayerIT::resetVirtualChannelAllocation()
 {
-	const mp_sint32 numVirtualChannels = this->numVirtualChannels;
-	
-	mp_sint32 i;
+	if (vchnFreeMask == NULL)
+		return;
 
-	TVirtualChannel* vchn = vchninfo;	
-	for (i = 0; i < numVirtualChannels; i++, vchn++)
+	// all virtual channels are in background and inactive => free
+	const mp_sint32 numWords = (numVirtualChannels+31) >> 5;
+	for (mp_sint32 i = 0; i < numWords; i++)
+		vchnFreeMask[i] = 0xFFFFFFFF;
+	if (numVirtualChannels & 31)
+		vchnFreeMask[numWords-1] = (1U << (numVirtualChannels & 31)) - 1;
+
+	for (mp_sint32 i = 0; i < numVirtualChannels; i++)
+		vchnHeapPos[i] = -1;
+	vchnHeapSize = 0;
+}
+
+void PlayerIT::vchnHeapSiftUp(mp_sint32 pos)
+{
+	const mp_sint32 index = vchnHeap[pos];
+	while (pos > 0)
 	{
-		if (vchn->getBackground())
+		mp_sint32 parent = (pos-1) >> 1;
+		if (!vchnHeapLess(index, vchnHeap[parent]))
+			break;
+		vchnHeap[pos] = vchnHeap[parent];
+		vchnHeapPos[vchnHeap[pos]] = pos;
+		pos = parent;
+	}
+	vchnHeap[pos] = index;
+	vchnHeapPos[index] = pos;
+}
+
+void PlayerIT::vchnHeapSiftDown(mp_sint32 pos)
+{
+	const mp_sint32 index = vchnHeap[pos];
+	for (;;)
+	{
+		mp_sint32 child = (pos << 1) + 1;
+		if (child >= vchnHeapSize)
+			break;
+		if (child+1 < vchnHeapSize && vchnHeapLess(vchnHeap[child+1], vchnHeap[child]))
+			child++;
+		if (!vchnHeapLess(vchnHeap[child], index))
+			break;
+		vchnHeap[pos] = vchnHeap[child];
+		vchnHeapPos[vchnHeap[pos]] = pos;
+		pos = child;
+	}
+	vchnHeap[pos] = index;
+	vchnHeapPos[index] = pos;
+}
+
+void PlayerIT::updateVirtualChannelAllocation(TVirtualChannel* vchn)
+{
+	const mp_sint32 i = (mp_sint32)(vchn - vchninfo);
+	const bool background = vchn->getBackground();
+	const bool active = vchn->getActive();
+
+	if (background && !active)
+		vchnFreeMask[i >> 5] |= (1U << (i & 31));
+	else
+		vchnFreeMask[i >> 5] &= ~(1U << (i & 31));
+	
+	mp_sint32 pos = vchnHeapPos[i];
+	
+	// active background channels can be stolen
+	if (background && active)
+	{
+		mp_sint32 vol = vchn->getResultingVolume();
+		if (pos < 0)
 		{
-			if (!vchn->getActive())
-			{
-				if (i+1 > curMaxVirChannels)
-					curMaxVirChannels = i+1;
-				vchn->setChannelIndex(i);
-				return vchn;
-			}
+			vchnHeapVol[i] = vol;
+			vchnHeap[vchnHeapSize] = i;
+			vchnHeapSiftUp(vchnHeapSize++);
+		}
+		else if (vol != vchnHeapVol[i])
+		{
+			mp_sint32 oldVol = vchnHeapVol[i];
+			vchnHeapVol[i] = vol;
+			if (vol < oldVol)
+				vchnHeapSiftUp(pos);
+			else
+				vchnHeapSiftDown(pos);
+		}
+	}
+	else if (pos >= 0)
+	{
+		vchnHeapPos[i] = -1;
+		mp_sint32 last = vchnHeap[--vchnHeapSize];
+		if (last != i)
+		{
+			vchnHeap[pos] = last;
+			vchnHeapPos[last] = pos;
+			vchnHeapSiftUp(pos);
+			vchnHeapSiftDown(vchnHeapPos[last]);
 		}
 	}
+}
+
+PlayerIT::TVirtualChannel* PlayerIT::allocateVirtualChannel()
+{
+	const mp_sint32 numWords = (numVirtualChannels+31) >> 5;
 	
-	mp_sint32 chnIndex = -1;
-	mp_sint32 vol = 0x7FFFFFFF;
-	vchn = vchninfo;	
-	for (i = 0; i < curMaxVirChannels; i++, vchn++)
+	// over CPU budget => don't add more background channels, 
+	// reuse the quietest one instead (handleNNAs() cuts the old note 
+	// when the limit is 0)
+	if (numBudgetVirChannels >= 0 && vchnHeapSize && vchnHeapSize >= numBudgetVirChannels)
 	{
-		if (vchn->getBackground())
+		mp_sint32 i = vchnHeap[0];
+		TVirtualChannel* vchn = vchninfo + i;
+		vchn->setChannelIndex(i);
+		return vchn;
+	}
+
+	// take the free channel with the lowest index
+	for (mp_sint32 w = 0; w < numWords; w++)
+	{
+		mp_uint32 mask = vchnFreeMask[w];
+		if (!mask)
+			continue;
+			
+		mp_sint32 i = w << 5;
+#ifdef __GNUC__
+		i += __builtin_ctz(mask);
+#else
+		while (!(mask & 1))
 		{
-			mp_sint32 newVol = vchn->getResultingVolume();
-			if (newVol < vol)
-			{
-				vol = newVol;
-				chnIndex = i;
-			}
+			mask >>= 1;
+			i++;
 		}
+#endif
+		if (i+1 > curMaxVirChannels)
+			curMaxVirChannels = i+1;
+		TVirtualChannel* vchn = vchninfo + i;
+		vchn->setChannelIndex(i);
+		return vchn;
 	}
 	
-	if (chnIndex != -1)
+	// none left, steal the quietest background channel
+	if (vchnHeapSize)
 	{
-		vchn = vchninfo + chnIndex;
-		vchn->setChannelIndex(chnIndex);
+		mp_sint32 i = vchnHeap[0];
+		TVirtualChannel* vchn = vchninfo + i;
+		vchn->setChannelIndex(i);
 		return vchn;
 	}
 	
 	return NULL;
 }
 
+void PlayerIT::applyCPUBudget()
+{
+	const mp_uint32 budget = getCPUBudget();
+	const mp_uint32 load = getMixerLoad();
+	
+	if (load > budget)
+	{
+		// the load is measured again for every beat packet, so drop one voice
+		// at a time instead of guessing how many are needed to get back into budget
+		if (vchnHeapSize)
+		{
+			TVirtualChannel* vchn = vchninfo + vchnHeap[0];
+			stopSample(vchn->getChannelIndex());
+			releaseVirtualChannel(vchn);
+		}
+		
+		numBudgetVirChannels = vchnHeapSize;
+	}
+	// well below budget again => slowly allow more background channels
+	else if (numBudgetVirChannels >= 0 && load < (budget*3) >> 2)
+	{
+		if (++numBudgetVirChannels >= numVirtualChannels)
+			numBudgetVirChannels = -1;
+	}
+}
+
 void PlayerIT::handleNoteOFF(TChnState& state)
 {
 	const mp_sint32 ins = state.getIns();
@@ -604,7 +764,10 @@ void PlayerIT::handlePastNoteAction(TModuleChannel* chnInf, mp_ubyte pastNoteAct
 		{
 			for (mp_sint32 i = 0; i < curMaxVirChannels; i++, vchn++)
 				if (vchn->getActive() && (vchn->getOldHost() == chnInf))
+				{
 					handleNoteOFF(vchn->getRealState());
+					updateVirtualChannelAllocation(vchn);
+				}
 			break;
 		}
 
@@ -664,14 +827,18 @@ bool PlayerIT::handleDCT(TModuleChannel* chnInf, const TNNATriggerInfo& triggerI
 			{
 				// virtual channel is no longer linked to host
 				if (vchn->getOldHost() == chnInf)
+				{
 					handleNoteOFF(vchn->getRealState());
+					updateVirtualChannelAllocation(vchn);
+				}
 				// virtual channel is linked to host, unlink and handle note off
 				else
 				{
 					// important: first set host to NULL
 					// THEN set key on flag
-					TVirtualChannel* oldvchn = chnInf->unlinkVchn();
+					TVirtualChannel* oldvchn = unlinkVirtualChannel(chnInf);
 					handleNoteOFF(oldvchn->getRealState());
+					updateVirtualChannelAllocation(oldvchn);
 				}
 			}
 			// note fade
@@ -685,7 +852,7 @@ bool PlayerIT::handleDCT(TModuleChannel* chnInf, const TNNATriggerInfo& triggerI
 				{
 					// important: first set host to NULL
 					// THEN set fade out
-					chnInf->unlinkVchn()->setFadeout(true);
+					unlinkVirtualChannel(chnInf)->setFadeout(true);
 				}
 			}
 		}
@@ -729,6 +896,11 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 	mp_ubyte DCT = (insflags>>6) & 3;
 	mp_ubyte DCA = (insflags>>8) & 3;
 	
+	// over CPU budget with no background channels allowed at all
+	// => the old note would become one, cut it instead
+	if (numBudgetVirChannels == 0)
+		NNA = 0;
+	
 	if (DCT)
 	{
 		if (!handleDCT(chnInf, triggerInfo, DCT, DCA))
@@ -744,8 +916,8 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 		// NNA = continue
 		else if (NNA == 1)
 		{
-			chnInf->unlinkVchn();			
-			chnInf->linkVchn(newVchn);
+			unlinkVirtualChannel(chnInf);
+			linkVirtualChannel(chnInf, newVchn);
 			return true;
 		}
 		// NNA = note off
@@ -753,9 +925,10 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 		{
 			// important: first set host to NULL
 			// THEN set key on flag
-			TVirtualChannel* oldvchn = chnInf->unlinkVchn();
+			TVirtualChannel* oldvchn = unlinkVirtualChannel(chnInf);
 			handleNoteOFF(oldvchn->getRealState());
-			chnInf->linkVchn(newVchn);
+			updateVirtualChannelAllocation(oldvchn);
+			linkVirtualChannel(chnInf, newVchn);
 			return true;
 		}
 		// NNA = note fade
@@ -763,14 +936,14 @@ bool PlayerIT::handleNNAs(TModuleChannel* chnInf, const TNNATriggerInfo& trigger
 		{
 			// important: first set host to NULL
 			// THEN set fade out
-			chnInf->unlinkVchn()->setFadeout(true);
-			chnInf->linkVchn(newVchn);
+			unlinkVirtualChannel(chnInf)->setFadeout(true);
+			linkVirtualChannel(chnInf, newVchn);
 			return true;
 		}
 	}
 	else
 	{
-		chnInf->linkVchn(newVchn);
+		linkVirtualChannel(chnInf, newVchn);
 	}	
 	
 	return true;
@@ -3416,6 +3589,10 @@ void PlayerIT::update()
 				chn->decFadevolstart();
 			}
 		}
+		
+		// fading changes the order in which background channels are stolen
+		if (chn->getBackground())
+			updateVirtualChannelAllocation(chn);
 			
 		if (chn->getAvibused()) 
 		{
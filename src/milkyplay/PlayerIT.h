@@ -465,6 +465,17 @@ private:
 	TModuleChannel	*chninfo;				// our channel information
 	TVirtualChannel *vchninfo;				// our virtual channels
 	
+	// virtual channel allocation: 
+	// background channels which are not active can be allocated right away,
+	// if there is none left the quietest active background channel is stolen
+	mp_uint32		*vchnFreeMask;			// bit set = virtual channel can be allocated
+	mp_sint32		*vchnHeap;				// min-heap of active background channels (ordered by volume, index)
+	mp_sint32		*vchnHeapPos;			// position of each virtual channel within the heap (-1 = not in heap)
+	mp_sint32		*vchnHeapVol;			// volume the heap is sorted by
+	mp_sint32		vchnHeapSize;
+	
+	mp_sint32		numBudgetVirChannels;	// limit for background channels while over CPU budget (-1 = no limit)
+	
 	mp_ubyte		*attick;
 	
 	mp_sint32		patternIndex;			// holds current pattern index
@@ -518,7 +529,36 @@ private:
 		vchn->setActive(false);
 		if (vchn->getChannelIndex() == curMaxVirChannels-1)
 			curMaxVirChannels--;
+		updateVirtualChannelAllocation(vchn);
 	}
+	
+	void				linkVirtualChannel(TModuleChannel* chnInf, TVirtualChannel* vchn)
+	{
+		chnInf->linkVchn(vchn);
+		updateVirtualChannelAllocation(vchn);
+	}
+	
+	TVirtualChannel*	unlinkVirtualChannel(TModuleChannel* chnInf)
+	{
+		TVirtualChannel* vchn = chnInf->unlinkVchn();
+		updateVirtualChannelAllocation(vchn);
+		return vchn;
+	}
+	
+	// must be called whenever the active/background state or the resulting 
+	// volume of a background channel changes
+	void				updateVirtualChannelAllocation(TVirtualChannel* vchn);
+	void				resetVirtualChannelAllocation();
+	
+	bool				vchnHeapLess(mp_sint32 a, mp_sint32 b) const
+	{
+		return vchnHeapVol[a] < vchnHeapVol[b] || (vchnHeapVol[a] == vchnHeapVol[b] && a < b);
+	}
+	void				vchnHeapSiftUp(mp_sint32 pos);
+	void				vchnHeapSiftDown(mp_sint32 pos);
+	
+	// drop the quietest background channels while the mixer is over its CPU budget
+	void				applyCPUBudget();
 		
 	struct TNNATriggerInfo
 	{
@@ -557,7 +597,7 @@ private:
 		
 		mp_int64 t = ((mp_int64)realCiaTempo)<<(32+2);
 		
-		const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(MP_BEATLENGTH*MP_TIMERFREQ / (float)MP_BASEFREQ));
+		const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(getTimerFrequency() / (float)MP_TIMERFREQ));
 		
 		return (mp_uint32)(t/timerBase);
 	}
@@ -278,6 +278,24 @@ mp_sint32 PlayerSTD::setBufferSize(mp_uint32 bufferSize)
 	return res;
 }
 
+mp_sint32 PlayerSTD::setTimerFrequency(mp_uint32 timerFrequency)
+{
+	mp_uint32 lastNumBeatPackets = getNumBeatPackets()+1;
+
+	mp_sint32 res = PlayerBase::setTimerFrequency(timerFrequency);
+	
+	if (res < 0)
+		return res;
+		
+	// nothing has changed
+	if (lastNumBeatPackets == getNumBeatPackets()+1)
+		return MP_OK;
+
+	res = allocateStructures();
+	
+	return res;
+}
+
 void PlayerSTD::timerHandler(mp_sint32 currentBeatPacket)
 {
 	PlayerBase::timerHandler(currentBeatPacket);
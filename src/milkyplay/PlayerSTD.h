@@ -323,7 +323,7 @@ private:
 		
 		mp_int64 t = ((mp_int64)realCiaTempo)<<(32+2);
 		
-		const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(MP_BEATLENGTH*MP_TIMERFREQ / (float)MP_BASEFREQ));
+		const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(getTimerFrequency() / (float)MP_TIMERFREQ));
 		
 		return (mp_uint32)(t/timerBase);
 	}
@@ -456,6 +456,7 @@ public:
 
 	virtual mp_sint32 adjustFrequency(mp_uint32 frequency);
 	virtual mp_sint32 setBufferSize(mp_uint32 bufferSize);	
+	virtual mp_sint32 setTimerFrequency(mp_uint32 timerFrequency);
 	
 	// virtual from mixer class, perform playing here
 	virtual void	timerHandler(mp_sint32 currentBeatPacket);
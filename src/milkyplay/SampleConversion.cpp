@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  SampleConversion.cpp
+ *  MilkyPlay
+ *
+ */
+#include "SampleConversion.h"
+#include <string.h>
+
+// values decoded in one go, enough to keep the loops busy and small enough for the stack
+#define BLOCKSIZE	2048
+
+// All loops below are kept free of branches on the format so the
+// compiler can vectorize them, the switches only pick the loop.
+// Values are handled in 16 bit range, 8 bit sample data is shifted on store.
+
+static inline mp_sint32 readSigned16LE(const mp_ubyte* src)
+{
+	return (mp_sword)(src[0] | (src[1] << 8));
+}
+
+static inline mp_sint32 readSigned16BE(const mp_ubyte* src)
+{
+	return (mp_sword)((src[0] << 8) | src[1]);
+}
+
+static inline mp_uint32 readDword(const mp_ubyte* src, bool bigEndian)
+{
+	return bigEndian ? 
+		((mp_uint32)src[0] << 24) | ((mp_uint32)src[1] << 16) | ((mp_uint32)src[2] << 8) | src[3] :
+		((mp_uint32)src[3] << 24) | ((mp_uint32)src[2] << 16) | ((mp_uint32)src[1] << 8) | src[0];
+}
+
+// triangular noise of +-1 LSB from a hash of the position, no state to carry
+// from one call to the next and the same file always loads the same
+static inline float ditherNoise(mp_uint32 position)
+{
+	mp_uint32 h = position * 0x9E3779B1;
+	h ^= h >> 15;
+	h *= 0x85EBCA77;
+	h ^= h >> 13;
+	return (float)((mp_sint32)(h & 0xFFFF) + (mp_sint32)(h >> 16) - 65535) * (1.0f/65536.0f);
+}
+
+static void decodeFloats(const mp_ubyte* src, mp_sint32* dest, mp_uint32 count, bool bigEndian, mp_uint32 position)
+{
+	for (mp_uint32 i = 0; i < count; i++)
+	{
+		mp_uint32 dw = readDword(src + i*4, bigEndian);
+		float f;
+		memcpy(&f, &dw, sizeof(f));
+		f = f > 1.0f ? 1.0f : (f < -1.0f ? -1.0f : f);
+		// rounding by truncating a positive value
+		mp_sint32 v = (mp_sint32)(f*32767.0f + ditherNoise(position + i) + 32768.5f) - 32768;
+		dest[i] = v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+	}
+}
+
+static void decodeValues(const mp_ubyte* src, SampleConversion::Formats format, mp_sint32* dest, mp_uint32 count, mp_uint32 position)
+{
+	mp_uint32 i;
+	switch (format)
+	{
+		case SampleConversion::FormatUnsigned8:
+			for (i = 0; i < count; i++)
+				dest[i] = ((mp_sint32)src[i] - 128) << 8;
+			break;
+		case SampleConversion::FormatSigned8:
+			for (i = 0; i < count; i++)
+				dest[i] = (mp_sint32)(mp_sbyte)src[i] << 8;
+			break;
+		case SampleConversion::FormatSigned16LE:
+			for (i = 0; i < count; i++)
+				dest[i] = readSigned16LE(src + i*2);
+			break;
+		case SampleConversion::FormatSigned16BE:
+			for (i = 0; i < count; i++)
+				dest[i] = readSigned16BE(src + i*2);
+			break;
+		// only the upper 16 bits are kept
+		case SampleConversion::FormatSigned24LE:
+			for (i = 0; i < count; i++)
+				dest[i] = readSigned16LE(src + i*3 + 1);
+			break;
+		case SampleConversion::FormatSigned24BE:
+			for (i = 0; i < count; i++)
+				dest[i] = readSigned16BE(src + i*3);
+			break;
+		case SampleConversion::FormatSigned32LE:
+			for (i = 0; i < count; i++)
+				dest[i] = readSigned16LE(src + i*4 + 2);
+			break;
+		case SampleConversion::FormatSigned32BE:
+			for (i = 0; i < count; i++)
+				dest[i] = readSigned16BE(src + i*4);
+			break;
+		case SampleConversion::FormatFloat32LE:
+			decodeFloats(src, dest, count, false, position);
+			break;
+		case SampleConversion::FormatFloat32BE:
+			decodeFloats(src, dest, count, true, position);
+			break;
+	}
+}
+
+static void selectChannel(mp_sint32* values, mp_uint32 numFrames, mp_uint32 numChannels, mp_sint32 channelIndex)
+{
+	mp_uint32 i;
+	if (channelIndex >= 0)
+	{
+		for (i = 0; i < numFrames; i++)
+			values[i] = values[i*numChannels + channelIndex];
+	}
+	else if (numChannels == 2)
+	{
+		for (i = 0; i < numFrames; i++)
+			values[i] = (values[i*2] + values[i*2+1]) >> 1;
+	}
+	else
+	{
+		for (i = 0; i < numFrames; i++)
+		{
+			mp_sint32 sum = 0;
+			for (mp_uint32 c = 0; c < numChannels; c++)
+				sum += values[i*numChannels + c];
+			values[i] = sum / (mp_sint32)numChannels;
+		}
+	}
+}
+
+mp_uint32 SampleConversion::getBytesPerSample(Formats format)
+{
+	switch (format)
+	{
+		case FormatUnsigned8:
+		case FormatSigned8:
+			return 1;
+		case FormatSigned16LE:
+		case FormatSigned16BE:
+			return 2;
+		case FormatSigned24LE:
+		case FormatSigned24BE:
+			return 3;
+		default:
+			return 4;
+	}
+}
+
+void SampleConversion::decode(const void* src, Formats format, mp_uint32 numChannels, mp_sint32 channelIndex,
+							  void* dest, bool dest16Bit, mp_uint32 numFrames, mp_uint32 position/* = 0*/)
+{
+	if (numChannels == 0)
+		return;
+	if (channelIndex >= (mp_sint32)numChannels)
+		channelIndex = 0;
+
+	mp_sint32 values[BLOCKSIZE];
+	const mp_uint32 blockFrames = BLOCKSIZE / numChannels;
+	const mp_uint32 frameSize = getBytesPerSample(format) * numChannels;
+
+	const mp_ubyte* srcPtr = (const mp_ubyte*)src;
+	for (mp_uint32 offset = 0; offset < numFrames; offset+=blockFrames)
+	{
+		mp_uint32 count = numFrames - offset;
+		if (count > blockFrames)
+			count = blockFrames;
+
+		decodeValues(srcPtr + offset*frameSize, format, values, count*numChannels, (position + offset)*numChannels);
+
+		if (numChannels > 1)
+			selectChannel(values, count, numChannels, channelIndex);
+
+		mp_uint32 i;
+		if (dest16Bit)
+		{
+			mp_sword* dst = (mp_sword*)dest + offset;
+			for (i = 0; i < count; i++)
+				dst[i] = (mp_sword)values[i];
+		}
+		else
+		{
+			mp_sbyte* dst = (mp_sbyte*)dest + offset;
+			for (i = 0; i < count; i++)
+				dst[i] = (mp_sbyte)(values[i] >> 8);
+		}
+	}
+}
+
+void SampleConversion::encode(const void* src, bool src16Bit, void* dest, Formats format, mp_uint32 count)
+{
+	mp_sint32 values[BLOCKSIZE];
+
+	mp_ubyte* dstPtr = (mp_ubyte*)dest;
+	for (mp_uint32 offset = 0; offset < count; offset+=BLOCKSIZE)
+	{
+		mp_uint32 num = count - offset;
+		if (num > BLOCKSIZE)
+			num = BLOCKSIZE;
+
+		mp_uint32 i;
+		if (src16Bit)
+		{
+			const mp_sword* srcPtr = (const mp_sword*)src + offset;
+			for (i = 0; i < num; i++)
+				values[i] = srcPtr[i];
+		}
+		else
+		{
+			const mp_sbyte* srcPtr = (const mp_sbyte*)src + offset;
+			for (i = 0; i < num; i++)
+				values[i] = (mp_sint32)srcPtr[i] << 8;
+		}
+
+		mp_ubyte* dst = dstPtr + offset*getBytesPerSample(format);
+		switch (format)
+		{
+			case FormatUnsigned8:
+				for (i = 0; i < num; i++)
+					dst[i] = (mp_ubyte)((values[i] >> 8) + 128);
+				break;
+			case FormatSigned8:
+				for (i = 0; i < num; i++)
+					dst[i] = (mp_ubyte)(values[i] >> 8);
+				break;
+			case FormatSigned16LE:
+				for (i = 0; i < num; i++)
+				{
+					dst[i*2] = (mp_ubyte)values[i];
+					dst[i*2+1] = (mp_ubyte)(values[i] >> 8);
+				}
+				break;
+			case FormatSigned16BE:
+				for (i = 0; i < num; i++)
+				{
+					dst[i*2] = (mp_ubyte)(values[i] >> 8);
+					dst[i*2+1] = (mp_ubyte)values[i];
+				}
+				break;
+			case FormatSigned24LE:
+				for (i = 0; i < num; i++)
+				{
+					dst[i*3] = 0;
+					dst[i*3+1] = (mp_ubyte)values[i];
+					dst[i*3+2] = (mp_ubyte)(values[i] >> 8);
+				}
+				break;
+			case FormatSigned24BE:
+				for (i = 0; i < num; i++)
+				{
+					dst[i*3] = (mp_ubyte)(values[i] >> 8);
+					dst[i*3+1] = (mp_ubyte)values[i];
+					dst[i*3+2] = 0;
+				}
+				break;
+			case FormatSigned32LE:
+				for (i = 0; i < num; i++)
+				{
+					dst[i*4] = dst[i*4+1] = 0;
+					dst[i*4+2] = (mp_ubyte)values[i];
+					dst[i*4+3] = (mp_ubyte)(values[i] >> 8);
+				}
+				break;
+			case FormatSigned32BE:
+				for (i = 0; i < num; i++)
+				{
+					dst[i*4] = (mp_ubyte)(values[i] >> 8);
+					dst[i*4+1] = (mp_ubyte)values[i];
+					dst[i*4+2] = dst[i*4+3] = 0;
+				}
+				break;
+			case FormatFloat32LE:
+			case FormatFloat32BE:
+				for (i = 0; i < num; i++)
+				{
+					float f = (float)values[i] * (values[i] > 0 ? 1.0f/32767.0f : 1.0f/32768.0f);
+					mp_uint32 dw;
+					memcpy(&dw, &f, sizeof(dw));
+					if (format == FormatFloat32BE)
+						dw = (dw >> 24) | ((dw >> 8) & 0xFF00) | ((dw << 8) & 0xFF0000) | (dw << 24);
+					memcpy(dst + i*4, &dw, sizeof(dw));
+				}
+				break;
+		}
+	}
+}
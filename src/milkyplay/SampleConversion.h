@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  SampleConversion.h
+ *  MilkyPlay
+ *
+ *  Converts sample data between file formats and 8/16 bit sample memory
+ *
+ */
+#ifndef __SAMPLECONVERSION_H__
+#define __SAMPLECONVERSION_H__
+
+#include "MilkyPlayTypes.h"
+
+class SampleConversion
+{
+public:
+	enum Formats
+	{
+		FormatUnsigned8,
+		FormatSigned8,
+		FormatSigned16LE,
+		FormatSigned16BE,
+		FormatSigned24LE,
+		FormatSigned24BE,
+		FormatSigned32LE,
+		FormatSigned32BE,
+		FormatFloat32LE,
+		FormatFloat32BE
+	};
+
+	static mp_uint32 getBytesPerSample(Formats format);
+
+	// convert numFrames interleaved frames of numChannels channels into
+	// 8 bit or 16 bit sample data, channelIndex < 0 mixes all channels down
+	// formats with more than 16 bits are cut down, floats are clipped and dithered
+	// position counts the frames converted so far, the dither noise depends on it
+	static void decode(const void* src, Formats format, mp_uint32 numChannels, mp_sint32 channelIndex,
+					   void* dest, bool dest16Bit, mp_uint32 numFrames, mp_uint32 position = 0);
+
+	// convert count values of 8 bit or 16 bit sample data into a file format
+	static void encode(const void* src, bool src16Bit, void* dest, Formats format, mp_uint32 count);
+};
+
+#endif
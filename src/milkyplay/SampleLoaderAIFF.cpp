@@ -163,12 +163,22 @@ struct AIFC_CommChunk
 };
 
 mp_sint32 SampleLoaderAIFF::loadSample(mp_sint32 index, mp_sint32 channelIndex)
+{
+	// prefer a file mapping, sample data is then paged in from
+	// the file while it's being converted
+	XMMappedFile mappedFile(theFileName, true);
+	if (mappedFile.isOpen())
+		return loadSample(mappedFile, index, channelIndex);
+	
+	XMFile f(theFileName);
+	return loadSample(f, index, channelIndex);
+}
+
+mp_sint32 SampleLoaderAIFF::loadSample(XMFileBase& f, mp_sint32 index, mp_sint32 channelIndex)
 {
 	mp_ubyte ID[4], buffer[4];
 	mp_dword chunkLen;
 	AIFC_CommChunk commChunk;
-
-	XMFile f(theFileName);
 	
 	f.read(ID, 4, 1);
 	if (memcmp(ID, "FORM", 4) != 0)
@@ -184,8 +194,8 @@ mp_sint32 SampleLoaderAIFF::loadSample(mp_sint32 index, mp_sint32 channelIndex)
 	bool aifc = false;
 	bool sowt = false;
 	
-	mp_sbyte* sampleData = NULL;
-	mp_sint32 sampleDataLen = 0;
+	mp_uint32 sampleDataPos = 0;
+	mp_uint32 sampleDataLen = 0;
 				
 	while (!(hasFORM && hasFVER && hasCOMM && hasSSND))
 	{
@@ -261,9 +271,13 @@ mp_sint32 SampleLoaderAIFF::loadSample(mp_sint32 index, mp_sint32 channelIndex)
 			case 0x53534E44 :	// 'SSND'
 			{
 				hasSSND = true;
-				sampleDataLen = chunkLen;
-				sampleData = new mp_sbyte[chunkLen];
-				f.read(sampleData, chunkLen, 1);
+				mp_uint32 pos = f.pos();
+				// sample data follows offset and block size
+				f.read(buffer, 4, 1);
+				mp_uint32 offset = BigEndian::GET_DWORD(buffer);
+				sampleDataPos = pos + 8 + offset;
+				sampleDataLen = (chunkLen >= 8 + offset) ? chunkLen - 8 - offset : 0;
+				f.seek(pos + chunkLen);
 				break;
 			}
 			
@@ -280,10 +294,10 @@ mp_sint32 SampleLoaderAIFF::loadSample(mp_sint32 index, mp_sint32 channelIndex)
 		if ((commChunk.numChannels >= 1) && 
 			(commChunk.numChannels <= 2) &&
 			(commChunk.sampleSize == 8 ||
-			 commChunk.sampleSize == 16))
+			 commChunk.sampleSize == 16 ||
+			 commChunk.sampleSize == 24 ||
+			 commChunk.sampleSize == 32))
 		{
-			sampleDataLen = (commChunk.numChannels * commChunk.numSampleFrames * commChunk.sampleSize) / 8;
-		
 			TXMSample* smp = &theModule.smp[index];
 			
 			if (smp->sample)
@@ -292,110 +306,72 @@ mp_sint32 SampleLoaderAIFF::loadSample(mp_sint32 index, mp_sint32 channelIndex)
 				smp->sample = NULL;
 			}					
 			
-			smp->samplen = ((commChunk.sampleSize == 16) ? sampleDataLen >> 1 : sampleDataLen) / commChunk.numChannels;
+			const mp_uint32 numChannels = commChunk.numChannels;
+			const mp_uint32 bytesPerSample = commChunk.sampleSize >> 3;
+			// more than 16 bits are cut down to 16 bits
+			const bool is16Bit = commChunk.sampleSize != 8;
 			
-			smp->sample = (mp_sbyte*)theModule.allocSampleMem((commChunk.sampleSize == 16) ? (smp->samplen<<1) : smp->samplen);						
-			if (smp->sample == NULL)
+			SampleConversion::Formats format;
+			switch (commChunk.sampleSize)
 			{
-				if (sampleData)
-					delete[] sampleData;
-				return MP_OUT_OF_MEMORY;						
+				case 8:
+					format = SampleConversion::FormatSigned8;
+					break;
+				case 16:
+					format = sowt ? SampleConversion::FormatSigned16LE : SampleConversion::FormatSigned16BE;
+					break;
+				case 24:
+					format = sowt ? SampleConversion::FormatSigned24LE : SampleConversion::FormatSigned24BE;
+					break;
+				default:
+					format = sowt ? SampleConversion::FormatSigned32LE : SampleConversion::FormatSigned32BE;
 			}
 			
-			if (commChunk.sampleSize == 8)
-			{
-				mp_sbyte* ptr = (mp_sbyte*)smp->sample; 
-				mp_sbyte* src = (mp_sbyte*)sampleData;
-
-				if (commChunk.numChannels == 1)
-				{
-					memcpy(ptr, src, smp->samplen);
-				}
-				else if (commChunk.numChannels == 2)
-				{
-					if (channelIndex == 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							*ptr = *src;
-							ptr++;
-							src+=2;
-						}
-					}
-					else if (channelIndex == 1)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							*ptr = *(src+1);
-							ptr++;
-							src+=2;
-						}
-					}
-					else if (channelIndex == -1)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							*ptr = (mp_sbyte)(((mp_sword)(*src) + (mp_sword)(*(src+1))) >> 1);
-							ptr++;
-							src+=2;
-						}
-					}			
-				}
-			}
-			else if (commChunk.sampleSize == 16)
+			smp->samplen = commChunk.numSampleFrames;
+			
+			smp->sample = (mp_sbyte*)theModule.allocSampleMem(is16Bit ? smp->samplen*2 : smp->samplen);						
+			if (smp->sample == NULL)
+				return MP_OUT_OF_MEMORY;						
+			
+			// Convert in chunks straight into the sample memory, this way
+			// large files don't need a temporary copy of the entire chunk
+			const mp_uint32 chunkFrames = 16384;
+			mp_ubyte* src = new mp_ubyte[chunkFrames*numChannels*bytesPerSample];
+			
+			f.seek(sampleDataPos);
+			
+			for (mp_uint32 offset = 0; offset < smp->samplen; offset+=chunkFrames)
 			{
-				mp_uword* ptr = (mp_uword*)smp->sample; 
-				mp_ubyte* src = (mp_ubyte*)sampleData;
+				mp_uint32 numFrames = smp->samplen - offset;
+				if (numFrames > chunkFrames)
+					numFrames = chunkFrames;
 				
-				if (commChunk.numChannels == 1)
+				mp_uint32 numBytes = numFrames*numChannels*bytesPerSample;
+				mp_uint32 numRead = 0;
+				// don't read past the end of the SSND chunk
+				mp_uint32 bytesDone = offset*numChannels*bytesPerSample;
+				if (bytesDone < sampleDataLen)
 				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-					{
-						*ptr = sowt ? LittleEndian::GET_WORD(src) : BigEndian::GET_WORD(src);
-						ptr++;
-						src+=2;
-					}
-				}
-				else if (commChunk.numChannels == 2)
-				{
-					if (channelIndex == 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							*ptr = sowt ? LittleEndian::GET_WORD(src) : BigEndian::GET_WORD(src);
-							ptr++;
-							src+=4;
-						}
-					}
-					else if (channelIndex == 1)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							*ptr = sowt ? LittleEndian::GET_WORD(src+2) : BigEndian::GET_WORD(src+2);
-							ptr++;
-							src+=4;
-						}
-					}
-					else if (channelIndex == -1)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							*ptr = sowt ? 
-								(mp_sword)(((mp_sint32)((mp_sword)LittleEndian::GET_WORD(src)) + (mp_sint32)((mp_sword)LittleEndian::GET_WORD(src+2))) >> 1) :
-								(mp_sword)(((mp_sint32)((mp_sword)BigEndian::GET_WORD(src)) + (mp_sint32)((mp_sword)BigEndian::GET_WORD(src+2))) >> 1);
-							ptr++;
-							src+=4;
-						}
-					}
+					mp_uint32 numAvailable = sampleDataLen - bytesDone;
+					mp_sint32 res = f.read(src, 1, numBytes < numAvailable ? numBytes : numAvailable);
+					if (res > 0)
+						numRead = res;
 				}
+				// pad truncated files with silence
+				if (numRead < numBytes)
+					memset(src + numRead, 0, numBytes - numRead);
+				
+				SampleConversion::decode(src, format, numChannels, channelIndex, 
+										 is16Bit ? (void*)((mp_sword*)smp->sample + offset) : (void*)(smp->sample + offset), 
+										 is16Bit, numFrames);
 			}
 			
-			delete[] sampleData;
+			delete[] src;
 			
 			smp->loopstart = 0;
 			smp->looplen = 0;
 			smp->type = 0;
-			if (commChunk.sampleSize == 16)
+			if (is16Bit)
 				smp->type |= 16;		
 						
 			nameToSample(preferredDefaultName, smp);
@@ -406,8 +382,6 @@ mp_sint32 SampleLoaderAIFF::loadSample(mp_sint32 index, mp_sint32 channelIndex)
 		}
 	}
 
-	delete[] sampleData;
-
 	return MP_LOADER_FAILED;
 }
 
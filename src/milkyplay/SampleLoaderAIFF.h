@@ -45,6 +45,8 @@ class SampleLoaderAIFF : public SampleLoaderAbstract
 private:
 	 static const char* channelNames[];
 
+	mp_sint32 loadSample(XMFileBase& f, mp_sint32 index, mp_sint32 channelIndex);
+
 public:
 	SampleLoaderAIFF(const SYSCHAR* fileName, XModule& theModule);
 
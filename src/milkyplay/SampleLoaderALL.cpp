@@ -94,15 +94,6 @@ mp_sint32 SampleLoaderALL::saveSample(const SYSCHAR* fileName, mp_sint32 index)
 
 	XMFile f(fileName, true);
 
-	if (smp->type & 16)
-	{
-		for (mp_uint32 i = 0; i < smp->samplen; i++)
-			f.writeWord(smp->getSampleValue(i));
-	}
-	else
-	{
-		for (mp_uint32 i = 0; i < smp->samplen; i++)
-			f.writeByte(smp->getSampleValue(i));
-	}
+	writeSampleData(f, smp, (smp->type & 16) ? SampleConversion::FormatSigned16LE : SampleConversion::FormatSigned8);
 	return MP_OK;
 }
@@ -61,3 +61,27 @@ void SampleLoaderAbstract::nameToSample(const char* name, TXMSample* smp)
 	}
 }
 
+void SampleLoaderAbstract::writeSampleData(XMFileBase& f, TXMSample* smp, SampleConversion::Formats format)
+{
+	const mp_uint32 chunkSize = 16384;
+	const bool is16Bit = (smp->type & 16) != 0;
+	const mp_uint32 bytesPerSample = SampleConversion::getBytesPerSample(format);
+	
+	mp_sword* src = new mp_sword[chunkSize];
+	mp_ubyte* dst = new mp_ubyte[chunkSize*bytesPerSample];
+	
+	for (mp_uint32 offset = 0; offset < smp->samplen; offset+=chunkSize)
+	{
+		mp_uint32 count = smp->samplen - offset;
+		if (count > chunkSize)
+			count = chunkSize;
+		
+		smp->readSamples(offset, count, src);
+		SampleConversion::encode(src, is16Bit, dst, format, count);
+		f.write(dst, 1, count*bytesPerSample);
+	}
+	
+	delete[] dst;
+	delete[] src;
+}
+
@@ -39,6 +39,7 @@
 #define SAMPLELOADERABSTRACT__H
 
 #include "XMFile.h"
+#include "SampleConversion.h"
 
 class XModule;
 struct TXMSample;
@@ -54,6 +55,9 @@ protected:
 	const char* preferredDefaultName;
 	
 	void nameToSample(const char* name, TXMSample* smp); 
+
+	// write the whole sample in the given format
+	static void writeSampleData(XMFileBase& f, TXMSample* smp, SampleConversion::Formats format);
 	
 public:
 	SampleLoaderAbstract(const SYSCHAR* fileName, XModule& module);
@@ -452,17 +452,14 @@ bail:
 			return MP_OUT_OF_MEMORY;						
 		}
 
-		memcpy(smp->sample, sampleData, sampleDataLen);
-		
 		if (hires)
 		{
 			// huuuu? 16 bit IFF samples are little endian? how stupid is that?
-			mp_uword* ptr = (mp_uword*)smp->sample; 
-			for (mp_uint32 i = 0; i < smp->samplen; i++)
-			{
-				*ptr = LittleEndian::GET_WORD(ptr);
-				ptr++;
-			}
+			SampleConversion::decode(sampleData, SampleConversion::FormatSigned16LE, 1, 0, smp->sample, true, smp->samplen);
+		}
+		else
+		{
+			memcpy(smp->sample, sampleData, sampleDataLen);
 		}
 		
 		delete[] sampleData;
@@ -566,16 +563,7 @@ mp_sint32 SampleLoaderIFF::saveSample(const SYSCHAR* fileName, mp_sint32 index)
 	f.write("BODY", 1, 4);
 	f.writeDword(swapDW(hires ? smp->samplen << 16 : smp->samplen));	
 
-	if (smp->type & 16)
-	{
-		for (mp_uint32 i = 0; i < smp->samplen; i++)
-			f.writeWord(smp->getSampleValue(i));
-	}
-	else
-	{
-		for (mp_uint32 i = 0; i < smp->samplen; i++)
-			f.writeByte(smp->getSampleValue(i));
-	}
+	writeSampleData(f, smp, (smp->type & 16) ? SampleConversion::FormatSigned16LE : SampleConversion::FormatSigned8);
 	
 	return MP_OK;
 }
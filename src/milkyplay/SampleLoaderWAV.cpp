@@ -51,7 +51,7 @@ bool SampleLoaderWAV::identifySample()
 	return getNumChannels() != 0;
 }
 
-mp_sint32 SampleLoaderWAV::parseFMTChunk(XMFile& f, TWAVHeader& hdr)
+mp_sint32 SampleLoaderWAV::parseFMTChunk(XMFileBase& f, TWAVHeader& hdr)
 {
 	if (hdr.fmtDataLength < 16)
 		return MP_LOADER_FAILED;
@@ -85,323 +85,80 @@ mp_sint32 SampleLoaderWAV::parseFMTChunk(XMFile& f, TWAVHeader& hdr)
 	return MP_OK;
 }
 
-mp_sint32 SampleLoaderWAV::parseDATAChunk(XMFile& f, TWAVHeader& hdr, mp_sint32 index, mp_sint32 channelIndex)
+mp_sint32 SampleLoaderWAV::parseDATAChunk(XMFileBase& f, TWAVHeader& hdr, mp_sint32 index, mp_sint32 channelIndex)
 {
 	TXMSample* smp = &theModule.smp[index];
 	
 	if (hdr.dataLength)
 	{
+		const mp_uint32 bytesPerSample = hdr.numBits >> 3;
+		const mp_uint32 numChannels = hdr.numChannels;
+		const bool is16Bit = hdr.numBits != 8;
 		
-		if (hdr.numBits == 8)
+		if (channelIndex > 1)
 		{
-			if (smp->sample)
-			{
-				theModule.freeSampleMem((mp_ubyte*)smp->sample);
-				smp->sample = NULL;
-			}					
-			smp->samplen = hdr.dataLength;					
-			if (hdr.numChannels == 2)
-			{
-				mp_sbyte* buffer = new mp_sbyte[smp->samplen];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, buffer, smp->samplen, smp->samplen, XModule::ST_UNSIGNED);						
-				smp->samplen>>=1;						
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen);						
-				if (smp->sample == NULL)
-				{
-					delete[] buffer;
-					return MP_OUT_OF_MEMORY;
-				}						
-				// Downmix channels
-				if (channelIndex < 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-					{
-						mp_sint32 s1 = buffer[i*2];
-						mp_sint32 s2 = buffer[i*2+1];
-						smp->sample[i] = (mp_sbyte)((s1+s2)>>1);
-					}
-				}
-				// take left channel
-				else if (channelIndex == 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						smp->sample[i] = buffer[i*2];
-				}
-				// take right channel
-				else if (channelIndex == 1)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						smp->sample[i] = buffer[i*2+1];
-				}
-				else 
-					ASSERT(false);						
-				delete[] buffer;
-			}
-			else
-			{
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen);						
-				if (smp->sample == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, smp->sample, smp->samplen, smp->samplen, XModule::ST_UNSIGNED);
-			}					
-			smp->type = 0;
+			ASSERT(false);
+			channelIndex = 0;
 		}
-		else if (hdr.numBits == 16)
+		
+		if (smp->sample)
 		{
-			if (smp->sample)
-			{
-				theModule.freeSampleMem((mp_ubyte*)smp->sample);
-				smp->sample = NULL;
-			}					
-			smp->samplen = hdr.dataLength>>1;					
-			if (hdr.numChannels == 2)
-			{
-				mp_sword* buffer = new mp_sword[smp->samplen];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, buffer, hdr.dataLength, smp->samplen, XModule::ST_16BIT);						
-				smp->samplen>>=1;						
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-				{
-					delete[] buffer;
-					return MP_OUT_OF_MEMORY;
-				}						
-				mp_sword* sample = (mp_sword*)smp->sample;
-				// Downmix channels
-				if (channelIndex < 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-					{
-						mp_sint32 s1 = buffer[i*2];
-						mp_sint32 s2 = buffer[i*2+1];
-						sample[i] = (mp_sword)((s1+s2)>>1);
-					}
-				}
-				// take left channel
-				else if (channelIndex == 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = buffer[i*2];
-				}
-				// take right channel
-				else if (channelIndex == 1)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = buffer[i*2+1];
-				}
-				else 
-					ASSERT(false);							
-				delete[] buffer;
-			}
-			else
-			{
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-					return MP_OUT_OF_MEMORY;						
-				theModule.loadSample(f, smp->sample, hdr.dataLength, smp->samplen, XModule::ST_16BIT);
-			}					
-			smp->type = 16;
-		}
-		else if (hdr.numBits == 24)
+			theModule.freeSampleMem((mp_ubyte*)smp->sample);
+			smp->sample = NULL;
+		}					
+		smp->samplen = (hdr.dataLength / bytesPerSample) / numChannels;
+		smp->sample = (mp_sbyte*)theModule.allocSampleMem(is16Bit ? smp->samplen*2 : smp->samplen);						
+		if (smp->sample == NULL)
+			return MP_OUT_OF_MEMORY;
+		
+		SampleConversion::Formats format;
+		switch (hdr.numBits)
 		{
-			if (smp->sample)
-			{
-				theModule.freeSampleMem((mp_ubyte*)smp->sample);
-				smp->sample = NULL;
-			}					
-			smp->samplen = hdr.dataLength/3;					
-			if (hdr.numChannels == 2)
-			{
-				mp_ubyte* buffer = new mp_ubyte[smp->samplen*3];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;												
-				f.read(buffer, 3, smp->samplen);
-				smp->samplen>>=1;						
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-				{
-					delete[] buffer;
-					return MP_OUT_OF_MEMORY;
-				}						
-				mp_sword* sample = (mp_sword*)smp->sample;
-				// Downmix channels
-				if (channelIndex < 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-					{
-						mp_sword s1 = ((mp_sint32)buffer[i*6+1] + (((mp_sint32)buffer[i*6+2])<<8));
-						mp_sword s2 = ((mp_sint32)buffer[i*6+4] + (((mp_sint32)buffer[i*6+5])<<8));
-						sample[i] = ((mp_sint32)s1 + (mp_sint32)s2) >> 1;
-					}
-				}
-				// take left channel
-				else if (channelIndex == 0)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = ((mp_sint32)buffer[i*6+1] + (((mp_sint32)buffer[i*6+2])<<8));
-				}
-				// take right channel
-				else if (channelIndex == 1)
-				{
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = ((mp_sint32)buffer[i*6+4] + (((mp_sint32)buffer[i*6+5])<<8));
-				}
-				else 
-					ASSERT(false);							
-				delete[] buffer;
-			}
-			else
-			{
-				smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-				if (smp->sample == NULL)
-					return MP_OUT_OF_MEMORY;
-				mp_ubyte* buffer = new mp_ubyte[smp->samplen*3];						
-				if (buffer == NULL)
-					return MP_OUT_OF_MEMORY;												
-				f.read(buffer, 3, smp->samplen);
-				mp_sword* sample = (mp_sword*)smp->sample;
-				for (mp_uint32 i = 0; i < smp->samplen; i++)
-					sample[i] = ((mp_sint32)buffer[i*3+1] + (((mp_sint32)buffer[i*3+2])<<8));
-				delete[] buffer;
-			}					
-			smp->type = 16;
+			case 8:
+				format = SampleConversion::FormatUnsigned8;
+				break;
+			case 16:
+				format = SampleConversion::FormatSigned16LE;
+				break;
+			case 24:
+				format = SampleConversion::FormatSigned24LE;
+				break;
+			default:
+				format = hdr.encodingTag == 0x03 ? SampleConversion::FormatFloat32LE : SampleConversion::FormatSigned32LE;
 		}
-		else if (hdr.numBits == 32)
+		
+		// Convert in chunks straight into the sample memory, this way
+		// large files don't need a temporary copy of the entire data chunk
+		const mp_uint32 chunkFrames = 16384;
+		mp_ubyte* src = new mp_ubyte[chunkFrames*numChannels*bytesPerSample];
+		
+		mp_uint32 startPos = f.pos();
+		
+		for (mp_uint32 offset = 0; offset < smp->samplen; offset+=chunkFrames)
 		{
-			// 32 bit DWORD sample data?
-			if (hdr.encodingTag == 0x01)
-			{
-				if (smp->sample)
-				{
-					theModule.freeSampleMem((mp_ubyte*)smp->sample);
-					smp->sample = NULL;
-				}					
-				smp->samplen = hdr.dataLength>>2;					
-				
-				if (hdr.numChannels == 2)
-				{
-					mp_sint32* buffer = new mp_sint32[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords((mp_dword*)buffer, smp->samplen);
-					smp->samplen>>=1;						
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-					{
-						delete[] buffer;
-						return MP_OUT_OF_MEMORY;
-					}						
-					mp_sword* sample = (mp_sword*)smp->sample;
-					// Downmix channels
-					if (channelIndex < 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							mp_sint32 s1 = buffer[i*2]>>16;
-							mp_sint32 s2 = buffer[i*2+1]>>16;
-							sample[i] = (mp_sword)((s1+s2)>>1);
-						}
-					}
-					// take left channel
-					else if (channelIndex == 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = buffer[i*2]>>16;
-					}
-					// take right channel
-					else if (channelIndex == 1)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = buffer[i*2+1]>>16;
-					}
-					else 
-						ASSERT(false);							
-					delete[] buffer;
-				}
-				else
-				{
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-						return MP_OUT_OF_MEMORY;
-					mp_sint32* buffer = new mp_sint32[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords((mp_dword*)buffer, smp->samplen);
-					mp_sword* sample = (mp_sword*)smp->sample;
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = buffer[i]>>16;
-					delete[] buffer;
-				}
-			}
-			else if (hdr.encodingTag == 0x03)
-			{
-				if (smp->sample)
-				{
-					theModule.freeSampleMem((mp_ubyte*)smp->sample);
-					smp->sample = NULL;
-				}					
-				smp->samplen = hdr.dataLength>>2;					
-				
-				if (hdr.numChannels == 2)
-				{
-					float* buffer = new float[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords(reinterpret_cast<mp_dword*>(buffer), smp->samplen);
-					smp->samplen>>=1;						
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-					{
-						delete[] buffer;
-						return MP_OUT_OF_MEMORY;
-					}						
-					mp_sword* sample = (mp_sword*)smp->sample;
-					// Downmix channels
-					if (channelIndex < 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-						{
-							mp_sint32 s1 = (mp_sint32)(buffer[i*2]*32767.0f);
-							mp_sint32 s2 = (mp_sint32)(buffer[i*2+1]*32767.0f);
-							sample[i] = (mp_sword)((s1+s2)>>1);
-						}
-					}
-					// take left channel
-					else if (channelIndex == 0)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = (mp_sint32)(buffer[i*2]*32767.0f);
-					}
-					// take right channel
-					else if (channelIndex == 1)
-					{
-						for (mp_uint32 i = 0; i < smp->samplen; i++)
-							sample[i] = (mp_sint32)(buffer[i*2+1]*32767.0f);
-					}
-					else 
-						ASSERT(false);							
-					delete[] buffer;
-				}
-				else
-				{
-					smp->sample = (mp_sbyte*)theModule.allocSampleMem(smp->samplen*2);						
-					if (smp->sample == NULL)
-						return MP_OUT_OF_MEMORY;
-					float* buffer = new float[smp->samplen];						
-					if (buffer == NULL)
-						return MP_OUT_OF_MEMORY;												
-					f.readDwords(reinterpret_cast<mp_dword*>(buffer), smp->samplen);
-					mp_sword* sample = (mp_sword*)smp->sample;
-					for (mp_uint32 i = 0; i < smp->samplen; i++)
-						sample[i] = (mp_sint32)(buffer[i]*32767.0f);
-					delete[] buffer;
-				}
-			}
-			smp->type = 16;
-		}								
+			mp_uint32 numFrames = smp->samplen - offset;
+			if (numFrames > chunkFrames)
+				numFrames = chunkFrames;
+			
+			mp_sint32 numBytes = numFrames*numChannels*bytesPerSample;
+			mp_sint32 numRead = f.read(src, 1, numBytes);
+			if (numRead < 0)
+				numRead = 0;
+			// pad truncated files with silence
+			if (numRead < numBytes)
+				memset(src + numRead, is16Bit ? 0 : 128, numBytes - numRead);
+			
+			SampleConversion::decode(src, format, numChannels, channelIndex, 
+									 is16Bit ? (void*)((mp_sword*)smp->sample + offset) : (void*)(smp->sample + offset), 
+									 is16Bit, numFrames, offset);
+		}
+		
+		delete[] src;
+		
+		// skip incomplete frames
+		f.seek(startPos + hdr.dataLength);
+		
+		smp->type = is16Bit ? 16 : 0;
 		smp->loopstart = 0;
 		smp->looplen = 0; 
 		
@@ -416,7 +173,7 @@ mp_sint32 SampleLoaderWAV::parseDATAChunk(XMFile& f, TWAVHeader& hdr, mp_sint32
 	return MP_OK;
 }
 
-mp_sint32 SampleLoaderWAV::parseSMPLChunk(XMFile& f, TWAVHeader& hdr, 
+mp_sint32 SampleLoaderWAV::parseSMPLChunk(XMFileBase& f, TWAVHeader& hdr, 
 										  TSamplerChunk& samplerChunk, TSampleLoop& sampleLoop)
 {
 	mp_dword pos = (unsigned)f.pos() + (unsigned)hdr.dataLength;			
@@ -489,8 +246,18 @@ const char* SampleLoaderWAV::getChannelName(mp_sint32 channelIndex)
 
 mp_sint32 SampleLoaderWAV::loadSample(mp_sint32 index, mp_sint32 channelIndex)
 {
+	// prefer a file mapping, sample data is then paged in from
+	// the file while it's being converted
+	XMMappedFile mappedFile(theFileName, true);
+	if (mappedFile.isOpen())
+		return loadSample(mappedFile, index, channelIndex);
+	
 	XMFile f(theFileName);
-		
+	return loadSample(f, index, channelIndex);
+}
+
+mp_sint32 SampleLoaderWAV::loadSample(XMFileBase& f, mp_sint32 index, mp_sint32 channelIndex)
+{
 	TWAVHeader hdr;
 	
 	f.read(hdr.RIFF, 1, 4);
@@ -575,7 +342,7 @@ mp_sint32 SampleLoaderWAV::loadSample(mp_sint32 index, mp_sint32 channelIndex)
 		}
 	
 		if (hdr.dataLength & 1)
-			f.seek(1, XMFile::SeekOffsetTypeCurrent);
+			f.seek(1, XMFileBase::SeekOffsetTypeCurrent);
 	} while (f.pos() < f.size());
 	
 	if (!hasData)
@@ -678,21 +445,8 @@ mp_sint32 SampleLoaderWAV::saveSample(const SYSCHAR* fileName, mp_sint32 index)
 	f.write(hdr.DATA, 1, 4);	
 	f.writeDword(hdr.dataLength);
 	
-	if (smp->type & 16)
-	{
-		for (mp_uint32 i = 0; i < smp->samplen; i++)
-			f.writeWord(smp->getSampleValue(i));
-	}
-	else
-	{
-		// WAV 8 bit is unsigned 
-		mp_ubyte* dstPtr = new mp_ubyte[smp->samplen]; 
-		mp_ubyte* dst = dstPtr;
-		for (mp_uint32 i = 0; i < smp->samplen; i++)
-			*dstPtr++ = ((mp_sbyte)smp->getSampleValue(i))^128;
-		f.write(dst, 1, smp->samplen);
-		delete[] dst;
-	}
+	// WAV 8 bit is unsigned 
+	writeSampleData(f, smp, (smp->type & 16) ? SampleConversion::FormatSigned16LE : SampleConversion::FormatUnsigned8);
 	
 	return MP_OK;
 }
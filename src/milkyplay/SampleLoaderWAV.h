@@ -108,9 +108,11 @@ private:
 	
 	static const char* channelNames[];
 
-	mp_sint32 parseFMTChunk(XMFile& f, TWAVHeader& hdr);
-	mp_sint32 parseDATAChunk(XMFile& f, TWAVHeader& hdr, mp_sint32 index, mp_sint32 channelIndex);
-	mp_sint32 parseSMPLChunk(XMFile& f, TWAVHeader& hdr, TSamplerChunk& samplerChunk, TSampleLoop& sampleLoop);
+	mp_sint32 parseFMTChunk(XMFileBase& f, TWAVHeader& hdr);
+	mp_sint32 parseDATAChunk(XMFileBase& f, TWAVHeader& hdr, mp_sint32 index, mp_sint32 channelIndex);
+	mp_sint32 parseSMPLChunk(XMFileBase& f, TWAVHeader& hdr, TSamplerChunk& samplerChunk, TSampleLoop& sampleLoop);
+
+	mp_sint32 loadSample(XMFileBase& f, mp_sint32 index, mp_sint32 channelIndex);
 
 public:
 	SampleLoaderWAV(const SYSCHAR* fileName, XModule& theModule);
@@ -34,7 +34,11 @@
 #include "XMFile.h"
 
 XMFileBase::XMFileBase() :
-	baseOffset(0)
+	baseOffset(0),
+	readPtr(NULL),
+	readEnd(NULL),
+	writePtr(NULL),
+	writeEnd(NULL)
 {
 }
 
@@ -60,7 +64,7 @@ mp_uint32 XMFileBase::posWithBaseOffset()
 //////////////////////////////////////////////////////////////////////////
 // Reading/writing of little endian stuff								//
 //////////////////////////////////////////////////////////////////////////
-mp_ubyte XMFileBase::readByte()
+mp_ubyte XMFileBase::readByteUnbuffered()
 {
 	mp_ubyte c;
 	mp_sint32 bytesRead = read(&c,1,1);
@@ -72,7 +76,7 @@ mp_ubyte XMFileBase::readByte()
 	return (mp_ubyte)c;
 }
 
-mp_uword XMFileBase::readWord()
+mp_uword XMFileBase::readWordUnbuffered()
 {
 	mp_ubyte c[2];
 	mp_sint32 bytesRead = read(&c,1,2);
@@ -84,7 +88,7 @@ mp_uword XMFileBase::readWord()
 	return (mp_uword)((mp_uword)c[0]+((mp_uword)c[1]<<8));
 }
 
-mp_dword XMFileBase::readDword()
+mp_dword XMFileBase::readDwordUnbuffered()
 {
 	mp_ubyte c[4];
 	mp_sint32 bytesRead = read(&c,1,4);
@@ -99,59 +103,96 @@ mp_dword XMFileBase::readDword()
 					  ((mp_uint32)c[3]<<24));
 }
 
+// read count values of size bytes, missing ones are 0
+static void readValues(XMFileBase& f, void* buffer, mp_sint32 size, mp_sint32 count)
+{
+	if (count <= 0)
+		return;
+
+	mp_sint32 bytesRead = f.read(buffer, size, count);
+	mp_sint32 numRead = bytesRead > 0 ? bytesRead / size : 0;
+	if (numRead < count)
+	{
+		// an incomplete value at the end is skipped, like reading them one by one does
+		mp_ubyte rest[4];
+		f.read(rest, 1, size - 1);
+		memset((mp_ubyte*)buffer + numRead*size, 0, (count - numRead)*size);
+	}
+}
+
 void XMFileBase::readWords(mp_uword* buffer,mp_sint32 count)
 {
+	readValues(*this, buffer, 2, count);
+	const mp_ubyte* src = (const mp_ubyte*)buffer;
 	for (mp_sint32 i = 0; i < count; i++)
-		*buffer++ = readWord();
+		buffer[i] = (mp_uword)(src[i*2] | (src[i*2+1] << 8));
 }
 
 void XMFileBase::readDwords(mp_dword* buffer,mp_sint32 count)
 {
+	readValues(*this, buffer, 4, count);
+	const mp_ubyte* src = (const mp_ubyte*)buffer;
 	for (mp_sint32 i = 0; i < count; i++)
-		*buffer++ = readDword();
+		buffer[i] = (mp_dword)src[i*4] | ((mp_dword)src[i*4+1] << 8) | 
+					((mp_dword)src[i*4+2] << 16) | ((mp_dword)src[i*4+3] << 24);
 }
 
-void XMFileBase::writeByte(mp_ubyte b)
+void XMFileBase::readWordsBE(mp_uword* buffer,mp_sint32 count)
 {
-	mp_sint32 bytesWritten = write(&b, 1, 1);
-	ASSERT(bytesWritten == 1);
+	readValues(*this, buffer, 2, count);
+	const mp_ubyte* src = (const mp_ubyte*)buffer;
+	for (mp_sint32 i = 0; i < count; i++)
+		buffer[i] = (mp_uword)((src[i*2] << 8) | src[i*2+1]);
 }
 
-void XMFileBase::writeWord(mp_uword w)
+void XMFileBase::readDwordsBE(mp_dword* buffer,mp_sint32 count)
 {
-	mp_ubyte c[2];
-	c[0] = (mp_ubyte)w;
-	c[1] = (mp_ubyte)(w>>8);
-	mp_sint32 bytesWritten = write(&c, 1, 2);
-	ASSERT(bytesWritten == 2);	
+	readValues(*this, buffer, 4, count);
+	const mp_ubyte* src = (const mp_ubyte*)buffer;
+	for (mp_sint32 i = 0; i < count; i++)
+		buffer[i] = ((mp_dword)src[i*4] << 24) | ((mp_dword)src[i*4+1] << 16) | 
+					((mp_dword)src[i*4+2] << 8) | (mp_dword)src[i*4+3];
 }
 
-void XMFileBase::writeDword(mp_dword dw)
+void XMFileBase::writeUnbuffered(const mp_ubyte* bytes, mp_sint32 count)
 {
-	mp_ubyte c[4];
-	c[0] = (mp_ubyte)dw;
-	c[1] = (mp_ubyte)(dw>>8);
-	c[2] = (mp_ubyte)(dw>>16);
-	c[3] = (mp_ubyte)(dw>>24);
-	mp_sint32 bytesWritten = write(&c, 1, 4);
-	ASSERT(bytesWritten == 4);	
+	mp_sint32 bytesWritten = write(bytes, 1, count);
+	ASSERT(bytesWritten == count);
 }
 
+// values are converted in blocks and written with one call per block
+#define WRITEBLOCKSIZE 1024
+
 void XMFileBase::writeWords(const mp_uword* buffer,mp_sint32 count)
 {
-	for (mp_sint32 i = 0; i < count; i++)
+	mp_ubyte block[WRITEBLOCKSIZE*2];
+	for (mp_sint32 offset = 0; offset < count; offset+=WRITEBLOCKSIZE)
 	{
-		writeWord(*buffer);
-		buffer++;
+		mp_sint32 num = count - offset < WRITEBLOCKSIZE ? count - offset : WRITEBLOCKSIZE;
+		for (mp_sint32 i = 0; i < num; i++)
+		{
+			block[i*2] = (mp_ubyte)buffer[offset+i];
+			block[i*2+1] = (mp_ubyte)(buffer[offset+i]>>8);
+		}
+		writeUnbuffered(block, num*2);
 	}
 }
 
 void XMFileBase::writeDwords(const mp_dword* buffer,mp_sint32 count)
 {
-	for (mp_sint32 i = 0; i < count; i++)
+	mp_ubyte block[WRITEBLOCKSIZE*4];
+	for (mp_sint32 offset = 0; offset < count; offset+=WRITEBLOCKSIZE)
 	{
-		writeDword(*buffer);
-		buffer++;
+		mp_sint32 num = count - offset < WRITEBLOCKSIZE ? count - offset : WRITEBLOCKSIZE;
+		for (mp_sint32 i = 0; i < num; i++)
+		{
+			mp_dword dw = buffer[offset+i];
+			block[i*4] = (mp_ubyte)dw;
+			block[i*4+1] = (mp_ubyte)(dw>>8);
+			block[i*4+2] = (mp_ubyte)(dw>>16);
+			block[i*4+3] = (mp_ubyte)(dw>>24);
+		}
+		writeUnbuffered(block, num*4);
 	}
 }
 
@@ -172,12 +213,12 @@ void XMFileBase::writeString(const char* string)
 XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 	XMFileBase(),
 	fileName(fileName),
-	cacheBuffer(NULL)
+	cacheBuffer(NULL),
+	filePos(0),
+	fileSize(0)
 {
 	this->writeAccess = writeAccess;
 
-	bytesRead = 0;
-	
 	handle = CreateFile(fileName,
 					    writeAccess ? GENERIC_WRITE : GENERIC_READ,
 						writeAccess ? FILE_SHARE_WRITE : FILE_SHARE_READ,
@@ -188,10 +229,25 @@ XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 
 	//ASSERT(handle != INVALID_HANDLE_VALUE);
 
+	if (handle == INVALID_HANDLE_VALUE)
+		return;
+
+	cacheBuffer = new mp_ubyte[BUFFERSIZE+16];
+
 	if (writeAccess)
 	{
-		cacheBuffer = new mp_ubyte[BUFFERSIZE+16];
-		currentCacheBufferPtr = cacheBuffer;
+		writePtr = cacheBuffer;
+#ifdef DEBUG
+		// everything is written through
+		writeEnd = cacheBuffer;
+#else
+		writeEnd = cacheBuffer + BUFFERSIZE;
+#endif
+	}
+	else
+	{
+		fileSize = GetFileSize(handle, NULL);
+		readPtr = readEnd = cacheBuffer;
 	}
 }
 
@@ -213,97 +269,147 @@ XMFile::~XMFile()
 
 mp_sint32 XMFile::read(void* ptr,mp_sint32 size,mp_sint32 count)
 {
-	unsigned long NumberOfBytesRead;
-	bool bResult = (bool)ReadFile(handle,ptr,size*count,&NumberOfBytesRead,NULL);
-	bytesRead+=(mp_uint32)NumberOfBytesRead;
-	if (!bResult) return -1;
-	return (mp_sint32)NumberOfBytesRead;
+	if (writeAccess || handle == INVALID_HANDLE_VALUE || size <= 0 || count <= 0)
+		return 0;
+
+	mp_ubyte* dst = (mp_ubyte*)ptr;
+	mp_uint32 numBytes = size*count;
+	
+	// take what's left in the read ahead buffer first
+	mp_uint32 numRead = (mp_uint32)(readEnd - readPtr);
+	if (numRead > numBytes)
+		numRead = numBytes;
+	memcpy(dst, readPtr, numRead);
+	readPtr += numRead;
+	
+	if (numRead < numBytes)
+	{
+		mp_uint32 numLeft = numBytes - numRead;
+		unsigned long NumberOfBytesRead = 0;
+		
+		// large reads go straight to the destination
+		if (numLeft >= BUFFERSIZE)
+		{
+			readPtr = readEnd = cacheBuffer;
+			bool bResult = (bool)ReadFile(handle,dst + numRead,numLeft,&NumberOfBytesRead,NULL);
+			if (!bResult) return -1;
+			filePos += (mp_uint32)NumberOfBytesRead;
+			numRead += (mp_uint32)NumberOfBytesRead;
+		}
+		else
+		{
+			bool bResult = (bool)ReadFile(handle,cacheBuffer,BUFFERSIZE,&NumberOfBytesRead,NULL);
+			readPtr = readEnd = cacheBuffer;
+			if (!bResult) return -1;
+			filePos += (mp_uint32)NumberOfBytesRead;
+			readEnd = cacheBuffer + NumberOfBytesRead;
+			
+			if (numLeft > NumberOfBytesRead)
+				numLeft = (mp_uint32)NumberOfBytesRead;
+			memcpy(dst + numRead, readPtr, numLeft);
+			readPtr += numLeft;
+			numRead += numLeft;
+		}
+	}
+	
+	// only complete items count, like with fread
+	return (mp_sint32)((numRead / size) * size);
 }
 
 void XMFile::flush()
 {
 	unsigned long NumberOfBytesWritten;
-	bool bResult = (bool)WriteFile(handle,cacheBuffer,
-								   currentCacheBufferPtr-cacheBuffer,
-								   &NumberOfBytesWritten,
-								   NULL);
-	bytesRead+=(mp_uint32)NumberOfBytesWritten;
-	currentCacheBufferPtr = cacheBuffer;
+	WriteFile(handle,cacheBuffer,
+			  writePtr-cacheBuffer,
+			  &NumberOfBytesWritten,
+			  NULL);
+	writePtr = cacheBuffer;
 }
 
 mp_sint32 XMFile::write(const void* ptr,mp_sint32 size,mp_sint32 count)
 {
-#ifdef DEBUG
-	unsigned long NumberOfBytesWritten;
-	bool bResult = (bool)WriteFile(handle,ptr,size*count,&NumberOfBytesWritten,NULL);
-	bytesRead+=(mp_uint32)NumberOfBytesWritten;
-	if (!bResult) return -1;
-	return (mp_sint32)NumberOfBytesWritten;
-	FlushFileBuffers(handle);
-#else
+	if (!writeAccess || handle == INVALID_HANDLE_VALUE)
+		return -1;
+
 	// Buffer to be written is bigger than our internal cache
 	// => Write through
-	if (size*count > BUFFERSIZE)
+	// In debug builds everything is written through
+	if (size*count > writeEnd - cacheBuffer)
 	{
 		// Flush first
 		flush();
 		unsigned long NumberOfBytesWritten;
 		bool bResult = (bool)WriteFile(handle,ptr,size*count,&NumberOfBytesWritten,NULL);
-		bytesRead+=(mp_uint32)NumberOfBytesWritten;
 		if (!bResult) return -1;
 		return (mp_sint32)NumberOfBytesWritten;
 	}
 
-	// Buffer to be written still fits into our cache buffer
-	if (size*count + currentCacheBufferPtr <= cacheBuffer+BUFFERSIZE)
-	{
-		// Copy into cache
-		memcpy(currentCacheBufferPtr, ptr, size*count);
-		// Advance current cache ptr
-		currentCacheBufferPtr += size*count;
-	}
-	else
-	{
-		// Buffer doesn't fit, flush buffer first
+	// Buffer doesn't fit, flush buffer first
+	if (size*count > writeEnd - writePtr)
 		flush();
-		// Copy into cache
-		memcpy(currentCacheBufferPtr, ptr, size*count);
-		// Advance 
-		currentCacheBufferPtr += size*count;
-	}
+		
+	// Copy into cache
+	memcpy(writePtr, ptr, size*count);
+	// Advance current cache ptr
+	writePtr += size*count;
 	
-	if (currentCacheBufferPtr == cacheBuffer + BUFFERSIZE)
+	if (writePtr == writeEnd)
 		flush();
 
-	bytesRead+=size*count;
 	return size*count;
-#endif
 }
 
 void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
 {
+	if (handle == INVALID_HANDLE_VALUE)
+		return;
+
 	if (writeAccess)
 	{
 		flush();
-	}
 
-	DWORD moveMethod = FILE_BEGIN;
+		DWORD moveMethod = FILE_BEGIN;
 
+		if (seekOffsetType == XMFile::SeekOffsetTypeCurrent)
+			moveMethod = FILE_CURRENT;
+		else if (seekOffsetType == XMFile::SeekOffsetTypeEnd)
+			moveMethod = FILE_END;
+		
+		SetFilePointer(handle, pos, NULL, moveMethod);
+		return;
+	}
+	
+	// relative offsets may be negative
 	if (seekOffsetType == XMFile::SeekOffsetTypeCurrent)
-		moveMethod = FILE_CURRENT;
+		pos = this->pos() + (mp_sint32)pos;
 	else if (seekOffsetType == XMFile::SeekOffsetTypeEnd)
-		moveMethod = FILE_END;
+		pos = fileSize + (mp_sint32)pos;
 	
-	SetFilePointer(handle, pos, NULL, moveMethod);
+	// stay in the read ahead buffer if possible
+	mp_uint32 bufferStart = filePos - (mp_uint32)(readEnd - cacheBuffer);
+	if (pos >= bufferStart && pos <= filePos)
+	{
+		readPtr = cacheBuffer + (pos - bufferStart);
+		return;
+	}
+	
+	filePos = SetFilePointer(handle, pos, NULL, FILE_BEGIN);
+	readPtr = readEnd = cacheBuffer;
 }
 
 mp_uint32 XMFile::pos()
 {
+	if (!writeAccess && handle != INVALID_HANDLE_VALUE)
+		return filePos - (mp_uint32)(readEnd - readPtr);
+
 	return SetFilePointer(handle, 0, NULL, FILE_CURRENT);
 }
 
 mp_uint32 XMFile::size()
 {
+	if (!writeAccess)
+		return fileSize;
+
 	mp_uint32 size = 0;
 	mp_uint32 curPos = pos();
 	SetFilePointer(handle, 0, NULL, FILE_END);
@@ -363,19 +469,32 @@ XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 	XMFileBase(),
 	fileName(fileName),
 	fileNameASCII(NULL),
-	cacheBuffer(NULL)
+	cacheBuffer(NULL),
+	filePos(0),
+	fileSize(0)
 {
 	this->writeAccess = writeAccess;
 
-	bytesRead = 0;	
 	handle = fopen(fileName,writeAccess?"wb":"rb");
 
 	//ASSERT(handle != NULL);
 	
+	if (handle == NULL)
+		return;
+	
+	cacheBuffer = new mp_ubyte[BUFFERSIZE];
+	
 	if (writeAccess)
 	{
-		cacheBuffer = new mp_ubyte[BUFFERSIZE];
-		currentCacheBufferPtr = cacheBuffer;
+		writePtr = cacheBuffer;
+		writeEnd = cacheBuffer + BUFFERSIZE;
+	}
+	else
+	{
+		fseek(handle,0,SEEK_END);
+		fileSize = static_cast<mp_uint32>(ftell(handle));
+		fseek(handle,0,SEEK_SET);
+		readPtr = readEnd = cacheBuffer;
 	}
 }
 
@@ -401,19 +520,61 @@ bool XMFile::isOpen()
 
 mp_sint32 XMFile::read(void* ptr, mp_sint32 size, mp_sint32 count)
 {
-	unsigned long NumberOfBytesRead = fread(ptr,size,count,handle)*size;
-	bytesRead += NumberOfBytesRead;
-	return (mp_sint32)NumberOfBytesRead;
+	if (writeAccess || handle == NULL || size <= 0 || count <= 0)
+		return 0;
+
+	mp_ubyte* dst = (mp_ubyte*)ptr;
+	mp_uint32 numBytes = size*count;
+	
+	// take what's left in the read ahead buffer first
+	mp_uint32 numRead = (mp_uint32)(readEnd - readPtr);
+	if (numRead > numBytes)
+		numRead = numBytes;
+	memcpy(dst, readPtr, numRead);
+	readPtr += numRead;
+	
+	if (numRead < numBytes)
+	{
+		mp_uint32 numLeft = numBytes - numRead;
+		
+		// large reads go straight to the destination
+		if (numLeft >= BUFFERSIZE)
+		{
+			readPtr = readEnd = cacheBuffer;
+			mp_uint32 res = (mp_uint32)fread(dst + numRead, 1, numLeft, handle);
+			filePos += res;
+			numRead += res;
+		}
+		else
+		{
+			mp_uint32 res = (mp_uint32)fread(cacheBuffer, 1, BUFFERSIZE, handle);
+			filePos += res;
+			readPtr = cacheBuffer;
+			readEnd = cacheBuffer + res;
+			
+			if (numLeft > res)
+				numLeft = res;
+			memcpy(dst + numRead, readPtr, numLeft);
+			readPtr += numLeft;
+			numRead += numLeft;
+		}
+	}
+	
+	// only complete items count, like with fread
+	return (mp_sint32)((numRead / size) * size);
 }
 
 void XMFile::flush()
 {
-	fwrite(cacheBuffer, 1, currentCacheBufferPtr-cacheBuffer, handle);
-	currentCacheBufferPtr = cacheBuffer;
+	fwrite(cacheBuffer, 1, writePtr-cacheBuffer, handle);
+	writePtr = cacheBuffer;
 }
 
 mp_sint32 XMFile::write(const void* ptr, mp_sint32 size, mp_sint32 count)
 {
+	if (!writeAccess || handle == NULL)
+		return -1;
+
 	// Buffer to be written is bigger than our internal cache
 	// => Write through
 	if (size*count > BUFFERSIZE)
@@ -421,60 +582,84 @@ mp_sint32 XMFile::write(const void* ptr, mp_sint32 size, mp_sint32 count)
 		// Flush first
 		flush();
 		unsigned long NumberOfBytesWritten = fwrite(ptr,size,count,handle)*size;
-		bytesRead += NumberOfBytesWritten;
 		return (mp_sint32)NumberOfBytesWritten;
 	}
 
-	// Buffer to be written still fits into our cache buffer
-	if (size*count + currentCacheBufferPtr <= cacheBuffer+BUFFERSIZE)
-	{
-		// Copy into cache
-		memcpy(currentCacheBufferPtr, ptr, size*count);
-		// Advance current cache ptr
-		currentCacheBufferPtr += size*count;
-	}
-	else
-	{
-		// Buffer doesn't fit, flush buffer first
+	// Buffer doesn't fit, flush buffer first
+	if (size*count > writeEnd - writePtr)
 		flush();
-		// Copy into cache
-		memcpy(currentCacheBufferPtr, ptr, size*count);
-		// Advance 
-		currentCacheBufferPtr += size*count;
-	}
+		
+	// Copy into cache
+	memcpy(writePtr, ptr, size*count);
+	// Advance current cache ptr
+	writePtr += size*count;
 	
-	if (currentCacheBufferPtr == cacheBuffer + BUFFERSIZE)
+	if (writePtr == writeEnd)
 		flush();
 
-	bytesRead+=size*count;
 	return size*count;
 }
 
 void XMFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
 {
+	if (handle == NULL)
+		return;
+
 	if (writeAccess)
 	{
 		flush();
 		fflush(handle);
-	}
-		
-	int moveMethod = SEEK_SET;
 
+		int moveMethod = SEEK_SET;
+		long offset = pos;
+		
+		if (seekOffsetType == XMFile::SeekOffsetTypeCurrent)
+		{
+			moveMethod = SEEK_CUR;
+			offset = (mp_sint32)pos;
+		}
+		else if (seekOffsetType == XMFile::SeekOffsetTypeEnd)
+		{
+			moveMethod = SEEK_END;
+			offset = (mp_sint32)pos;
+		}
+
+		fseek(handle,offset,moveMethod);
+		return;
+	}
+	
+	// relative offsets may be negative
 	if (seekOffsetType == XMFile::SeekOffsetTypeCurrent)
-		moveMethod = SEEK_CUR;
+		pos = this->pos() + (mp_sint32)pos;
 	else if (seekOffsetType == XMFile::SeekOffsetTypeEnd)
-		moveMethod = SEEK_END;
-
-	fseek(handle,pos,moveMethod);
+		pos = fileSize + (mp_sint32)pos;
+	
+	// stay in the read ahead buffer if possible
+	mp_uint32 bufferStart = filePos - (mp_uint32)(readEnd - cacheBuffer);
+	if (pos >= bufferStart && pos <= filePos)
+	{
+		readPtr = cacheBuffer + (pos - bufferStart);
+		return;
+	}
+	
+	fseek(handle,pos,SEEK_SET);
+	filePos = static_cast<mp_uint32>(ftell(handle));
+	readPtr = readEnd = cacheBuffer;
 }
 
 mp_uint32 XMFile::pos()
 {
+	if (!writeAccess && handle != NULL)
+		return filePos - (mp_uint32)(readEnd - readPtr);
+	
 	return static_cast<mp_uint32>(ftell(handle));
 }
 
 mp_uint32 XMFile::size()
 {
+	if (!writeAccess)
+		return fileSize;
+
 	mp_uint32 size = 0;
 	mp_uint32 curPos = pos();
 	fseek(handle,0,SEEK_END);
@@ -514,3 +699,279 @@ const char* XMFile::getFileNameASCII()
 }
 
 #endif
+
+//////////////////////////////////////////////////////////////////////////
+// File in memory														//
+//////////////////////////////////////////////////////////////////////////
+#include <new>
+
+#define MAXMEMORYFILESIZE 0x7FFFFFFF
+
+XMMemoryFile::XMMemoryFile(const void* buffer, mp_uint32 size, const SYSCHAR* fileName/* = NULL*/) :
+	XMFileBase(),
+	fileName(fileName),
+	fileNameASCII(NULL),
+	buffer((mp_ubyte*)buffer),
+	bufferSize(size),
+	capacity(0),
+	position(0),
+	writeAccess(false)
+{
+	resetReadWindow();
+}
+
+XMMemoryFile::XMMemoryFile(const SYSCHAR* fileName/* = NULL*/) :
+	XMFileBase(),
+	fileName(fileName),
+	fileNameASCII(NULL),
+	buffer(NULL),
+	bufferSize(0),
+	capacity(0),
+	position(0),
+	writeAccess(true)
+{
+}
+
+void XMMemoryFile::resetReadWindow()
+{
+	if (buffer && position <= bufferSize)
+	{
+		readPtr = buffer + position;
+		readEnd = buffer + bufferSize;
+	}
+	else
+	{
+		readPtr = readEnd = NULL;
+	}
+}
+
+XMMemoryFile::~XMMemoryFile()
+{
+	if (capacity)
+		delete[] buffer;
+		
+	if (fileNameASCII)
+		delete[] fileNameASCII;
+}
+
+bool XMMemoryFile::reserve(mp_uint32 size)
+{
+	if (size <= capacity)
+		return true;
+	
+	// positions and read/write results have to fit into mp_sint32
+	if (size > MAXMEMORYFILESIZE)
+		return false;
+	
+	// grow exponentially to keep lots of small writes cheap
+	mp_uint32 newCapacity = capacity ? capacity : BUFFERSIZE;
+	while (newCapacity < size)
+		newCapacity = newCapacity > MAXMEMORYFILESIZE/2 ? MAXMEMORYFILESIZE : newCapacity << 1;
+		
+	mp_ubyte* newBuffer = new (std::nothrow) mp_ubyte[newCapacity];
+	// doubling might ask for too much, try the exact size
+	if (newBuffer == NULL && newCapacity > size)
+	{
+		newCapacity = size;
+		newBuffer = new (std::nothrow) mp_ubyte[newCapacity];
+	}
+	if (newBuffer == NULL)
+		return false;
+	
+	syncPosition();
+	
+	if (buffer)
+		memcpy(newBuffer, buffer, bufferSize);
+	if (capacity)
+		delete[] buffer;
+		
+	buffer = newBuffer;
+	capacity = newCapacity;
+	resetReadWindow();
+	return true;
+}
+
+mp_sint32 XMMemoryFile::read(void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	syncPosition();
+
+	if (size <= 0 || count <= 0 || position >= bufferSize)
+		return 0;
+
+	// only read complete items, like fread does
+	mp_uint32 numItems = (bufferSize - position) / size;
+	if (numItems > (mp_uint32)count)
+		numItems = count;
+		
+	mp_uint32 numBytes = numItems * size;
+	memcpy(ptr, buffer + position, numBytes);
+	position += numBytes;
+	resetReadWindow();
+	return (mp_sint32)numBytes;
+}
+
+mp_sint32 XMMemoryFile::write(const void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	if (!writeAccess)
+		return -1;
+
+	if (size <= 0 || count <= 0)
+		return 0;
+
+	syncPosition();
+
+	if ((mp_uint32)count > MAXMEMORYFILESIZE / (mp_uint32)size)
+		return -1;
+
+	mp_uint32 numBytes = size*count;
+	if (position > MAXMEMORYFILESIZE - numBytes || !reserve(position + numBytes))
+		return -1;
+	
+	// writing past the end after seeking leaves a gap => zero it 
+	if (position > bufferSize)
+		memset(buffer + bufferSize, 0, position - bufferSize);
+	
+	memcpy(buffer + position, ptr, numBytes);
+	position += numBytes;
+	if (position > bufferSize)
+		bufferSize = position;
+	resetReadWindow();
+		
+	return (mp_sint32)numBytes;
+}
+
+void XMMemoryFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
+{
+	syncPosition();
+
+	if (seekOffsetType == XMFileBase::SeekOffsetTypeCurrent)
+		pos += position;
+	else if (seekOffsetType == XMFileBase::SeekOffsetTypeEnd)
+		pos += bufferSize;
+		
+	position = pos;
+	resetReadWindow();
+}
+
+const SYSCHAR* XMMemoryFile::getFileName()
+{
+	static const SYSCHAR emptyName[] = {0};
+	return fileName ? fileName : emptyName;
+}
+
+const char* XMMemoryFile::getFileNameASCII()
+{
+	if (fileNameASCII)
+		delete[] fileNameASCII;
+
+	const SYSCHAR* name = getFileName();
+	const SYSCHAR* ptr = name;
+	mp_uint32 len = 0;
+	
+	// strip path
+	for (const SYSCHAR* p = name; *p; p++)
+		if (*p == '/' || *p == '\\')
+			ptr = p+1;
+			
+	while (ptr[len])
+		len++;
+	
+	fileNameASCII = new char[len+1];
+	
+	for (mp_uint32 i = 0; i <= len; i++)
+		fileNameASCII[i] = (char)ptr[i];
+	
+	return fileNameASCII;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Memory mapped file													//
+//////////////////////////////////////////////////////////////////////////
+#if !defined(WIN32) && !defined(__amigaos4__) && !defined(__PSP__) && \
+	(defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__))
+#define XMFILE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
+
+XMMappedFile::XMMappedFile(const SYSCHAR* fileName, bool mappedOnly/* = false*/) :
+	XMMemoryFile(NULL, 0, fileName),
+	mappedBuffer(NULL),
+	mappedSize(0)
+{
+#if defined(WIN32)
+	handle = CreateFile(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	mapping = NULL;
+	if (handle != INVALID_HANDLE_VALUE)
+	{
+		mp_uint32 size = GetFileSize(handle, NULL);
+		if (size != INVALID_FILE_SIZE && size)
+			mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping)
+		{
+			mappedBuffer = (mp_ubyte*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (mappedBuffer)
+				mappedSize = size;
+		}
+	}
+#elif defined(XMFILE_MMAP)
+	int fd = open(fileName, O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0 && (mp_int64)st.st_size <= (mp_int64)0xFFFFFFFF)
+		{
+			void* ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (ptr != MAP_FAILED)
+			{
+				mappedBuffer = (mp_ubyte*)ptr;
+				mappedSize = (mp_uint32)st.st_size;
+			}
+		}
+		// the mapping stays valid after closing
+		close(fd);
+	}
+#endif
+
+	if (mappedBuffer)
+	{
+		buffer = mappedBuffer;
+		bufferSize = mappedSize;
+		resetReadWindow();
+		return;
+	}
+
+	if (mappedOnly)
+		return;
+
+	// no memory mapping available => read the entire file
+	XMFile f(fileName);
+	if (!f.isOpen())
+		return;
+	
+	mp_uint32 size = f.size();
+	if (size && reserve(size))
+	{
+		mp_sint32 numRead = f.read(buffer, 1, size);
+		bufferSize = numRead > 0 ? numRead : 0;
+		resetReadWindow();
+	}
+}
+
+XMMappedFile::~XMMappedFile()
+{
+#if defined(WIN32)
+	if (mappedBuffer)
+		UnmapViewOfFile(mappedBuffer);
+	if (mapping)
+		CloseHandle(mapping);
+	if (handle != INVALID_HANDLE_VALUE)
+		CloseHandle(handle);
+#elif defined(XMFILE_MMAP)
+	if (mappedBuffer)
+		munmap(mappedBuffer, mappedSize);
+#endif
+	if (mappedBuffer)
+		buffer = NULL;
+}
@@ -44,6 +44,20 @@ class XMFileBase
 private:
 	mp_dword				baseOffset;
 	
+	mp_ubyte				readByteUnbuffered();
+	mp_uword				readWordUnbuffered();
+	mp_dword				readDwordUnbuffered();
+	void					writeUnbuffered(const mp_ubyte* bytes, mp_sint32 count);
+	
+protected:
+	// Bytes which can be read or written in place without calling
+	// read()/write(). Derived classes set them up and have to take
+	// them into account for pos(), both are empty by default.
+	const mp_ubyte*			readPtr;
+	const mp_ubyte*			readEnd;
+	mp_ubyte*				writePtr;
+	mp_ubyte*				writeEnd;
+	
 public:
 							XMFileBase();
 	virtual					~XMFileBase();
@@ -70,15 +84,83 @@ public:
 	virtual	bool			isOpen() = 0;
 	virtual	bool			isOpenForWriting()  = 0;
 
-	mp_ubyte				readByte();
-	mp_uword				readWord();
-	mp_dword				readDword();
+	// little endian, values which can't be read completely are 0
+	mp_ubyte				readByte()
+	{
+		if (readPtr < readEnd)
+			return *readPtr++;
+		return readByteUnbuffered();
+	}
+	
+	mp_uword				readWord()
+	{
+		if (readEnd - readPtr >= 2)
+		{
+			mp_uword w = (mp_uword)(readPtr[0] | (readPtr[1] << 8));
+			readPtr+=2;
+			return w;
+		}
+		return readWordUnbuffered();
+	}
+	
+	mp_dword				readDword()
+	{
+		if (readEnd - readPtr >= 4)
+		{
+			mp_dword dw = (mp_dword)readPtr[0] | ((mp_dword)readPtr[1] << 8) | 
+						  ((mp_dword)readPtr[2] << 16) | ((mp_dword)readPtr[3] << 24);
+			readPtr+=4;
+			return dw;
+		}
+		return readDwordUnbuffered();
+	}
+	
+	// big endian
+	mp_uword				readWordBE() { mp_uword w = readWord(); return (mp_uword)((w >> 8) | (w << 8)); }
+	mp_dword				readDwordBE() { mp_dword dw = readDword(); return (dw >> 24) | ((dw >> 8) & 0xFF00) | ((dw << 8) & 0xFF0000) | (dw << 24); }
+	
+	// arrays are read in one go and converted in place
 	void					readWords(mp_uword* buffer,mp_sint32 count);
 	void					readDwords(mp_dword* buffer,mp_sint32 count);
+	void					readWordsBE(mp_uword* buffer,mp_sint32 count);
+	void					readDwordsBE(mp_dword* buffer,mp_sint32 count);
 
-	void					writeByte(mp_ubyte b);
-	void					writeWord(mp_uword w);
-	void					writeDword(mp_dword dw);
+	void					writeByte(mp_ubyte b)
+	{
+		if (writePtr < writeEnd)
+			*writePtr++ = b;
+		else
+			writeUnbuffered(&b, 1);
+	}
+	
+	void					writeWord(mp_uword w)
+	{
+		if (writeEnd - writePtr >= 2)
+		{
+			writePtr[0] = (mp_ubyte)w;
+			writePtr[1] = (mp_ubyte)(w>>8);
+			writePtr+=2;
+			return;
+		}
+		mp_ubyte c[2] = {(mp_ubyte)w, (mp_ubyte)(w>>8)};
+		writeUnbuffered(c, 2);
+	}
+	
+	void					writeDword(mp_dword dw)
+	{
+		if (writeEnd - writePtr >= 4)
+		{
+			writePtr[0] = (mp_ubyte)dw;
+			writePtr[1] = (mp_ubyte)(dw>>8);
+			writePtr[2] = (mp_ubyte)(dw>>16);
+			writePtr[3] = (mp_ubyte)(dw>>24);
+			writePtr+=4;
+			return;
+		}
+		mp_ubyte c[4] = {(mp_ubyte)dw, (mp_ubyte)(dw>>8), (mp_ubyte)(dw>>16), (mp_ubyte)(dw>>24)};
+		writeUnbuffered(c, 4);
+	}
+	
 	void					writeWords(const mp_uword* buffer,mp_sint32 count);
 	void					writeDwords(const mp_dword* buffer,mp_sint32 count);
 	
@@ -99,12 +181,17 @@ private:
 	char*			fileNameASCII;
 
 	FHANDLE			handle;
-	mp_uint32		bytesRead;
 	
 	bool			writeAccess;
 	
+	// write cache or read ahead buffer, the part in use is the 
+	// write or read window of XMFileBase
 	mp_ubyte*		cacheBuffer;
-	mp_ubyte*		currentCacheBufferPtr;
+	
+	// when reading: position of the handle, i.e. after the read ahead
+	// buffer, and the size which doesn't change
+	mp_uint32		filePos;
+	mp_uint32		fileSize;
 	
 	void			flush();
 	
@@ -130,4 +217,79 @@ public:
 	static bool				remove(const SYSCHAR* file);
 };
 
+//////////////////////////////////////////////////////////////////////////
+// File in memory:														//
+// Either reads from an existing buffer (which is not copied and must	//
+// stay valid) or writes to a buffer which grows as needed. 			//
+// Written data can be read back after seeking.							//
+//////////////////////////////////////////////////////////////////////////
+class XMMemoryFile : public XMFileBase
+{
+protected:
+	const SYSCHAR*	fileName;
+
+	char*			fileNameASCII;
+
+	mp_ubyte*		buffer;
+	mp_uint32		bufferSize;
+	mp_uint32		capacity;			// allocated size, 0 if the buffer is not owned
+	mp_uint32		position;
+
+	bool			writeAccess;
+	
+	// the read window of XMFileBase reaches from position to the end of
+	// the data, position is only updated from it when needed
+	void			syncPosition() { if (readEnd) position = (mp_uint32)(readPtr - buffer); }
+	void			resetReadWindow();
+	
+public:
+							XMMemoryFile(const void* buffer, mp_uint32 size, const SYSCHAR* fileName = NULL);
+							XMMemoryFile(const SYSCHAR* fileName = NULL);
+	virtual					~XMMemoryFile();
+	
+	virtual mp_sint32		read(void* ptr,mp_sint32 size,mp_sint32 count);
+	virtual mp_sint32		write(const void* ptr,mp_sint32 size,mp_sint32 count);
+	
+	virtual void			seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType = SeekOffsetTypeStart);
+	virtual mp_uint32		pos() { syncPosition(); return position; }
+	virtual mp_uint32		size() { return bufferSize; }
+	
+	virtual const SYSCHAR*  getFileName();
+	
+	virtual const char*		getFileNameASCII();
+	
+	virtual bool			isOpen() { return buffer != NULL || writeAccess; }
+	virtual bool			isOpenForWriting() { return writeAccess; }
+	
+	const mp_ubyte*			getBuffer() const { return buffer; }
+	
+	// drop contents, keeps the allocated memory for writing again
+	void					clear() { bufferSize = position = 0; resetReadWindow(); }
+	
+	// make room for size bytes, saves growing step by step when the final size is known
+	bool					reserve(mp_uint32 size);
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Read only file mapped into memory, falls back to reading the entire	//
+// file into memory on systems without memory mapped files unless		//
+// mappedOnly is set (the file is not open then)						//
+//////////////////////////////////////////////////////////////////////////
+class XMMappedFile : public XMMemoryFile
+{
+private:
+#ifdef WIN32
+	HANDLE			handle;
+	HANDLE			mapping;
+#endif
+	mp_ubyte*		mappedBuffer;
+	mp_uint32		mappedSize;
+	
+public:
+							XMMappedFile(const SYSCHAR* fileName, bool mappedOnly = false);
+	virtual					~XMMappedFile();
+	
+	bool					isMapped() const { return mappedBuffer != NULL; }
+};
+
 #endif
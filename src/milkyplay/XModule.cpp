@@ -35,6 +35,8 @@
  */
 #include "XModule.h"
 #include "Loaders.h"
+#include "ParallelFor.h"
+#include <atomic>
 
 #undef VERBOSE
 
@@ -42,6 +44,97 @@
 	#include <stdio.h>
 #endif
 
+// sample data starts on a cache line within an arena
+#define ARENAALIGNMENT	64
+
+// one block for all samples of a module, it is released together with
+// the last sample carved from it (samples can move between modules), so
+// a single sample that outlives the others keeps the whole file-sized
+// block allocated
+struct TSampleArena
+{
+	mp_ubyte* mem;
+	mp_ubyte* base;
+	mp_uint32 size;
+	mp_uint32 used;
+	std::atomic<mp_uint32> numRefs;
+};
+
+static TSampleArena* createSampleArena(mp_uint32 size)
+{
+	TSampleArena* arena = new TSampleArena;
+	arena->mem = new mp_ubyte[size + ARENAALIGNMENT - 1];
+	arena->base = (mp_ubyte*)(((size_t)arena->mem + ARENAALIGNMENT - 1) & ~(size_t)(ARENAALIGNMENT - 1));
+	arena->size = size;
+	arena->used = 0;
+	// held by the creator until it stops allocating from it
+	arena->numRefs = 1;
+	return arena;
+}
+
+static void releaseSampleArena(TSampleArena* arena)
+{
+	if (--arena->numRefs == 0)
+	{
+		delete[] arena->mem;
+		delete arena;
+	}
+}
+
+mp_ubyte* TXMSample::allocPaddedMem(mp_uint32 size, TSampleArena* arena/* = NULL*/)
+{
+	mp_ubyte* result = NULL;
+	
+	if (arena)
+	{
+		const mp_uint32 front = MemHeaderSpace + LeadingPadding;
+		mp_uint32 start = ((arena->used + front + ARENAALIGNMENT - 1) & ~(ARENAALIGNMENT - 1)) - front;
+		if (start + front + size + TrailingPadding <= arena->size && start + front + size >= start)
+		{
+			result = arena->base + start;
+			arena->used = start + front + size + TrailingPadding;
+			arena->numRefs++;
+		}
+		else
+		{
+			arena = NULL;
+		}
+	}
+	
+	if (result == NULL)
+		result = new mp_ubyte[MemHeaderSpace + getPaddedSize(size)];
+	
+	if (result == NULL)
+		return NULL;
+	
+	TMemHeader* memHeader = (TMemHeader*)result;
+	memHeader->arena = arena;
+	memHeader->poolSlot = 0;
+	result += MemHeaderSpace;
+	
+	// clear out padding space
+	memset(result, 0, TXMSample::LeadingPadding);
+	memset(result+size+TXMSample::LeadingPadding, 0, TXMSample::TrailingPadding);
+	
+	TLoopDoubleBuffProps* loopBufferProps = (TLoopDoubleBuffProps*)result;
+	loopBufferProps->samplesize = size;
+	
+	return result + TXMSample::LeadingPadding;
+}
+
+void TXMSample::freePaddedMem(mp_ubyte* mem)
+{
+	// behave safely on NULL
+	if (mem == NULL)
+		return;
+	
+	TMemHeader* memHeader = getMemHeader(mem);
+	if (memHeader->arena)
+		releaseSampleArena(memHeader->arena);
+	else
+		delete[] (mp_ubyte*)memHeader;
+}
+
 // heavy processing removes some of the nasty clicks found
 // in 669 and PLM songs (found in 8 bit samples only)
 void TXMSample::smoothLooping()
@@ -429,9 +522,161 @@ void TXMSample::setSampleValue(mp_ubyte* sample, mp_uint32 index, mp_sint32 valu
 }
 
 
+// plain loops without branches on the sample type, so the compiler can vectorize them
+template<class T>
+static void convertToFloat(const T* src, float* dest, mp_uint32 count, float posScale, float negScale)
+{
+	for (mp_uint32 i = 0; i < count; i++)
+	{
+		float f = (float)src[i];
+		dest[i] = f * (f > 0.0f ? posScale : negScale);
+	}
+}
+
+template<class T>
+static void convertFromFloat(const float* src, T* dest, mp_uint32 count, float posScale, float negScale)
+{
+	for (mp_uint32 i = 0; i < count; i++)
+	{
+		float f = src[i];
+		f = f > 1.0f ? 1.0f : (f < -1.0f ? -1.0f : f);
+		dest[i] = f > 0.0f ? (T)(f*posScale+0.5f) : (T)(f*negScale-0.5f);
+	}
+}
+
+void TXMSample::readFloat(mp_uint32 index, mp_uint32 count, float* dest)
+{
+	if (type & 16)
+		convertToFloat(((mp_sword*)sample)+index, dest, count, 1.0f/32767.0f, 1.0f/32768.0f);
+	else
+		convertToFloat(sample+index, dest, count, 1.0f/127.0f, 1.0f/128.0f);
+
+	// after the loop end the sample holds the smoothed copy, take the real data from the double buffer
+	mp_uint32 loopend = loopstart + looplen;
+	if ((type & 3) && index < loopend + LoopAreaBackupSize && index + count > loopend)
+	{
+		mp_uint32 end = index + count < loopend + LoopAreaBackupSize ? index + count : loopend + LoopAreaBackupSize;
+		for (mp_uint32 i = index > loopend ? index : loopend; i < end; i++)
+		{
+			float f = (float)getSampleValue(i);
+			if (type & 16)
+				dest[i - index] = f * (f > 0.0f ? 1.0f/32767.0f : 1.0f/32768.0f);
+			else
+				dest[i - index] = f * (f > 0.0f ? 1.0f/127.0f : 1.0f/128.0f);
+		}
+	}
+}
+
+void TXMSample::writeFloat(mp_uint32 index, mp_uint32 count, const float* src)
+{
+	// touching the loop areas invalidates the smoothing, put the real data back
+	// into the sample first so everything can be written in one go
+	mp_uint32 loopend = loopstart + looplen;
+	if ((type & 3) && 
+		((index < loopstart + LoopAreaBackupSize && index + count > loopstart) ||
+		 (index < loopend + LoopAreaBackupSize && index + count > loopend)))
+	{
+		restoreOriginalState();
+	}
+
+	if (type & 16)
+		convertFromFloat(src, ((mp_sword*)sample)+index, count, 32767.0f, 32768.0f);
+	else
+		convertFromFloat(src, sample+index, count, 127.0f, 128.0f);
+}
+
+void TXMSample::readSamples(mp_uint32 index, mp_uint32 count, void* dest)
+{
+	if (type & 16)
+		memcpy(dest, ((mp_sword*)sample)+index, count*2);
+	else
+		memcpy(dest, sample+index, count);
+
+	mp_uint32 loopend = loopstart + looplen;
+	if ((type & 3) && index < loopend + LoopAreaBackupSize && index + count > loopend)
+	{
+		mp_uint32 end = index + count < loopend + LoopAreaBackupSize ? index + count : loopend + LoopAreaBackupSize;
+		for (mp_uint32 i = index > loopend ? index : loopend; i < end; i++)
+		{
+			if (type & 16)
+				((mp_sword*)dest)[i - index] = (mp_sword)getSampleValue(i);
+			else
+				((mp_sbyte*)dest)[i - index] = (mp_sbyte)getSampleValue(i);
+		}
+	}
+}
+
 #define FUNCTION_SUCCESS	MP_OK
 #define FUNCTION_FAILED		MP_LOADER_FAILED
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Bit reader shared by the packed sample loaders:
+//
+// Bit fields are read LSB first from a little endian byte stream. The bits
+// are kept in a 64 bit buffer which is refilled one dword at a time, so
+// most reads are a shift and a mask. Reading past the end yields zeros.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class BitReader
+{
+private:
+	const mp_ubyte* data;
+	mp_uint32 size;
+	// next byte to go into the bit buffer
+	mp_uint32 position;
+	mp_uint64 bits;
+	mp_uint32 numBits;
+	
+	void refill()
+	{
+		if (position + 4 <= size)
+		{
+			const mp_ubyte* ptr = data + position;
+			mp_uint32 word = (mp_uint32)ptr[0] | ((mp_uint32)ptr[1] << 8) | ((mp_uint32)ptr[2] << 16) | ((mp_uint32)ptr[3] << 24);
+			bits |= (mp_uint64)word << numBits;
+			numBits += 32;
+			position += 4;
+		}
+		else
+		{
+			// the last few bytes one by one, zeros behind them
+			while (numBits <= 56)
+			{
+				if (position < size)
+					bits |= (mp_uint64)data[position] << numBits;
+				numBits += 8;
+				position++;
+			}
+		}
+	}
+	
+public:
+	BitReader(const mp_ubyte* data = NULL, mp_uint32 size = 0) :
+		data(data),
+		size(size),
+		position(0),
+		bits(0),
+		numBits(0)
+	{
+	}
+	
+	// count must be 1 to 32
+	mp_uint32 read(mp_uint32 count)
+	{
+		if (numBits < count)
+			refill();
+		
+		mp_uint32 value = (mp_uint32)(bits & ((((mp_uint64)1) << count) - 1));
+		bits >>= count;
+		numBits -= count;
+		return value;
+	}
+	
+	// number of bytes which have been read completely
+	mp_uint32 getBytePosition() const { return position - ((numBits + 7) >> 3); }
+};
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 // IT sample loading helper class
@@ -440,9 +685,8 @@ void TXMSample::setSampleValue(mp_ubyte* sample, mp_uint32 index, mp_sint32 valu
 class ITSampleLoader : public XModule::SampleLoader
 {
 private:
-	mp_dword* source_buffer;			/* source buffer */
-	mp_dword* source_position;			/* actual reading position */
-	mp_ubyte source_remaining_bits;		/* bits remaining in read dword */
+	mp_ubyte* source_buffer;			/* source buffer, reused for all blocks */
+	mp_uint32 source_capacity;
 	
 	bool it215;
 	
@@ -450,22 +694,19 @@ public:
 		ITSampleLoader(XMFileBase& file, bool isIt215 = false) :
 		SampleLoader(file),
 		source_buffer(NULL),
-		source_position(NULL),
-		source_remaining_bits(0),
+		source_capacity(0),
 		it215(isIt215)
 	{
 	}
 	
 	virtual ~ITSampleLoader() 
 	{
-		free_IT_compressed_block();
+		delete[] source_buffer;
 	}
 	
-	mp_dword read_n_bits_from_IT_compressed_block(mp_ubyte p_bits_to_read);
-	
-	mp_sint32 read_IT_compressed_block ();
-	
-	void free_IT_compressed_block ();
+	// reads the next block into source_buffer, the bit reader for it is
+	// kept local to the unpacking loop so it can live in registers
+	mp_sint32 read_IT_compressed_block (mp_uword& size);
 	
 	// second parameter is ignored
 	virtual mp_sint32 load_sample_8bits(void* p_dest_buffer, mp_sint32 compressedSize, mp_sint32 p_buffsize);
@@ -480,103 +721,29 @@ public:
 
 * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE * NOTICE */
 
-mp_dword ITSampleLoader::read_n_bits_from_IT_compressed_block (mp_ubyte p_bits_to_read) {				
-	
-    mp_dword aux_return_value;
-	
-    mp_dword val;
-    mp_ubyte *buffer=(mp_ubyte*)source_position;
-	
-    if ( p_bits_to_read <= source_remaining_bits ) {
-		
-    	val=buffer[3];
-		val<<=8;
-    	val|=buffer[2];
-		val<<=8;
-    	val|=buffer[1];
-		val<<=8;
-    	val|=buffer[0];
-		
-		aux_return_value = val & ((1 << p_bits_to_read) - 1);
-		val >>= p_bits_to_read;
-		source_remaining_bits -= p_bits_to_read;
-		
-		buffer[3]=val>>24;
-    	buffer[2]=(val>>16)&0xFF;
-    	buffer[1]=(val>>8)&0xFF;
-    	buffer[0]=(val)&0xFF;
-		
-    } else {
-    	aux_return_value=buffer[3];
-		aux_return_value<<=8;
-    	aux_return_value|=buffer[2];
-		aux_return_value<<=8;
-    	aux_return_value|=buffer[1];
-		aux_return_value<<=8;
-    	aux_return_value|=buffer[0];
-		
-		mp_dword nbits = p_bits_to_read - source_remaining_bits;
-		//	aux_return_value = *source_position;
-		source_position++;
-        buffer+=4;
-    	val=buffer[3];
-		val<<=8;
-    	val|=buffer[2];
-		val<<=8;
-    	val|=buffer[1];
-		val<<=8;
-    	val|=buffer[0];
-		aux_return_value |= ((val & ((1 << nbits) - 1)) << source_remaining_bits);
-		val >>= nbits;
-		source_remaining_bits = 32 - nbits;
-		buffer[3]=val>>24;
-    	buffer[2]=(val>>16)&0xFF;
-    	buffer[1]=(val>>8)&0xFF;
-    	buffer[0]=(val)&0xFF;
-		
-    }
-	
-    return aux_return_value;
-}
-
-mp_sint32 ITSampleLoader::read_IT_compressed_block () {				
-
-	mp_uword size;
+mp_sint32 ITSampleLoader::read_IT_compressed_block (mp_uword& size) {				
 
 	size=f.readWord();
 
 	if (f.isEOF()) return FUNCTION_FAILED;
 
-	mp_sint32 finalSize = 4 * ((size >> 2) + 2);
-	source_buffer = (mp_dword*)new mp_ubyte[finalSize];
-
-	if (source_buffer==NULL) return FUNCTION_FAILED;
-
-	memset(source_buffer, 0, finalSize);
+	if (size > source_capacity)
+	{
+		delete[] source_buffer;
+		// a block can't be larger than this anyway
+		source_capacity = 0x10000;
+		source_buffer = new mp_ubyte[source_capacity];
+	}
 
 	mp_sint32 res = f.read(source_buffer, 1, size);
 	if (res != size)
 	{
-		delete[] (mp_ubyte*)source_buffer;
-		source_buffer = NULL;
 		return FUNCTION_FAILED;
 	}
 
-	source_position = source_buffer;
-	source_remaining_bits = 32;
-
 	return FUNCTION_SUCCESS;
 }
 
-void ITSampleLoader::free_IT_compressed_block () {				
-
-
-	if (source_buffer!=NULL) delete[] (mp_ubyte*)source_buffer;
-
-	source_buffer = NULL;
-
-}
-
 mp_sint32 ITSampleLoader::load_sample_8bits(void* p_dest_buffer, mp_sint32 compressedSize, mp_sint32 p_buffsize) {
 	
 	mp_sbyte *dest_buffer;		/* destination buffer which will be returned */
@@ -587,6 +754,7 @@ mp_sint32 ITSampleLoader::load_sample_8bits(void* p_dest_buffer, mp_sint32 compr
 	mp_sbyte d1, d2;		/* integrator buffers (d2 for it2.15) */
 	mp_sbyte *dest_position;		/* position in output buffer */
 	mp_sbyte v;			/* sample value */
+	mp_uword block_size;		/* length of compressed data block in bytes */
 
 	dest_buffer = (mp_sbyte *) p_dest_buffer;
 
@@ -600,7 +768,9 @@ mp_sint32 ITSampleLoader::load_sample_8bits(void* p_dest_buffer, mp_sint32 compr
 	
 	while (p_buffsize) {
 	/* read a new block of compressed data and reset variables */
-		if ( read_IT_compressed_block() ) return FUNCTION_FAILED;
+		if ( read_IT_compressed_block(block_size) ) return FUNCTION_FAILED;
+
+		BitReader bits(source_buffer, block_size);
 
 
 		block_length = (p_buffsize < 0x8000) ? p_buffsize : 0x8000;
@@ -614,13 +784,13 @@ mp_sint32 ITSampleLoader::load_sample_8bits(void* p_dest_buffer, mp_sint32 compr
 	/* now uncompress the data block */
 		while ( block_position < block_length ) {
 
-			aux_value = read_n_bits_from_IT_compressed_block(bit_width);			/* read bits */
+			aux_value = bits.read(bit_width);			/* read bits */
 
 			if ( bit_width < 7 ) { /* method 1 (1-6 bits) */
 
 				if ( aux_value == (1 << (bit_width - 1)) ) { /* check for "100..." */
 
-					aux_value = read_n_bits_from_IT_compressed_block(3) + 1; /* yes -> read new width; */
+					aux_value = bits.read(3) + 1; /* yes -> read new width; */
 		    			bit_width = (aux_value < bit_width) ? aux_value : aux_value + 1;
 							/* and expand it */
 		    			continue; /* ... next value */
@@ -650,8 +820,6 @@ mp_sint32 ITSampleLoader::load_sample_8bits(void* p_dest_buffer, mp_sint32 compr
 
 			} else { /* illegal width, abort */
 
-				free_IT_compressed_block();
-			
 				return FUNCTION_FAILED;
 			}
 
@@ -676,7 +844,6 @@ mp_sint32 ITSampleLoader::load_sample_8bits(void* p_dest_buffer, mp_sint32 compr
 		}
 
 		/* now subtract block lenght from total length and go on */
-		free_IT_compressed_block();
 		p_buffsize -= block_length;
 	}
 
@@ -694,6 +861,7 @@ mp_sint32 ITSampleLoader::load_sample_16bits(void* p_dest_buffer, mp_sint32 comp
 	mp_sword d1, d2;		/* integrator buffers (d2 for it2.15) */
 	mp_sword *dest_position;		/* position in output buffer */
 	mp_sword v;			/* sample value */
+	mp_uword block_size;		/* length of compressed data block in bytes */
 
 	dest_buffer = (mp_sword *) p_dest_buffer;
 
@@ -705,11 +873,13 @@ mp_sint32 ITSampleLoader::load_sample_16bits(void* p_dest_buffer, mp_sint32 comp
 
 	while (p_buffsize) {
 	/* read a new block of compressed data and reset variables */
-		if ( read_IT_compressed_block() ) {
+		if ( read_IT_compressed_block(block_size) ) {
 
 			return FUNCTION_FAILED;
 		}
 
+		BitReader bits(source_buffer, block_size);
+
 
 		block_length = (p_buffsize < 0x4000) ? p_buffsize : 0x4000;
 
@@ -721,13 +891,13 @@ mp_sint32 ITSampleLoader::load_sample_16bits(void* p_dest_buffer, mp_sint32 comp
 
 		while ( block_position < block_length ) {
 
-			aux_value = read_n_bits_from_IT_compressed_block(bit_width);			/* read bits */
+			aux_value = bits.read(bit_width);			/* read bits */
 
 			if ( bit_width < 7 ) { /* method 1 (1-6 bits) */
 
 				if ( (signed)aux_value == (1 << (bit_width - 1)) ) { /* check for "100..." */
 
-					aux_value = read_n_bits_from_IT_compressed_block(4) + 1; /* yes -> read new width; */
+					aux_value = bits.read(4) + 1; /* yes -> read new width; */
 		    			bit_width = (aux_value < bit_width) ? aux_value : aux_value + 1;
 							/* and expand it */
 		    			continue; /* ... next value */
@@ -758,8 +928,6 @@ mp_sint32 ITSampleLoader::load_sample_16bits(void* p_dest_buffer, mp_sint32 comp
 
 			 	//ERROR("Sample has illegal BitWidth ");
 
-				free_IT_compressed_block();
-			
 				return FUNCTION_FAILED;
 			}
 
@@ -784,7 +952,6 @@ mp_sint32 ITSampleLoader::load_sample_16bits(void* p_dest_buffer, mp_sint32 comp
 		}
 
 		/* now subtract block lenght from total length and go on */
-		free_IT_compressed_block();
 		p_buffsize -= block_length;
 	}
 
@@ -805,40 +972,24 @@ private:
 	mp_ubyte* dstBuffer;
 	
 	// MDL unpacking
-	static mp_ubyte readbits(mp_ubyte* buffer,mp_uint32& bitcount,mp_uint32& bytecount,mp_sint32 numbits)
-	{
-		mp_ubyte val=0,bitti=0;
-		for (mp_sint32 n=0;n<numbits;n++){
-			val+=((buffer[bytecount]>>bitcount)&1)<<(bitti++);
-			bitcount++;
-			if (bitcount==8) {
-				bitcount=0;
-				bytecount++;
-			}
-		}
-		return val;
-	}
-	
-	// MDL unpacking
-	static mp_ubyte depackbyte(mp_ubyte* packed,mp_uint32& bitcount,mp_uint32& bytecount) 
+	static mp_ubyte depackbyte(BitReader& bits, mp_uint32 size) 
 	{
 		mp_ubyte b = 0;
-		mp_ubyte sign = readbits(packed,bitcount,bytecount,1);
-		mp_ubyte bit = readbits(packed,bitcount,bytecount,1);
-		
-		if (bit) {
-			b = readbits(packed,bitcount,bytecount,3);
-			goto next;
-		}
-		else b=8;
-loop:;
-		bit=readbits(packed,bitcount,bytecount,1);
-		if (!bit) {
-			b+=16;
-			goto loop;
-		}
-		else b+=readbits(packed,bitcount,bytecount,4);
-next:;
+		mp_ubyte sign = bits.read(1);
+		
+		if (bits.read(1))
+		{
+			b = bits.read(3);
+		}
+		else
+		{
+			b = 8;
+			// corrupt data would keep us here forever, only zeros follow the end
+			while (!bits.read(1) && bits.getBytePosition() < size)
+				b += 16;
+			b += bits.read(4);
+		}
+		
 		if (sign) b^=255;
 		
 		return b;
@@ -895,13 +1046,13 @@ mp_sint32 MDLSampleLoader::load_sample_8bits(void* buffer, mp_sint32 size, mp_si
 	
 	memset(dstBuffer,0,length+64);
 	
-	mp_uint32 bitcount=0, bytecount=0;
+	BitReader bits(tmpBuffer, size);
 	
 	mp_sint32 i=0;
 	
-	while (bytecount < (unsigned)size && i < length) 
+	while (bits.getBytePosition() < (unsigned)size && i < length) 
 	{
-		dstBuffer[i++]=depackbyte((mp_ubyte*)tmpBuffer,bitcount,bytecount);							
+		dstBuffer[i++]=depackbyte(bits,size);
 	}
 	
 	mp_sbyte b1=0;
@@ -932,14 +1083,14 @@ mp_sint32 MDLSampleLoader::load_sample_16bits(void* buffer, mp_sint32 size, mp_s
 	
 	memset(dstBuffer,0,length+64);
 	
-	mp_uint32 bitcount=0, bytecount=0;
+	BitReader bits(tmpBuffer, size);
 	
 	mp_sint32 i=0;
 	
-	while (bytecount<(unsigned)size && i < length*2) 
+	while (bits.getBytePosition() < (unsigned)size && i < length*2) 
 	{
-		dstBuffer[i++]=readbits((mp_ubyte*)tmpBuffer,bitcount,bytecount,8);
-		dstBuffer[i++]=depackbyte((mp_ubyte*)tmpBuffer,bitcount,bytecount);
+		dstBuffer[i++]=bits.read(8);
+		dstBuffer[i++]=depackbyte(bits,size);
 	}
 	
 	mp_sbyte b1=0;
@@ -1009,15 +1160,14 @@ public:
 		// read compressed data
 		f.read(tmpBuffer, 1, blockSize);
 	
+		BitReader bits(tmpBuffer, blockSize);
+		
 		mp_sbyte b1 = 0;
 		
 		mp_sbyte* srcPtr = (mp_sbyte*)p_dest_buffer;
-		for (mp_uint32 i = 0; i < blockSize; i++)
+		for (mp_uint32 i = 0; i < blockSize*2; i++)
 		{
-			mp_uint32 index = tmpBuffer[i] & 0xF;
-			*srcPtr++ = b1+=deltaValues[index];
-			index = tmpBuffer[i] >> 4;
-			*srcPtr++ = b1+=deltaValues[index];
+			*srcPtr++ = b1+=deltaValues[bits.read(4)];
 		}
 	
 		return FUNCTION_SUCCESS;
@@ -1195,50 +1345,89 @@ const TXMPattern& TXMPattern::operator=(const TXMPattern& src)
 
 // Constructor for loader manager (private)
 XModule::LoaderManager::LoaderManager() :
-		loaders(NULL),
 		numLoaders(0),
-		numAllocatedLoaders(0),
-		iteratorCounter(-1)
+		numSignatures(0),
+		otherSignatures(-1)
 {
+	for (mp_sint32 i = 0; i < 256; i++)
+		firstByteIndex[i] = -1;
+	for (mp_sint32 i = 0; i < MaxLoaders/32; i++)
+		guessingLoaders[i] = 0;
+
 #ifndef MP_XMONLY 
 	registerLoader(new Loader669(), ModuleType_669);
+	addSignature(0, "if", 2);
+	addSignature(0, "JN", 2);
 	registerLoader(new LoaderAMF_1(), ModuleType_AMF);
+	addSignature(0, "ASYLUM Music Format", 19);
 	registerLoader(new LoaderAMF_2(), ModuleType_AMF);
+	addSignature(0, "DMF", 3);
 	registerLoader(new LoaderAMSv1(), ModuleType_AMS);
+	addSignature(0, "Extreme\x30\x1", 9);
 	registerLoader(new LoaderAMSv2(), ModuleType_AMS);
+	addSignature(0, "AMShdr\x1a", 7);
 	registerLoader(new LoaderCBA(), ModuleType_CBA);
+	addSignature(0, "CBA\xF9", 4);
 	registerLoader(new LoaderDBM(), ModuleType_DBM);
+	addSignature(0, "DBM0", 4);
 	registerLoader(new LoaderDIGI(), ModuleType_DIGI);
+	// including the terminating zero
+	addSignature(0, "DIGI Booster module", 20);
 	registerLoader(new LoaderDSMv1(), ModuleType_DSM);
+	addSignature(0, "DSM\x10", 4);
 	registerLoader(new LoaderDSMv2(), ModuleType_DSM);
+	addSignature(8, "DSMFSONG", 8);
 	registerLoader(new LoaderDSm(), ModuleType_DSm);
+	addSignature(0, "DSm\x1A\x20", 5);
 	registerLoader(new LoaderDTM_1(), ModuleType_DTM_1);
+	addSignature(0, "SONG", 4);
 	registerLoader(new LoaderDTM_2(), ModuleType_DTM_2);
+	addSignature(0, "D.T.", 4);
 	registerLoader(new LoaderFAR(), ModuleType_FAR);
+	addSignature(0, "FAR\xFE", 4);
 	registerLoader(new LoaderGDM(), ModuleType_GDM);
+	addSignature(0, "GDM\xFE", 4);
 	registerLoader(new LoaderIMF(), ModuleType_IMF);
+	addSignature(0x3c, "IM10", 4);
 	registerLoader(new LoaderIT(), ModuleType_IT);
+	addSignature(0, "IMPM", 4);
 	//registerLoader(new LoaderFNK(), funk format sucks
 	registerLoader(new LoaderMDL(), ModuleType_MDL);
+	addSignature(0, "DMDL", 4);
 	registerLoader(new LoaderMTM(), ModuleType_MTM);
+	addSignature(0, "MTM\x10", 4);
 	registerLoader(new LoaderMXM(), ModuleType_MXM);
+	addSignature(0, "MXM", 3);
 	registerLoader(new LoaderOKT(), ModuleType_OKT);
+	addSignature(0, "OKTASONG", 8);
 	registerLoader(new LoaderPLM(), ModuleType_PLM);
+	addSignature(0, "PLM\x1A", 4);
 	registerLoader(new LoaderPSMv1(), ModuleType_PSM);
+	addSignature(0, "PSM\xFE", 4);
 	registerLoader(new LoaderPSMv2(), ModuleType_PSM);
+	addSignature(0, "PSM\x20", 4);
 	registerLoader(new LoaderPTM(), ModuleType_PTM);
+	addSignature(44, "PTMF", 4);
 	registerLoader(new LoaderS3M(), ModuleType_S3M);
+	addSignature(0x2C, "SCRM", 4);
 	registerLoader(new LoaderSTM(), ModuleType_STM);
+	addSignature(20, "!Scream!", 8);
+	addSignature(20, "BMOD2STM", 8);
 	registerLoader(new LoaderSFX(), ModuleType_SFX);
+	addSignature(60, "SONG", 4);
 	registerLoader(new LoaderUNI(), ModuleType_UNI);
+	addSignature(0, "UN0", 3);
 	registerLoader(new LoaderULT(), ModuleType_ULT);	
+	addSignature(0, "MAS_UTrack_V00", 14);
 	registerLoader(new LoaderXM(), ModuleType_XM);	
+	addSignature(0, "Extended Module:", 16);
 	// Game Music Creator may not be recognized perfectly
 	registerLoader(new LoaderGMC(), ModuleType_GMC);
 	// Last loader is MOD because there is a slight chance that other formats will be misinterpreted as 15 ins. MODs
 	registerLoader(new LoaderMOD(), ModuleType_MOD);
 #else
 	registerLoader(new LoaderXM(), ModuleType_XM);	
+	addSignature(0, "Extended Module:", 16);
 #endif
 }
 
@@ -1246,50 +1435,84 @@ XModule::LoaderManager::~LoaderManager()
 {
 	for (mp_uint32 i = 0; i < numLoaders; i++)
 		delete loaders[i].loader;
-		
-	delete[] loaders;
+}
+
+const XModule::LoaderManager& XModule::LoaderManager::getInstance()
+{
+	// the loaders don't keep any state, so one set serves all threads
+	static const LoaderManager loaderManager;
+	return loaderManager;
 }
 
 void XModule::LoaderManager::registerLoader(LoaderInterface* loader, ModuleTypes type)
 {
-	if (numLoaders+1 > numAllocatedLoaders)
-	{
-		numAllocatedLoaders+=16;
-		
-		TLoaderInfo* newLoaders = new TLoaderInfo[numAllocatedLoaders];
-		for (mp_uint32 i = 0; i < numLoaders; i++)
-			newLoaders[i] = loaders[i];
-			
-		delete[] loaders;
-		loaders = newLoaders;
-	}
+	ASSERT(numLoaders < MaxLoaders);
 	
 	loaders[numLoaders].loader = loader;
 	loaders[numLoaders].moduleType = type;
+	guessingLoaders[numLoaders >> 5] |= 1u << (numLoaders & 31);
 	
 	numLoaders++;
 }
 
-XModule::TLoaderInfo* XModule::LoaderManager::getFirstLoaderInfo()
+void XModule::LoaderManager::addSignature(mp_uint32 offset, const char* magic, mp_uint32 length)
 {
-	if (numLoaders)
+	ASSERT(numLoaders && numSignatures < MaxSignatures && offset + length <= IdentificationBufferSize);
+
+	TSignature& signature = signatures[numSignatures];
+	signature.offset = offset;
+	signature.magic = magic;
+	signature.length = length;
+	signature.loaderIndex = numLoaders - 1;
+	
+	if (offset == 0)
 	{
-		iteratorCounter = 0;
-		return loaders;
+		signature.next = firstByteIndex[(mp_ubyte)magic[0]];
+		firstByteIndex[(mp_ubyte)magic[0]] = numSignatures;
 	}
-	else return NULL;
+	else
+	{
+		signature.next = otherSignatures;
+		otherSignatures = numSignatures;
+	}
+	
+	guessingLoaders[(numLoaders - 1) >> 5] &= ~(1u << ((numLoaders - 1) & 31));
+	numSignatures++;
 }
 
-XModule::TLoaderInfo* XModule::LoaderManager::getNextLoaderInfo()
+const XModule::TLoaderInfo* XModule::LoaderManager::identify(const mp_ubyte* buffer, const char** id/* = NULL*/) const
 {
-	iteratorCounter++;
-	if (iteratorCounter < (signed)numLoaders)
-		return loaders+iteratorCounter;
-	else
+	mp_uint32 candidates[MaxLoaders/32];
+	for (mp_sint32 i = 0; i < MaxLoaders/32; i++)
+		candidates[i] = guessingLoaders[i];
+	
+	for (mp_sint32 i = firstByteIndex[buffer[0]]; i != -1; i = signatures[i].next)
+		if (!memcmp(buffer, signatures[i].magic, signatures[i].length))
+			candidates[signatures[i].loaderIndex >> 5] |= 1u << (signatures[i].loaderIndex & 31);
+
+	for (mp_sint32 i = otherSignatures; i != -1; i = signatures[i].next)
+		if (!memcmp(buffer + signatures[i].offset, signatures[i].magic, signatures[i].length))
+			candidates[signatures[i].loaderIndex >> 5] |= 1u << (signatures[i].loaderIndex & 31);
+
+	// keep the registration order, some files are accepted by more than one loader
+	for (mp_sint32 word = 0; word < MaxLoaders/32; word++)
 	{
-		iteratorCounter = -1;
-		return NULL;
+		for (mp_uint32 bits = candidates[word], i = word << 5; bits; bits >>= 1, i++)
+		{
+			if (!(bits & 1))
+				continue;
+			
+			const char* result = loaders[i].loader->identifyModule(buffer);
+			if (result)
+			{
+				if (id)
+					*id = result;
+				return loaders + i;
+			}
+		}
 	}
+	
+	return NULL;
 }
 
 const mp_sint32 XModule::periods[12] = {1712,1616,1524,1440,1356,1280,1208,1140,1076,1016,960,907};
@@ -1419,9 +1642,6 @@ mp_uint32 XModule::amigaPeriodToNote(mp_uint32 period)
 ////////////////////////////////////////////
 bool XModule::loadSample(XMFileBase& f,void* buffer,mp_uint32 size,mp_uint32 length,mp_sint32 flags /* = ST_DEFAULT */)
 {
-	mp_ubyte* tmpBuffer = NULL;
-	mp_ubyte* dstBuffer = NULL;
-	
 	// MDL style packing
 	if (flags & ST_PACKING_MDL)
 	{
@@ -1481,6 +1701,13 @@ bool XModule::loadSample(XMFileBase& f,void* buffer,mp_uint32 size,mp_uint32 len
 		f.read(buffer,flags & ST_16BIT ? 2 : 1, length);
 	}
 
+	convertSample(buffer, length, flags);
+
+	return true;
+}
+
+void XModule::convertSample(void* buffer, mp_uint32 length, mp_sint32 flags)
+{
 	// 16 bit sample 
 	if (flags & ST_16BIT)
 	{
@@ -1542,16 +1769,149 @@ bool XModule::loadSample(XMFileBase& f,void* buffer,mp_uint32 size,mp_uint32 len
 				smpPtr[i] ^= 128;
 		}
 	}
+}
 
-	if (tmpBuffer)
-		delete[] tmpBuffer;
-
-	if (dstBuffer)
-		delete[] dstBuffer;
+bool XModule::skipSample(XMFileBase& f, mp_uint32 size, mp_uint32 length, mp_sint32 flags /* = ST_DEFAULT */)
+{
+	// MDL style packing, size is the packed size
+	if (flags & ST_PACKING_MDL)
+	{
+		f.seek(size, XMFileBase::SeekOffsetTypeCurrent);
+	}
+	// IT style packing, one block per 0x8000 samples (0x4000 when 16 bit)
+	// preceded by its size in bytes
+	else if ((flags & ST_PACKING_IT) || (flags & ST_PACKING_IT215))
+	{
+		const mp_uint32 blockLength = (flags & ST_16BIT) ? 0x4000 : 0x8000;
+		for (mp_uint32 i = 0; i < length; i += blockLength)
+		{
+			mp_uword blockSize = f.readWord();
+			if (f.isEOF())
+				return false;
+			f.seek(blockSize, XMFileBase::SeekOffsetTypeCurrent);
+		}
+	}
+	// delta table followed by 4 bits per sample, nothing for 16 bit
+	else if (flags & ST_PACKING_ADPCM)
+	{
+		if (!(flags & ST_16BIT))
+			f.seek(16 + (length + 1) / 2, XMFileBase::SeekOffsetTypeCurrent);
+	}
+	else
+	{
+		f.seek((flags & ST_16BIT) ? length*2 : length, XMFileBase::SeekOffsetTypeCurrent);
+	}
 
 	return true;
 }
 
+mp_sint32 XModule::loadSampleData(XMFileBase& f, mp_sbyte*& sample, mp_uint32 allocSize, 
+								  mp_uint32 size, mp_uint32 length, mp_sint32 flags /* = ST_DEFAULT */)
+{
+	if (probing)
+	{
+		sample = NULL;
+		return skipSample(f, size, length, flags) ? MP_OK : MP_OUT_OF_MEMORY;
+	}
+
+	sample = (mp_sbyte*)allocSampleMem(allocSize);
+	
+	if (sample == NULL)
+	{
+		return MP_OUT_OF_MEMORY;
+	}
+	
+	if (!deferSampleDecoding || numPendingSamples >= MP_MAXSAMPLES)
+	{
+		return loadSample(f, sample, size, length, flags) ? MP_OK : MP_OUT_OF_MEMORY;
+	}
+
+	// only read here, the decoding happens in decodePendingSamples
+	TPendingSample& pending = pendingSamples[numPendingSamples];
+	pending.buffer = sample;
+	pending.packed = NULL;
+	pending.packedSize = 0;
+	pending.size = size;
+	pending.length = length;
+	pending.flags = flags;
+	
+	if (flags & (ST_PACKING_MDL | ST_PACKING_IT | ST_PACKING_IT215 | ST_PACKING_ADPCM))
+	{
+		// skipping tells how much is stored, no need to understand the packing here
+		mp_uint32 start = f.pos();
+		if (!skipSample(f, size, length, flags))
+		{
+			return MP_OUT_OF_MEMORY;
+		}
+		mp_uint32 end = f.pos() < f.size() ? f.pos() : f.size();
+		
+		pending.packedSize = end > start ? end - start : 0;
+		pending.packed = new mp_ubyte[pending.packedSize];
+		
+		f.seek(start);
+		f.read(pending.packed, 1, pending.packedSize);
+	}
+	else
+	{
+		memset(sample, 0, size);
+		f.read(sample, flags & ST_16BIT ? 2 : 1, length);
+		
+		// plain 8 bit data is done already
+		if (!(flags & (ST_16BIT | ST_DELTA | ST_UNSIGNED | ST_DELTA_PTM)))
+			return MP_OK;
+	}
+	
+	numPendingSamples++;
+	return MP_OK;
+}
+
+bool XModule::decodePendingSamples()
+{
+	if (numPendingSamples)
+	{
+		mp_uint32 totalSize = 0;
+		for (mp_uint32 i = 0; i < numPendingSamples; i++)
+			totalSize += pendingSamples[i].size;
+		
+		// not worth starting threads for a few small samples
+		ParallelFor parallel(0, numPendingSamples, totalSize < 1024*1024 ? numPendingSamples : 1);
+		
+		std::atomic<bool> failed(false);
+		parallel.run([&](mp_sint32 block, mp_sint32 from, mp_sint32 to)
+		{
+			for (mp_sint32 i = from; i < to; i++)
+			{
+				const TPendingSample& pending = pendingSamples[i];
+				if (pending.packed)
+				{
+					XMMemoryFile f(pending.packed, pending.packedSize);
+					if (!loadSample(f, pending.buffer, pending.size, pending.length, pending.flags))
+						failed = true;
+				}
+				else
+				{
+					convertSample(pending.buffer, pending.length, pending.flags);
+				}
+			}
+		});
+		
+		if (failed)
+			sampleDecodingFailed = true;
+		
+		discardPendingSamples();
+	}
+	
+	return !sampleDecodingFailed;
+}
+
+void XModule::discardPendingSamples()
+{
+	for (mp_uint32 i = 0; i < numPendingSamples; i++)
+		delete[] pendingSamples[i].packed;
+	
+	numPendingSamples = 0;
+}
+
 mp_sint32 XModule::loadModuleSample(XMFileBase& f, mp_sint32 index, 
 									mp_sint32 flags8/* = ST_DEFAULT*/, mp_sint32 flags16/* = ST_16BIT*/,
 									mp_uint32 alternateSize/* = 0*/)
@@ -1561,37 +1921,15 @@ mp_sint32 XModule::loadModuleSample(XMFileBase& f, mp_sint32 index,
 		mp_uint32 finalSize = alternateSize ? alternateSize : smp[index].samplen*2;
 		if(finalSize < 8) finalSize = 8;
 		
-		smp[index].sample = (mp_sbyte*)allocSampleMem(finalSize);
-		
-		if (smp[index].sample == NULL)
-		{
-			return MP_OUT_OF_MEMORY;
-		}
-		
-		if (!loadSample(f,smp[index].sample, finalSize, smp[index].samplen, flags16))
-		{
-			return MP_OUT_OF_MEMORY;
-		}
+		return loadSampleData(f, smp[index].sample, finalSize, finalSize, smp[index].samplen, flags16);
 	}
 	else
 	{
 		mp_uint32 finalSize = alternateSize ? alternateSize : smp[index].samplen;
 		if(finalSize < 4) finalSize = 4;
 		
-		smp[index].sample = (mp_sbyte*)allocSampleMem(finalSize);
-		
-		if (smp[index].sample == NULL)
-		{
-			return MP_OUT_OF_MEMORY;
-		}
-		
-		if (!loadSample(f,smp[index].sample, finalSize, smp[index].samplen, flags8))
-		{
-			return MP_OUT_OF_MEMORY;
-		}		
+		return loadSampleData(f, smp[index].sample, finalSize, finalSize, smp[index].samplen, flags8);
 	}
-	
-	return MP_OK;
 }
 
 mp_sint32 XModule::loadModuleSamples(XMFileBase& f, mp_sint32 flags8/* = ST_DEFAULT*/, mp_sint32 flags16/* = ST_16BIT*/)
@@ -1613,6 +1951,8 @@ mp_sint32 XModule::loadModuleSamples(XMFileBase& f, mp_sint32 flags8/* = ST_DEFA
 ////////////////////////////////////////////
 void XModule::postProcessSamples(bool heavy/* = false*/)
 {
+	decodePendingSamples();
+
 	for (mp_uint32 i = 0; i < header.smpnum; i++)
 	{
 
@@ -1629,6 +1969,10 @@ void XModule::postProcessSamples(bool heavy/* = false*/)
 			continue;
 		}
 		
+		// nothing loaded when probing
+		if (smp->sample == NULL)
+			continue;
+		
 		if (heavy)
 			smp->smoothLooping();
 		
@@ -1648,68 +1992,61 @@ void XModule::setDefaultPanning()
 	}
 }
 
-mp_ubyte* XModule::allocSampleMem(mp_uint32 size)
+mp_sint32 XModule::findSamplePtr(mp_ubyte* ptr)
 {
-	// sample is always padded at start and end with 16 bytes
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
-	{
-		if (samplePool[i] == NULL)
-		{
-			samplePool[i] = TXMSample::allocPaddedMem(size);
-			return samplePool[i];
-		}
-	}
+	if (ptr == NULL)
+		return -1;
+
+	mp_uint32 slot = TXMSample::getMemHeader(ptr)->poolSlot;
+	return (slot < samplePointerIndex && samplePool[slot] == ptr) ? (mp_sint32)slot : -1;
+}
 
-	samplePool[samplePointerIndex] = TXMSample::allocPaddedMem(size);
-	return samplePool[samplePointerIndex++];
+void XModule::addSamplePtr(mp_ubyte* ptr)
+{
+	mp_uint32 slot = numFreeSlots ? freeSlots[--numFreeSlots] : samplePointerIndex++;
+	samplePool[slot] = ptr;
+	TXMSample::getMemHeader(ptr)->poolSlot = slot;
+}
+
+mp_ubyte* XModule::allocSampleMem(mp_uint32 size)
+{
+	// sample is always padded at start and end
+	mp_ubyte* mem = TXMSample::allocPaddedMem(size, loadArena);
+	if (mem)
+		addSamplePtr(mem);
+	return mem;
 }
 
 void XModule::freeSampleMem(mp_ubyte* mem, bool assertCheck/* = true*/)
 {
-	bool found = false;
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
-	{
-		if (samplePool[i] == mem)
-		{
-			found = true;
-			TXMSample::freePaddedMem(samplePool[i]);
-			samplePool[i] = NULL;
-			if (i == (signed)samplePointerIndex - 1)
-			{
-				samplePointerIndex--;
-				break;
-			}
-		}
-	}
+	mp_sint32 slot = findSamplePtr(mem);
 	
-	if (assertCheck)
+	if (assertCheck && mem)
 	{
-		ASSERT(found);
+		ASSERT(slot >= 0);
 	}
+	
+	if (slot < 0)
+		return;
+	
+	TXMSample::freePaddedMem(mem);
+	samplePool[slot] = NULL;
+	freeSlots[numFreeSlots++] = slot;
 }
 
 #ifdef MILKYTRACKER
 void XModule::insertSamplePtr(mp_ubyte* ptr)
 {
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
-	{
-		if (samplePool[i] == NULL)
-		{
-			samplePool[i] = ptr;
-			return;
-		}
-	}
-
-	samplePool[samplePointerIndex++] = ptr;
+	if (ptr && findSamplePtr(ptr) < 0)
+		addSamplePtr(ptr);
 }
 void XModule::removeSamplePtr(mp_ubyte* ptr)
 {
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
+	mp_sint32 slot = findSamplePtr(ptr);
+	if (slot >= 0)
 	{
-		if (samplePool[i] == ptr)
-		{
-			samplePool[i] = NULL;
-		}
+		samplePool[slot] = NULL;
+		freeSlots[numFreeSlots++] = slot;
 	}
 }
 #endif
@@ -1838,6 +2175,9 @@ bool XModule::cleanUp()
 	}
 
 	// release sample-memory
+	discardPendingSamples();
+	sampleDecodingFailed = false;
+	
 	for (i = 0; i < samplePointerIndex; i++)
 	{
 		if (samplePool[i]) 
@@ -1847,6 +2187,7 @@ bool XModule::cleanUp()
 		}
 	}
 	samplePointerIndex = 0;
+	numFreeSlots = 0;
 	
 	memset(&header,0,sizeof(TXMHeader));
 	
@@ -1879,11 +2220,20 @@ XModule::XModule()
 
 	// no module loaded (empty song)
 	moduleLoaded = false;
+	
+	probing = false;
+	
+	deferSampleDecoding = false;
+	pendingSamples = NULL;
+	numPendingSamples = 0;
+	sampleDecodingFailed = false;
 
 	// initialise all sample pointers to NULL
 	memset(samplePool,0,sizeof(samplePool));
 	// reset current sample index
 	samplePointerIndex = 0;
+	numFreeSlots = 0;
+	loadArena = NULL;
 
 	memset(&header,0,sizeof(TXMHeader));
 
@@ -1923,38 +2273,36 @@ XModule::~XModule()
 {
 	cleanUp();
 
+	delete[] pendingSamples;
+
 	delete[] phead;
 	delete[] instr;
 	delete[] smp;
 }
 
-const char* XModule::identifyModule(const mp_ubyte* buffer)
+const char* XModule::identifyModule(const mp_ubyte* buffer, ModuleTypes* moduleType/* = NULL*/)
 {
-	// browse through all available loaders and find suitable
-	LoaderManager loaderManager;
-	TLoaderInfo* loaderInfo;
-	loaderInfo = loaderManager.getFirstLoaderInfo();
-	while (loaderInfo)
-	{
-		// if loader can identify module return ID
-		const char* id = loaderInfo->loader->identifyModule(buffer);
-		if (id)
-		{
-			return id;
-		}
-		
-		loaderInfo = loaderManager.getNextLoaderInfo();
-	}
-	return NULL;
+	const char* id = NULL;
+	const TLoaderInfo* loaderInfo = LoaderManager::getInstance().identify(buffer, &id);
+	
+	if (moduleType)
+		*moduleType = loaderInfo ? loaderInfo->moduleType : ModuleType_UNKNOWN;
+	
+	return id;
 }
 
 mp_sint32 XModule::loadModule(const SYSCHAR* fileName, bool scanForSubSongs/* = false*/)
 {
+	// let the loaders work on the file in memory instead of going through stdio
+	XMMappedFile mf(fileName);
+	if (mf.isOpen())
+		return loadModule(mf, scanForSubSongs);
+
 	XMFile f(fileName);
 	return f.isOpen() ? loadModule(f, scanForSubSongs) : -8; 
 }
 
-mp_sint32 XModule::loadModule(XMFileBase& f, bool scanForSubSongs/* = false*/)
+const XModule::TLoaderInfo* XModule::identifyFile(XMFileBase& f, const char** id/* = NULL*/)
 {
 	mp_ubyte buffer[IdentificationBufferSize];
 	memset(buffer, 0, sizeof(buffer));
@@ -1962,35 +2310,58 @@ mp_sint32 XModule::loadModule(XMFileBase& f, bool scanForSubSongs/* = false*/)
 	f.setBaseOffset(f.pos());
 	f.read(buffer, 1, sizeof(buffer));
 
-	// browse through all available loaders and find suitable
-	LoaderManager loaderManager;
-	TLoaderInfo* loaderInfo;
-	loaderInfo = loaderManager.getFirstLoaderInfo();
-	while (loaderInfo)
+	return LoaderManager::getInstance().identify(buffer, id);
+}
+
+mp_sint32 XModule::loadModule(XMFileBase& f, bool scanForSubSongs/* = false*/)
+{
+	const TLoaderInfo* loaderInfo = identifyFile(f);
+	if (loaderInfo)
 	{
-		// if loader can identify module take that loader
-		if (loaderInfo->loader->identifyModule(buffer))
+		// the loader only reads the sample data, it is decoded on all
+		// cores at once when the loader post processes the samples
+		if (ParallelFor::getNumThreads() > 1)
 		{
-			// try to load module
-			f.seekWithBaseOffset(0);
-			mp_sint32 err = loaderInfo->loader->load(f, this);
-			if (err == MP_OK)
-			{
-				moduleLoaded = true;
-				
-				bool res = validate();
+			if (pendingSamples == NULL)
+				pendingSamples = new TPendingSample[MP_MAXSAMPLES];
+			deferSampleDecoding = true;
+		}
 
-				if (!res)
-					return MP_OUT_OF_MEMORY;
-				
-				type = loaderInfo->moduleType;
-				if (scanForSubSongs)
-					buildSubSongTable();
-			}
-			return err;
+		// the sample data can't be larger than the file unless it's
+		// packed, whatever doesn't fit anymore comes from the heap
+		if (f.size() > f.getBaseOffset())
+			loadArena = createSampleArena(f.size() - f.getBaseOffset());
+
+		// try to load module
+		f.seekWithBaseOffset(0);
+		mp_sint32 err = loaderInfo->loader->load(f, this);
+		
+		if (loadArena)
+		{
+			releaseSampleArena(loadArena);
+			loadArena = NULL;
 		}
 		
-		loaderInfo = loaderManager.getNextLoaderInfo();
+		deferSampleDecoding = false;
+		if (err != MP_OK)
+			discardPendingSamples();
+		else if (!decodePendingSamples())
+			err = MP_OUT_OF_MEMORY;
+		
+		if (err == MP_OK)
+		{
+			moduleLoaded = true;
+			
+			bool res = validate();
+
+			if (!res)
+				return MP_OUT_OF_MEMORY;
+			
+			type = loaderInfo->moduleType;
+			if (scanForSubSongs)
+				buildSubSongTable();
+		}
+		return err;
 	}
 	
 #ifdef MILKYTRACKER
@@ -2001,6 +2372,58 @@ mp_sint32 XModule::loadModule(XMFileBase& f, bool scanForSubSongs/* = false*/)
 
 }
 
+mp_sint32 XModule::probeModule(const SYSCHAR* fileName, TProbeInfo& info)
+{
+	XMMappedFile mf(fileName);
+	if (mf.isOpen())
+		return probeModule(mf, info);
+
+	XMFile f(fileName);
+	return f.isOpen() ? probeModule(f, info) : -8; 
+}
+
+mp_sint32 XModule::probeModule(XMFileBase& f, TProbeInfo& info)
+{
+	memset(&info, 0, sizeof(info));
+	info.type = ModuleType_UNKNOWN;
+
+	const TLoaderInfo* loaderInfo = identifyFile(f, &info.id);
+	if (!loaderInfo)
+	{
+#ifdef MILKYTRACKER
+		return MP_UNKNOWN_FORMAT;
+#else
+		return MP_UNSPECIFIED;
+#endif
+	}
+
+	info.type = loaderInfo->moduleType;
+
+	f.seekWithBaseOffset(0);
+	probing = true;
+	mp_sint32 err = loaderInfo->loader->load(f, this);
+	probing = false;
+
+	if (err == MP_OK)
+	{
+		convertStr(info.title, (const char*)header.name, MP_MAXTEXT);
+		convertStr(info.tracker, (const char*)header.tracker, MP_MAXTEXT);
+		info.numChannels = header.channum;
+		info.numOrders = header.ordnum;
+		info.numPatterns = header.patnum;
+		info.numInstruments = header.insnum;
+		info.numSamples = header.smpnum;
+
+		for (mp_uint32 i = 0; i < header.insnum && i < 256; i++)
+			convertStr(info.instrumentNames[i], (const char*)instr[i].name, MP_MAXTEXT);
+	}
+
+	// leave an empty song behind, nothing of the probed one is usable
+	cleanUp();
+
+	return err;
+}
+
 bool XModule::validate()
 {
 	if (header.channum == 0)
@@ -126,9 +126,19 @@ struct TXMInstrument
 // getSampleValue and setSampleValue and call postProcessSamples when you're done
 // modifying the sample, so the loop information is updated correctly
 // Also call postProcessSamples when you're changing the loop information
+// block of sample memory shared by the samples of a freshly loaded module
+struct TSampleArena;
+
 struct TXMSample 
 {
 private:
+	// bookkeeping in front of the padding, copyPaddedMem doesn't touch it
+	struct TMemHeader
+	{
+		TSampleArena* arena;	// NULL when allocated on its own
+		mp_uint32 poolSlot;		// index in the owning module's sample pool
+	};
+
 	struct TLoopDoubleBuffProps
 	{
 		enum
@@ -150,9 +160,16 @@ private:
 		EmptySize = 8,
 		LeadingPadding = sizeof(TLoopDoubleBuffProps) + LoopAreaBackupSizeMaxInBytes + EmptySize,
 		TrailingPadding = 16,
-		PaddingSpace = LeadingPadding+TrailingPadding
+		PaddingSpace = LeadingPadding+TrailingPadding,
+		// keeps the header 16 byte aligned when the sample data is (arena)
+		MemHeaderSpace = ((LeadingPadding + 16 + 15) & ~15) - LeadingPadding
 	};
 
+	static TMemHeader* getMemHeader(mp_ubyte* mem)
+	{
+		return (TMemHeader*)(mem-TXMSample::LeadingPadding-TXMSample::MemHeaderSpace);
+	}
+
 	void restoreLoopArea();
 
 public:
@@ -192,31 +209,9 @@ public:
 		return mem-TXMSample::LeadingPadding;
 	}
 
-	static mp_ubyte* allocPaddedMem(mp_uint32 size)
-	{
-		mp_ubyte* result = new mp_ubyte[getPaddedSize(size)];
-		
-		if (result == NULL)
-			return NULL;
-		
-		// clear out padding space
-		memset(result, 0, TXMSample::LeadingPadding);
-		memset(result+size+TXMSample::LeadingPadding, 0, TXMSample::TrailingPadding);
-		
-		TLoopDoubleBuffProps* loopBufferProps = (TLoopDoubleBuffProps*)result;
-		loopBufferProps->samplesize = size;
-		
-		return result + TXMSample::LeadingPadding;
-	}
-	
-	static void freePaddedMem(mp_ubyte* mem)
-	{
-		// behave safely on NULL
-		if (mem == NULL)
-			return;
-			
-		delete[] getPadStartAddr(mem);
-	}
+	// carved from the arena if given and there is room left, from the heap otherwise
+	static mp_ubyte* allocPaddedMem(mp_uint32 size, TSampleArena* arena = NULL);
+	static void freePaddedMem(mp_ubyte* mem);
 
 	static void copyPaddedMem(void* dst, const void* src, mp_uint32 size)
 	{
@@ -248,6 +243,13 @@ public:
 	mp_sint32 getSampleValue(mp_ubyte* sample, mp_uint32 index);
 	void setSampleValue(mp_uint32 index, mp_sint32 value);
 	void setSampleValue(mp_ubyte* sample, mp_uint32 index, mp_sint32 value);
+
+	// convert count samples from index on to/from floats in [-1,1]
+	// the loop area double buffer is handled like get/setSampleValue do
+	void readFloat(mp_uint32 index, mp_uint32 count, float* dest);
+	void writeFloat(mp_uint32 index, mp_uint32 count, const float* src);
+	// same for a copy in the sample's own resolution (mp_sbyte or mp_sword)
+	void readSamples(mp_uint32 index, mp_uint32 count, void* dest);
 	
 #ifdef MILKYTRACKER
 	bool equals(const TXMSample& sample) const
@@ -426,6 +428,25 @@ public:
 								   mp_uint32 size, mp_uint32 length, 
 								   mp_sint32 flags = ST_DEFAULT);
 	
+	///////////////////////////////////////////////////////
+	// move the file position behind sample data which	 //
+	// loadSample would read with the same parameters	 //
+	///////////////////////////////////////////////////////
+	static bool			skipSample(XMFileBase& f, mp_uint32 size, 
+								   mp_uint32 length, mp_sint32 flags = ST_DEFAULT);
+	
+	///////////////////////////////////////////////////////
+	// allocate sample memory of allocSize bytes and	 //
+	// load the sample into it, when probing the data is //
+	// skipped and sample stays NULL.					 //
+	// While loadModule runs, only the stored data is	 //
+	// read here and decoding is left to				 //
+	// decodePendingSamples.							 //
+	///////////////////////////////////////////////////////
+	mp_sint32			loadSampleData(XMFileBase& f, mp_sbyte*& sample, mp_uint32 allocSize,
+									   mp_uint32 size, mp_uint32 length, 
+									   mp_sint32 flags = ST_DEFAULT);
+	
 	///////////////////////////////////////////////////////
 	// load a bunch of samples into memory				 //
 	///////////////////////////////////////////////////////
@@ -436,6 +457,13 @@ public:
 	mp_sint32			loadModuleSamples(XMFileBase& f, 
 										  mp_sint32 flags8 = ST_DEFAULT, mp_sint32 flags16 = ST_16BIT);
 	
+	///////////////////////////////////////////////////////
+	// decode the samples loadSampleData has read so far //
+	// on all cores, loaders have to call this before	 //
+	// touching sample data (postProcessSamples does)	 //
+	///////////////////////////////////////////////////////
+	bool				decodePendingSamples();
+	
 	static void			convertXMVolumeEffects(mp_ubyte volume, mp_ubyte& eff, mp_ubyte& op);
 	
 	///////////////////////////////////////////////////////
@@ -478,9 +506,45 @@ private:
 	// Indicates whether a file is loaded or if it's just an empty song 
 	bool			moduleLoaded;
 
+	// set while probeModule runs a loader, sample data is skipped then
+	bool			probing;
+
+	// sample data which has been read but not decoded yet
+	struct TPendingSample
+	{
+		void*		buffer;
+		// stored data of packed samples, NULL when it was read into buffer
+		mp_ubyte*	packed;
+		mp_uint32	packedSize;
+		mp_uint32	size;
+		mp_uint32	length;
+		mp_sint32	flags;
+	};
+	
+	// set while loadModule runs a loader
+	bool			deferSampleDecoding;
+	TPendingSample*	pendingSamples;
+	mp_uint32		numPendingSamples;
+	bool			sampleDecodingFailed;
+
+	void			discardPendingSamples();
+	
+	// everything loadSample does after reading unpacked data
+	static void		convertSample(void* buffer, mp_uint32 length, mp_sint32 flags);
+
 	// each module comes with it's own sample-memory management (MILKYPLAY_MAXSAMPLES samples max.)
 	mp_ubyte*		samplePool[MP_MAXSAMPLES];
 	mp_uint32		samplePointerIndex;
+	// pool entries below samplePointerIndex which are NULL
+	mp_uint32		freeSlots[MP_MAXSAMPLES];
+	mp_uint32		numFreeSlots;
+
+	// samples allocated while a module is loaded share this block
+	TSampleArena*	loadArena;
+
+	// slot of a pointer in the sample pool or -1, each block knows its slot
+	mp_sint32		findSamplePtr(mp_ubyte* ptr);
+	void			addSamplePtr(mp_ubyte* ptr);
 
 	// song message retrieving
 	char*			messagePtr;
@@ -494,29 +558,59 @@ private:
 	// fix broken envelopes (1 point envelope for example)
 	static void		fixEnvelopes(TEnvelope* envs, mp_uint32 numEnvs);
 	
-	// holds available loader instances
+	// holds the loader instances, built once and shared by all modules
 	class LoaderManager
 	{
 	private:
-		TLoaderInfo*	loaders;
+		enum
+		{
+			MaxLoaders		= 64,
+			MaxSignatures	= 64
+		};
+
+		// magic bytes which every file of a loader's format contains
+		struct TSignature
+		{
+			mp_uint32		offset;
+			const char*		magic;
+			mp_uint32		length;
+			mp_sint32		loaderIndex;
+			// next signature with the same first byte at offset 0
+			mp_sint32		next;
+		};
 
+		TLoaderInfo		loaders[MaxLoaders];
 		mp_uint32		numLoaders;
-		mp_uint32		numAllocatedLoaders;
+		// bit set for every loader without signatures, 32 loaders per word
+		mp_uint32		guessingLoaders[MaxLoaders/32];
 
-		mp_sint32		iteratorCounter;
+		TSignature		signatures[MaxSignatures];
+		mp_uint32		numSignatures;
+		// signatures at offset 0 by their first byte, the others in one list
+		mp_sint32		firstByteIndex[256];
+		mp_sint32		otherSignatures;
 
 		void registerLoader(LoaderInterface* loader, ModuleTypes type);
+		// add a signature to the last registered loader, it must be
+		// found in every file the loader's identifyModule accepts
+		void addSignature(mp_uint32 offset, const char* magic, mp_uint32 length);
 		
-	public:
 		LoaderManager();		
 		~LoaderManager();
-		
-		TLoaderInfo* getFirstLoaderInfo();
-		TLoaderInfo* getNextLoaderInfo();
+
+	public:
+		static const LoaderManager& getInstance();
+
+		// asks the loaders whose signature is found in the buffer and the ones
+		// without signatures in registration order, NULL if none accepts it
+		const TLoaderInfo* identify(const mp_ubyte* buffer, const char** id = NULL) const;
 	};
 
 	friend class	LoaderManager;
 
+	// reads the identification buffer and finds the loader for it
+	static const TLoaderInfo* identifyFile(XMFileBase& f, const char** id = NULL);
+
 	bool			validate();
 
 public:
@@ -543,6 +637,22 @@ public:
 		MODULE_ITTEMPOSLIDE				= 65536,
 	};
 	
+	// what probeModule finds out about a module without loading the samples
+	struct TProbeInfo
+	{
+		ModuleTypes		type;
+		// identification string of the loader
+		const char*		id;
+		char			title[MP_MAXTEXT+1];
+		char			tracker[MP_MAXTEXT+1];
+		mp_uint32		numChannels;
+		mp_uint32		numOrders;
+		mp_uint32		numPatterns;
+		mp_uint32		numInstruments;
+		mp_uint32		numSamples;
+		char			instrumentNames[256][MP_MAXTEXT+1];
+	};
+	
 	enum
 	{
 		NOTE_LAST	= 120,
@@ -630,7 +740,9 @@ public:
 	// eIdentifyBufferSize bytes from the beginning  //
 	// of the file									 //
 	///////////////////////////////////////////////////
-	static const char*	identifyModule(const mp_ubyte* buffer);
+	// works without an XModule instance, moduleType receives the 
+	// type of the loader which would be used
+	static const char*	identifyModule(const mp_ubyte* buffer, ModuleTypes* moduleType = NULL);
 	
 	///////////////////////////////////////////////////
 	// generic module loader						 //
@@ -638,10 +750,21 @@ public:
 	mp_sint32		loadModule(XMFileBase& f, bool scanForSubSongs = false);
 	mp_sint32		loadModule(const SYSCHAR* fileName, bool scanForSubSongs = false);	 
 
+	///////////////////////////////////////////////////
+	// read header and metadata only, sample data	 //
+	// is skipped. The module is empty afterwards,	 //
+	// so one instance can probe many files.		 //
+	///////////////////////////////////////////////////
+	mp_sint32		probeModule(XMFileBase& f, TProbeInfo& info);
+	mp_sint32		probeModule(const SYSCHAR* fileName, TProbeInfo& info);
+	
+	bool			isProbing() const { return probing; }
+
 	///////////////////////////////////////////////////
 	// Module exporters								 //
 	///////////////////////////////////////////////////
 	mp_sint32		saveExtendedModule(const SYSCHAR* fileName, const char* trackerString = NULL);		// FT2 (.XM)
+	mp_sint32		saveExtendedModule(XMFileBase& f, const char* trackerString = NULL);				// FT2 (.XM)
 	mp_sint32		saveProtrackerModule(const SYSCHAR* fileName);   // Protracker compatible (.MOD)
 
 	///////////////////////////////////////////////////
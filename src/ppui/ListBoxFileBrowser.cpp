@@ -31,6 +31,164 @@
 #include "ListBoxFileBrowser.h"
 #include "Screen.h"
 #include "PPPathFactory.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <chrono>
+
+// the listings of the last few folders visited, shared by all file browsers
+#define MAXCACHEDFOLDERS	16
+// a folder which takes longer to read shows up bit by bit
+#define SCANWAITMILLIS		100
+
+struct CachedFolder
+{
+	PPSystemString path;
+	pp_int64 time, size;
+	pp_uint32 lastUse;
+	// all entries which aren't hidden, unsorted
+	PPSimpleVector<PPPathEntry> entries;
+};
+
+static pp_uint32 cacheUseCounter = 0;
+
+static PPSimpleVector<CachedFolder>& cachedFolders()
+{
+	static PPSimpleVector<CachedFolder> folders;
+	return folders;
+}
+
+static void addCachedFolder(CachedFolder* folder)
+{
+	PPSimpleVector<CachedFolder>& folders = cachedFolders();
+
+	if (folders.size() >= MAXCACHEDFOLDERS)
+	{
+		pp_int32 oldest = 0;
+		for (pp_int32 i = 1; i < folders.size(); i++)
+		{
+			if (folders.get(i)->lastUse < folders.get(oldest)->lastUse)
+				oldest = i;
+		}
+		folders.remove(oldest);
+	}
+	folders.add(folder);
+}
+
+class PPListBoxFileBrowser::FolderScan
+{
+public:
+	PPPath* path;
+	// receives everything taken from pending, cached when the scan is complete
+	CachedFolder* folder;
+	bool cacheable;
+	// entry to select once it has been read
+	PPPathEntry* selection;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::vector<PPPathEntry*> pending;
+	bool done;
+	std::atomic<bool> cancelled;
+
+	FolderScan(const PPSystemString& pathName) :
+		path(PPPathFactory::createPathFromString(pathName)),
+		folder(new CachedFolder()),
+		cacheable(false),
+		selection(NULL),
+		done(false),
+		cancelled(false)
+	{
+	}
+
+	~FolderScan()
+	{
+		for (size_t i = 0; i < pending.size(); i++)
+			delete pending[i];
+		delete selection;
+		delete folder;
+		delete path;
+	}
+
+	void run()
+	{
+		const PPPathEntry* entry = path->getFirstEntry();
+		while (entry && !cancelled)
+		{
+			if (!entry->isHidden())
+			{
+				PPPathEntry* clone = entry->clone();
+				std::lock_guard<std::mutex> lock(mutex);
+				pending.push_back(clone);
+			}
+			entry = path->getNextEntry();
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		done = true;
+	}
+};
+
+// parent folders first, then the content in the chosen order, drives last
+class ListingSortRule : public PPPathEntry::PathSortRuleInterface
+{
+private:
+	const PPPathEntry::PathSortRuleInterface& contentRule;
+	pp_int32 sign;
+
+	static pp_int32 group(const PPPathEntry& entry)
+	{
+		return entry.isParent() ? 0 : (entry.isDrive() ? 2 : 1);
+	}
+
+public:
+	ListingSortRule(const PPPathEntry::PathSortRuleInterface& contentRule, bool ascending) :
+		contentRule(contentRule),
+		sign(ascending ? 1 : -1)
+	{
+	}
+
+	virtual pp_int32 compare(const PPPathEntry& left, const PPPathEntry& right) const
+	{
+		pp_int32 leftGroup = group(left), rightGroup = group(right);
+		if (leftGroup != rightGroup)
+			return leftGroup - rightGroup;
+
+		if (leftGroup == 1)
+			return contentRule.compare(left, right) * sign;
+		if (leftGroup == 2)
+			return left.getName().compareToNoCase(right.getName());
+		return 0;
+	}
+};
+
+// stable, the left run wins on equal entries
+static void mergeEntries(PPPathEntry** left, pp_int32 numLeft, PPPathEntry** right, pp_int32 numRight, 
+						 PPPathEntry** dest, const PPPathEntry::PathSortRuleInterface& rule)
+{
+	pp_int32 i = 0, j = 0, k = 0;
+	while (i < numLeft && j < numRight)
+		dest[k++] = rule.compare(*right[j], *left[i]) < 0 ? right[j++] : left[i++];
+	while (i < numLeft)
+		dest[k++] = left[i++];
+	while (j < numRight)
+		dest[k++] = right[j++];
+}
+
+static void sortEntries(PPPathEntry** entries, PPPathEntry** temp, pp_int32 num, const PPPathEntry::PathSortRuleInterface& rule)
+{
+	if (num < 2)
+		return;
+
+	pp_int32 half = num >> 1;
+	sortEntries(entries, temp, half, rule);
+	sortEntries(entries + half, temp, num - half, rule);
+
+	mergeEntries(entries, half, entries + half, num - half, temp, rule);
+	for (pp_int32 i = 0; i < num; i++)
+		entries[i] = temp[i];
+}
 
 PPListBoxFileBrowser::PPListBoxFileBrowser(pp_int32 id, PPScreen* parentScreen, EventListenerInterface* eventListener, 
 										   const PPPoint& location, const PPSize& size) :
@@ -40,7 +198,13 @@ PPListBoxFileBrowser::PPListBoxFileBrowser(pp_int32 id, PPScreen* parentScreen,
 	sortAscending(true),
 	cycleFilenames(true),
 	confirmed(false),
-	sortType(SortByName)
+	sortType(SortByName),
+	listingValid(false),
+	listedTime(0),
+	listedSize(0),
+	listedSortType(SortByName),
+	listedSortAscending(true),
+	scan(NULL)
 {
 	setRightButtonConfirm(true);
 	currentPath = PPPathFactory::createPath();
@@ -48,11 +212,54 @@ PPListBoxFileBrowser::PPListBoxFileBrowser(pp_int32 id, PPScreen* parentScreen,
 
 PPListBoxFileBrowser::~PPListBoxFileBrowser()
 {
+	cancelScan();
 	delete currentPath;
 }
 
 pp_int32 PPListBoxFileBrowser::dispatchEvent(PPEvent* event)
 {
+	// the list box doesn't get to see the timer, as before
+	if (event->getID() == eTimer)
+	{
+		if (scan == NULL)
+			return 0;
+
+		// keep the selected entry selected while new ones come in
+		const PPPathEntry* selected = getPathEntry(PPListBox::getSelectedIndex());
+		PPPathEntry* selection = scan->selection;
+		scan->selection = NULL;
+		
+		PPListBox::saveState();
+		updateScan();
+		PPListBox::restoreState(false);
+
+		for (pp_int32 i = 0; selected && i < pathEntries.size(); i++)
+		{
+			if (pathEntries.get(i) == selected)
+			{
+				PPListBox::setSelectedIndex(i, false, false);
+				break;
+			}
+		}
+		
+		// the entry asked for by selectPathEntry, scrolled into view
+		// as the list has changed since
+		if (selection)
+		{
+			pp_int32 index = findPathEntry(*selection);
+			if (index >= 0)
+				PPListBox::setSelectedIndex(index, true, false);
+			
+			if (index < 0 && scan)
+				scan->selection = selection;
+			else
+				delete selection;
+		}
+		
+		parentScreen->paintControl(this);
+		return 0;
+	}
+
 	if (event->getID() == eKeyChar && cycleFilenames)
 	{	
 		pp_uint16 keyCode = *((pp_uint16*)event->getDataPtr());		
@@ -88,6 +295,7 @@ pp_int32 PPListBoxFileBrowser::dispatchEvent(PPEvent* event)
 void PPListBoxFileBrowser::clearExtensions()
 {
 	items.clear();
+	listingValid = false;
 }
 
 // must contain pairs of extensions / description
@@ -102,6 +310,7 @@ void PPListBoxFileBrowser::addExtension(const PPString& ext, const PPString& des
 {
 	Descriptor* d = new Descriptor(ext, desc);
 	items.add(d);
+	listingValid = false;
 }
 
 
@@ -118,9 +327,9 @@ PPString PPListBoxFileBrowser::getCurrentPathAsASCIIString() const
 	return result;
 }
 
-void PPListBoxFileBrowser::refreshFiles()
+void PPListBoxFileBrowser::refreshFiles(bool rescan/* = false*/)
 {
-	iterateFilesInFolder();
+	iterateFilesInFolder(rescan);
 }
 
 const PPPathEntry* PPListBoxFileBrowser::getPathEntry(pp_int32 index) const
@@ -130,6 +339,30 @@ const PPPathEntry* PPListBoxFileBrowser::getPathEntry(pp_int32 index) const
     return NULL;
 }
 
+pp_int32 PPListBoxFileBrowser::findPathEntry(const PPPathEntry& entry) const
+{
+	for (pp_int32 i = 0; i < pathEntries.size(); i++)
+	{
+		if (entry.compareTo(*pathEntries.get(i)))
+			return i;
+	}
+	return -1;
+}
+
+void PPListBoxFileBrowser::selectPathEntry(const PPPathEntry& entry)
+{
+	pp_int32 index = findPathEntry(entry);
+	if (index >= 0)
+	{
+		PPListBox::setSelectedIndex(index, false);
+	}
+	else if (scan)
+	{
+		delete scan->selection;
+		scan->selection = entry.clone();
+	}
+}
+
 bool PPListBoxFileBrowser::canGotoHome() const
 {
 	return currentPath->canGotoHome();
@@ -289,23 +522,153 @@ void PPListBoxFileBrowser::setDirectorySuffixPathSeperator()
 	directorySuffix = currentPath->getPathSeparatorAsASCII();
 }
 
-void PPListBoxFileBrowser::iterateFilesInFolder()
+void PPListBoxFileBrowser::iterateFilesInFolder(bool rescan)
 {
-	pathEntries.clear();
+	cancelScan();
+	
+	PPSystemString path = currentPath->getCurrent();
+	pp_int64 time = 0, size = 0;
+	bool cacheable = currentPath->getCurrentStamp(time, size);
 	
-	const PPPathEntry* entry = currentPath->getFirstEntry();
-	while (entry)
+	PPSimpleVector<CachedFolder>& folders = cachedFolders();
+	
+	CachedFolder* folder = NULL;
+	for (pp_int32 i = 0; i < folders.size(); i++)
 	{
-		if (!entry->isHidden() && checkExtension(*entry))
+		CachedFolder* f = folders.get(i);
+		if (f->path.compareTo(path) == 0)
 		{
-			pathEntries.add(entry->clone());			
+			if (cacheable && !rescan && f->time == time && f->size == size)
+				folder = f;
+			else
+				folders.remove(i);
+			break;
 		}
-		entry = currentPath->getNextEntry();
+	}
+	
+	// same listing as last time, nothing to filter or sort again
+	bool sameListing = folder != NULL && listingValid &&
+		listedPath.compareTo(path) == 0 &&
+		listedTime == time && listedSize == size &&
+		listedSortType == sortType && listedSortAscending == sortAscending;
+	
+	listedPath = path;
+	listedTime = time;
+	listedSize = size;
+	
+	if (folder == NULL)
+	{
+		// read the folder in the background, the list is filled as the
+		// entries come in unless the folder is read quickly anyway
+		listingValid = false;
+		pathEntries.clear();
+		PPListBox::clear();
+
+		scan = new FolderScan(path);
+		scan->cacheable = cacheable;
+		scan->folder->path = path;
+		scan->folder->time = time;
+		scan->folder->size = size;
+		scan->thread = std::thread(&FolderScan::run, scan);
+		
+		for (pp_int32 i = 0; i < SCANWAITMILLIS; i++)
+		{
+			{
+				std::lock_guard<std::mutex> lock(scan->mutex);
+				if (scan->done)
+					break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		
+		updateScan();
+		return;
+	}
+	
+	folder->lastUse = ++cacheUseCounter;
+	
+	if (sameListing)
+	{
+		buildFileList();
+		return;
+	}
+	
+	pathEntries.clear();
+	
+	for (pp_int32 i = 0; i < folder->entries.size(); i++)
+	{
+		const PPPathEntry* entry = folder->entries.get(i);
+		if (checkExtension(*entry))
+			pathEntries.add(entry->clone());
 	}
 	
 	sortFileList();
 	
 	buildFileList();
+	
+	listingValid = true;
+	listedSortType = sortType;
+	listedSortAscending = sortAscending;
+}
+
+bool PPListBoxFileBrowser::updateScan()
+{
+	if (scan == NULL)
+		return true;
+
+	std::vector<PPPathEntry*> entries;
+	bool done;
+	{
+		std::lock_guard<std::mutex> lock(scan->mutex);
+		entries.swap(scan->pending);
+		done = scan->done;
+	}
+	
+	pp_int32 numSorted = pathEntries.size();
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		scan->folder->entries.add(entries[i]);
+		if (checkExtension(*entries[i]))
+			pathEntries.add(entries[i]->clone());
+	}
+	
+	if (pathEntries.size() > numSorted || !done)
+	{
+		sortFileList(numSorted);
+		buildFileList();
+	}
+	
+	if (!done)
+		return false;
+	
+	scan->thread.join();
+	
+	if (scan->cacheable)
+	{
+		scan->folder->lastUse = ++cacheUseCounter;
+		addCachedFolder(scan->folder);
+		scan->folder = NULL;
+	}
+	
+	listingValid = scan->cacheable;
+	listedSortType = sortType;
+	listedSortAscending = sortAscending;
+	
+	delete scan;
+	scan = NULL;
+	return true;
+}
+
+void PPListBoxFileBrowser::cancelScan()
+{
+	if (scan == NULL)
+		return;
+
+	scan->cancelled = true;
+	scan->thread.join();
+	
+	delete scan;
+	scan = NULL;
 }
 
 void PPListBoxFileBrowser::buildFileList()
@@ -352,82 +715,45 @@ void PPListBoxFileBrowser::appendFileSize(PPString& name, const PPPathEntry& ent
 	}
 }
 
-void PPListBoxFileBrowser::sortFileList()
+void PPListBoxFileBrowser::sortFileList(pp_int32 numSorted/* = 0*/)
 {
-	pp_int32 i;
-
-	PPPathEntry** tempEntries;
-	PPPathEntry** drives;
-	PPPathEntry** parents;
-	
 	pp_int32 numEntries = pathEntries.size();
-	tempEntries = new PPPathEntry*[numEntries];	
-	drives = new PPPathEntry*[numEntries];	
-	parents = new PPPathEntry*[numEntries];	
-	//for (i = 0; i < numEntries; i++)
-	//	tempEntries[i] = pathEntries.get(i)->clone();
-	
-	pp_int32 numDrives = 0;
-	pp_int32 numParents = 0;
-	pp_int32 content = 0;
-	for (i = 0; i < numEntries; i++)
-	{
-		if (pathEntries.get(i)->isParent())
-		{
-			parents[numParents] = pathEntries.get(i)->clone();			
-			numParents++;
-		}
-		else if (pathEntries.get(i)->isDrive())
-		{
-			drives[numDrives] = pathEntries.get(i)->clone();			
-			numDrives++;
-		}
-		else 
-		{
-			tempEntries[content] = pathEntries.get(i)->clone();
-			content++;
-		}
-	}
-	
-	
-	PPPathEntry::PathSortRuleInterface* sortRules[NumSortRules];
-	
+	if (numSorted >= numEntries)
+		return;
+
 	PPPathEntry::PathSortByFileRule sortByFileRule;
 	PPPathEntry::PathSortBySizeRule sortBySizeRule;
 	PPPathEntry::PathSortByExtRule sortByExtRule;
 	
+	PPPathEntry::PathSortRuleInterface* sortRules[NumSortRules];
 	sortRules[0] = &sortByFileRule;
 	sortRules[1] = &sortBySizeRule;
 	sortRules[2] = &sortByExtRule;
 	
-	if (content)
-		PPPathEntry::sort(tempEntries, 0, content-1, *sortRules[sortType], !sortAscending);
-	if (numDrives)
-		PPPathEntry::sort(drives, 0, numDrives-1, *sortRules[0], false);
+	ListingSortRule rule(*sortRules[sortType], sortAscending);
 	
-	pathEntries.clear();
+	PPPathEntry** entries = new PPPathEntry*[numEntries];
+	PPPathEntry** temp = new PPPathEntry*[numEntries];
 	
-	for (i = 0; i < numParents; i++)
-	{
-		pathEntries.add(parents[i]->clone());
-		delete parents[i];
-	}
-
-	for (i = 0; i < content; i++)
-	{
-		pathEntries.add(tempEntries[i]->clone());
-		delete tempEntries[i];
-	}
+	pp_int32 i;
+	for (i = 0; i < numEntries; i++)
+		entries[i] = pathEntries.get(i);
+	
+	sortEntries(entries + numSorted, temp, numEntries - numSorted, rule);
 	
-	for (i = 0; i < numDrives; i++)
+	if (numSorted)
 	{
-		pathEntries.add(drives[i]->clone());
-		delete drives[i];
+		mergeEntries(entries, numSorted, entries + numSorted, numEntries - numSorted, temp, rule);
+		for (i = 0; i < numEntries; i++)
+			entries[i] = temp[i];
 	}
 	
-	delete[] parents;
-	delete[] drives;
-	delete[] tempEntries;
+	// only the order changes, the vector still owns all entries
+	for (i = 0; i < numEntries; i++)
+		pathEntries.replaceNoDestroy(i, entries[i]);
+	
+	delete[] temp;
+	delete[] entries;
 }
 
 void PPListBoxFileBrowser::cycle(char chr)
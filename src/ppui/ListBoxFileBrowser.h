@@ -63,6 +63,17 @@ private:
 
 	SortTypes sortType;
 
+	// what pathEntries was built from, it's reused while all of this stays the same
+	bool listingValid;
+	PPSystemString listedPath;
+	pp_int64 listedTime, listedSize;
+	SortTypes listedSortType;
+	bool listedSortAscending;
+
+	// folder which is still being read on another thread
+	class FolderScan;
+	FolderScan* scan;
+
 public:
 	PPListBoxFileBrowser(pp_int32 id, PPScreen* parentScreen, EventListenerInterface* eventListener, 
 						 const PPPoint& location, const PPSize& size);
@@ -71,9 +82,12 @@ public:
 	
 	virtual pp_int32 dispatchEvent(PPEvent* event);
 
-	virtual bool receiveTimerEvent() const { return false; }	
+	// picks up the entries of a folder which is read in the background
+	virtual bool receiveTimerEvent() const { return true; }	
 	
-	void refreshFiles();
+	// folders are listed from a cache as long as they haven't changed,
+	// rescan reads the folder again anyway (i.e. to update file sizes)
+	void refreshFiles(bool rescan = false);
 	
 	void setSortAscending(bool sortAscending) { this->sortAscending = sortAscending; }
 	void setCycleFilenames(bool cycleFilenames) { this->cycleFilenames = cycleFilenames; }
@@ -97,6 +111,9 @@ public:
 	PPString getCurrentPathAsASCIIString() const;
 	const PPPathEntry* getPathEntry(pp_int32 index) const;
 	const PPPathEntry* getCurrentSelectedPathEntry() const { return getPathEntry(PPListBox::getSelectedIndex()); }
+	// select the entry matching the given one, while the folder is still
+	// being read this happens as soon as the entry comes in
+	void selectPathEntry(const PPPathEntry& entry);
 	const PPSimpleVector<class PPPathEntry>& getPathEntries() const { return pathEntries; }
 
 	bool canGotoHome() const;
@@ -123,13 +140,18 @@ public:
 	void setDirectorySuffixPathSeperator();
 	
 private:
-	void iterateFilesInFolder();
+	void iterateFilesInFolder(bool rescan);
+	// move entries read by the background scan into the list, false while it's still busy
+	bool updateScan();
+	void cancelScan();
 	void buildFileList();
-	void sortFileList();
+	// sort the entries from numSorted on and merge them with the sorted ones before
+	void sortFileList(pp_int32 numSorted = 0);
 	void cycle(char chr);
 	static void appendFileSize(PPString& name, const PPPathEntry& entry);
 	
 	bool checkExtension(const PPPathEntry& entry);
+	pp_int32 findPathEntry(const PPPathEntry& entry) const;
 };
 
 #endif	// __LISTBOXFILEBROWSER_H__
@@ -304,6 +304,11 @@ public:
 	virtual const PPSystemString getPathSeparator() const = 0;
 
 	virtual bool fileExists(const PPSystemString& fileName) const = 0;
+
+	// modification time and size of the current folder, they change when
+	// entries are added, removed or renamed. Returns false when the folder
+	// can't tell or has changed too recently to be sure the entries are final
+	virtual bool getCurrentStamp(pp_int64& time, pp_int64& size) { return false; }
 };
 
 #endif
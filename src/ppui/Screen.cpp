@@ -129,6 +129,12 @@ void PPScreen::raiseEvent(PPEvent* event)
 		if (!modalControl)
 			return;		
 
+		// controls inside the modal control keep getting their timer
+		if (event->getID() == eTimer)
+		{
+			routeTimerEvent(event, modalControl);
+			return;
+		}
 	
 		// only allow keys to arrive at modal when mousecursor is in modal
 		if( bubble && event->getID() != eKeyUp ){
@@ -143,14 +149,7 @@ void PPScreen::raiseEvent(PPEvent* event)
 	// route timer event
 	if (event->getID() == eTimer)
 	{
-		for (pp_int32 i = 0; i < timerEventControls->size(); i++)
-		{
-			PPControl* control = timerEventControls->get(i);
-			if (!control->isVisible() || !control->receiveTimerEvent())
-				continue;
-			
-			control->dispatchEvent(event);
-		}
+		routeTimerEvent(event);
 		return;
 	}
 
@@ -604,6 +603,24 @@ bool PPScreen::removeControl(PPControl* control)
 	return rootContainer->removeControl(control);
 }
 
+void PPScreen::routeTimerEvent(PPEvent* event, PPControl* owner/* = NULL*/)
+{
+	for (pp_int32 i = 0; i < timerEventControls->size(); i++)
+	{
+		PPControl* control = timerEventControls->get(i);
+		if (!control->isVisible() || !control->receiveTimerEvent())
+			continue;
+		
+		PPControl* parent = control;
+		while (owner && parent && parent != owner)
+			parent = parent->getOwnerControl();
+		if (parent == NULL)
+			continue;
+		
+		control->dispatchEvent(event);
+	}
+}
+
 void PPScreen::addTimerEventControl(PPControl* control)
 {
 	if (control->receiveTimerEvent() && !control->isContainer()) 
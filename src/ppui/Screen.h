@@ -77,6 +77,9 @@ private:
 
 	void adjustEventMouseCoordinates(PPEvent* event);
 
+	// send the timer event to the timer controls, only to those inside owner if given
+	void routeTimerEvent(PPEvent* event, PPControl* owner = NULL);
+
 	bool flat;
 	bool classic;
 
@@ -173,6 +173,15 @@ public:
 		values[index] = value;
 	}
 
+	// same without deleting the old value, i.e. for reordering
+	void replaceNoDestroy(pp_int32 index, Type* value)
+	{
+		if (index < 0 || index >= numValues)
+			return;
+
+		values[index] = value;
+	}
+
 	Type* get(pp_int32 index) const
 	{
 		if (index < numValues)
@@ -205,6 +205,33 @@ public:
 		return m_pUndoStack[m_nCurIndex+1];
 	}
 
+	//---------------------------------------------------------------------------
+	// Pre     : 
+	// Post    : 
+	// Globals : 
+	// I/O     : 
+	// Task    : Remove bottom entry as long as something is left to undo
+	//---------------------------------------------------------------------------
+	bool RemoveBottom()
+	{
+		if (m_nCurIndex < 1)
+			return false;
+		
+		delete m_pUndoStack[0];
+		
+		// move references
+		for (pp_int32 i = 0; i < m_nTopIndex; i++)
+			m_pUndoStack[i] = m_pUndoStack[i+1];
+		
+		m_pUndoStack[m_nTopIndex] = NULL;
+		
+		m_nCurIndex--;
+		m_nTopIndex--;
+		
+		m_bOverflow = true;
+		return true;
+	}
+
 	bool IsEmpty() const { return (m_nCurIndex == -1); }
 
 	bool IsTop() const { return ((m_nTopIndex-1)==m_nCurIndex); }
@@ -31,6 +31,7 @@
 #include "PPPath_POSIX.h"
 #include <sys/stat.h>
 #include <limits.h>
+#include <time.h>
 
 #ifdef __PSP__
 // Needed for PATH_MAX
@@ -87,18 +88,27 @@ bool PPPath_POSIX::updatePath()
 	return chdir(current) == 0;
 }
 
-PPPath_POSIX::PPPath_POSIX() 
+PPPath_POSIX::PPPath_POSIX() :
+	dir(NULL)
 {
 	current = getCurrent();
 	updatePath();
 }
 
 PPPath_POSIX::PPPath_POSIX(const PPSystemString& path) :
+	dir(NULL),
 	current(path)
 {
 	updatePath();
 }
 
+PPPath_POSIX::~PPPath_POSIX()
+{
+	// iteration stopped before the end
+	if (dir)
+		::closedir(dir);
+}
+
 const PPSystemString PPPath_POSIX::getCurrent()
 {
 	char cwd[PPMAX_DIR_PATH+1];
@@ -138,6 +148,9 @@ bool PPPath_POSIX::stepInto(const PPSystemString& directory)
 	
 const PPPathEntry* PPPath_POSIX::getFirstEntry()
 {
+	if (dir)
+		::closedir(dir);
+	
 	dir = ::opendir(current);
 	if (!dir) 
 	{
@@ -159,6 +172,7 @@ const PPPathEntry* PPPath_POSIX::getNextEntry()
 	}
 	
 	::closedir(dir);
+	dir = NULL;
 	return NULL;
 }
 
@@ -208,6 +222,23 @@ const PPSystemString PPPath_POSIX::getPathSeparator() const
 	return PPSystemString(getPathSeparatorAsASCII());
 }
 
+bool PPPath_POSIX::getCurrentStamp(pp_int64& time, pp_int64& size)
+{
+	struct stat dir_status;
+	
+	if (::stat(current, &dir_status) != 0 || !S_ISDIR(dir_status.st_mode))
+		return false;
+	
+	// the time only has a resolution of seconds, something could still
+	// change within the second the folder was last changed in
+	if (dir_status.st_mtime >= ::time(NULL) - 1)
+		return false;
+	
+	time = dir_status.st_mtime;
+	size = dir_status.st_size;
+	return true;
+}
+
 bool PPPath_POSIX::fileExists(const PPSystemString& fileName) const
 {
 	struct stat file_status;
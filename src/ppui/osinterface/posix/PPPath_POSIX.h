@@ -59,7 +59,7 @@ protected:
 public:
 	PPPath_POSIX();
 	PPPath_POSIX(const PPSystemString& path);
-	virtual ~PPPath_POSIX() {}
+	virtual ~PPPath_POSIX();
 
 	virtual const PPSystemString getCurrent();
 	
@@ -80,6 +80,8 @@ public:
 	virtual const PPSystemString getPathSeparator() const;
 	
 	virtual bool fileExists(const PPSystemString& fileName) const;
+
+	virtual bool getCurrentStamp(pp_int64& time, pp_int64& size);
 };
 
 #endif
@@ -165,6 +165,13 @@ PPPath_WIN32::PPPath_WIN32(const PPSystemString& path) :
 	updatePath();
 }
 
+PPPath_WIN32::~PPPath_WIN32()
+{
+	// iteration stopped before the end
+	if (hFind != NULL)
+		FindClose(hFind);
+}
+
 const PPSystemString PPPath_WIN32::getCurrent()
 {
 #ifndef _WIN32_WCE
@@ -299,10 +306,14 @@ const PPPathEntry* PPPath_WIN32::getFirstEntry()
 	PPSystemString current = this->current;
 	current.append("*.*");
 
+	if (hFind != NULL)
+		FindClose(hFind);
+
 	hFind = FindFirstFile(current, &fd);
 
 	if (hFind == INVALID_HANDLE_VALUE)
 	{
+		hFind = NULL;
 		return NULL;
 	}
 
@@ -367,6 +378,7 @@ const PPPathEntry* PPPath_WIN32::getNextEntry()
 	}
 	
 	FindClose(hFind);
+	hFind = NULL;
 	return NULL;
 }
 
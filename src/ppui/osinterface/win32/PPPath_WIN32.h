@@ -76,6 +76,7 @@ protected:
 public:
 	PPPath_WIN32();
 	PPPath_WIN32(const PPSystemString& path);
+	virtual ~PPPath_WIN32();
 
 	virtual const PPSystemString getCurrent();
 	
@@ -124,7 +124,8 @@ pp_int32 DialogSliders::handleEvent(PPObject* sender, PPEvent* event)
     needUpdate = true;
   }
   if( eID == eCommand && id == PP_MESSAGEBOX_BUTTON_CANCEL ){
-    sampleEditor->undo();
+    // a preview still being calculated hasn't touched the sample yet
+    if( !sampleEditor_->cancelToolJob() ) sampleEditor->undo();
     update();
   }else{
     if( clicked && valueChanged ){
@@ -133,6 +134,10 @@ pp_int32 DialogSliders::handleEvent(PPObject* sender, PPEvent* event)
       valueChanged = false;
     }
   }
+  // wait for the last preview before the dialog goes away
+  if( eID == eCommand && id == PP_MESSAGEBOX_BUTTON_YES ){
+    sampleEditor_->finishToolJob();
+  }
   if( needUpdate ) update();
 	return PPDialogBase::handleEvent(sender, event);
 }
@@ -144,10 +149,13 @@ void DialogSliders::process(){
     for( i = 0; i < numSliders; i++ ){
       par.setParameter(i, FilterParameters::Parameter( getSlider(i) ) );
     }
-    if( preview ){
+    if( preview && !sampleEditor_->cancelToolJob() ){
       sampleEditor->undo();
     }
-    (sampleEditor_->*func)(&par);
+    // the preview is calculated in the background and applied by the tracker when done
+    if( !sampleEditor_->startToolJob(func, &par) ){
+      (sampleEditor_->*func)(&par);
+    }
     preview = true;
   }
 }
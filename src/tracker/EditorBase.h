@@ -49,6 +49,8 @@ public:
 
 		NotificationChangesValidate,
 		NotificationChanges,
+		// only a part of the data has changed, the editor tells which one
+		NotificationChangesRange,
 		NotificationUpdateNoChanges,
 
 		NotificationFeedUndoData,
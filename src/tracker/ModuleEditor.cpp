@@ -589,6 +589,7 @@ void ModuleEditor::createEmptySong(bool clearPatterns/* = true*/, bool clearInst
 		setCurrentPatternIndex(0);
 	
 		module->createEmptySong(clearPatterns, clearInstruments, numChannels);
+		patternEditor->invalidateUndoPattern();
 
 		if (clearPatterns && clearInstruments)
 		{
@@ -680,8 +681,16 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 	if (!XMFile::exists(fileName))
 		return false;
 
-	mp_sint32 nRes = module->loadModule(fileName);
-	
+	return finishOpenSong(module->loadModule(fileName), preferredFileName ? preferredFileName : fileName);
+}
+
+bool ModuleEditor::openSong(XMFileBase& f, const SYSCHAR* fileName)
+{
+	return finishOpenSong(module->loadModule(f), fileName);
+}
+
+bool ModuleEditor::finishOpenSong(mp_sint32 nRes, const SYSCHAR* fileName)
+{
 	// unknown format
 	if (nRes == MP_UNKNOWN_FORMAT)
 	{
@@ -712,15 +721,17 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 			}
 		} 
 	
-		PPSystemString tempFile(getTempFilename());
-	
 		try
 		{
-			res = module->saveExtendedModule(tempFile) == MP_OK;
+			// convert to XM by saving and reloading, all in memory
+			XMMemoryFile f;
+			
+			res = module->saveExtendedModule(f) == MP_OK;
 			if(!res)
 				return res;
 
-			res = module->loadModule(tempFile) == MP_OK;
+			f.seek(0);
+			res = module->loadModule(f) == MP_OK;
 		} catch (const std::bad_alloc &) {
 			return false;
 		}
@@ -738,8 +749,6 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 				}
 			}
 		} 
-	
-		XMFile::remove(tempFile);
 	}
 
 	if (module->header.channum > TrackerConfig::numPlayerChannels)
@@ -757,7 +766,7 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 		for (mp_sint32 i = 0; i < module->header.patnum; i++)
 			getPattern(i);
 		
-		PPSystemString strFileName = preferredFileName ? preferredFileName : fileName;
+		PPSystemString strFileName = fileName;
 
 		moduleFileName = strFileName.stripExtension();
 		
@@ -774,6 +783,7 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 		createNewSong();
 	}
 
+	patternEditor->invalidateUndoPattern();
 	cleanUnusedPatterns();
 	
 	return res;
@@ -930,6 +940,7 @@ bool ModuleEditor::seqCurrentOrderPosition(mp_sint32 index, bool clone/* = false
 	{
 		// now clone pattern
 		module->phead[dstPatternIndex] = module->phead[srcPatternIndex];
+		patternEditor->invalidateUndoPattern();
 	}
 
 	changed = true;
@@ -2051,7 +2062,10 @@ pp_int32 ModuleEditor::insRemapSong(pp_int32 oldIns, pp_int32 newIns)
 	}
 
 	if (resCnt)
+	{
 		changed = true;
+		patternEditor->invalidateUndoPattern();
+	}
 		
 	return resCnt;
 }
@@ -2076,7 +2090,10 @@ pp_int32 ModuleEditor::noteTransposeSong(const PatternEditorTools::TransposePara
 	if (!evaluate)
 	{
 		if (resCnt)
+		{
 			changed = true;
+			patternEditor->invalidateUndoPattern();
+		}
 		
 		return resCnt;
 	}
@@ -2140,7 +2157,10 @@ pp_int32 ModuleEditor::panConvertSong(PanConversionTypes type)
 	}
 	
 	if (resCnt)
+	{
 		changed = true;
+		patternEditor->invalidateUndoPattern();
+	}
 
 	return resCnt;
 }
@@ -2152,6 +2172,7 @@ pp_int32 ModuleEditor::removeUnusedPatterns(bool evaluate)
 	if (!evaluate && result)
 	{
 		changed = true;
+		patternEditor->invalidateUndoPattern();
 		if (currentPatternIndex > module->header.patnum - 1)
 			currentPatternIndex = module->header.patnum - 1;
 	}
@@ -2380,7 +2401,10 @@ pp_int32 ModuleEditor::removeUnusedSamples(bool evaluate)
 	}
 	
 	if (!evaluate && result)
+	{
 		changed = true;
+		patternEditor->invalidateUndoPattern();
+	}
 
 	delete[] bitMap;
 
@@ -2400,7 +2424,10 @@ pp_int32 ModuleEditor::relocateCommands(const PatternEditorTools::RelocateParame
 	}
 	
 	if (!evaluate && result)
+	{
 		changed = true;
+		patternEditor->invalidateUndoPattern();
+	}
 
 	return result;
 }
@@ -2418,7 +2445,10 @@ pp_int32 ModuleEditor::zeroOperands(const PatternEditorTools::OperandOptimizePar
 	}
 
 	if (!evaluate && result)
+	{
 		changed = true;
+		patternEditor->invalidateUndoPattern();
+	}
 
 	return result;
 }
@@ -2436,7 +2466,10 @@ pp_int32 ModuleEditor::fillOperands(const PatternEditorTools::OperandOptimizePar
 	}
 
 	if (!evaluate && result)
+	{
 		changed = true;
+		patternEditor->invalidateUndoPattern();
+	}
 
 	return result;
 }
@@ -2543,6 +2576,8 @@ void ModuleEditor::adjustSampleOffsetCommandAfterSampleSizeChange(TXMSample *sam
 			}
 		}
 	}
+
+	patternEditor->invalidateUndoPattern();
 }
 
 void ModuleEditor::insertText(char* dst, const char* src, mp_sint32 max)
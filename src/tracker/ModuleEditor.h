@@ -240,7 +240,13 @@ public:
 	void createEmptySong(bool clearPatterns = true, bool clearInstruments = true, mp_sint32 numChannels = 8);
 	bool isEmpty() const;
 						 
+private:
+	bool finishOpenSong(mp_sint32 loadResult, const SYSCHAR* fileName);
+
+public:
 	bool openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFileName = NULL);	
+	// fileName is only used for naming the song, the data is read from f
+	bool openSong(XMFileBase& f, const SYSCHAR* fileName);
 	bool saveSong(const SYSCHAR* fileName, ModSaveTypes saveType = ModSaveTypeXM);
 	mp_sint32 saveBackup(const SYSCHAR* fileName);
 	
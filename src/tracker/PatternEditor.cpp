@@ -57,61 +57,256 @@ PatternEditor::ClipBoard* PatternEditor::ClipBoard::getInstance(ClipBoardTypes t
 	return instances[type];
 }
 
-void PatternEditor::prepareUndo()
+void PatternEditor::prepareUndo(bool cursorSlotOnly/* = false*/)
 {
-	PatternEditorTools patternEditorTools(pattern); 
-	patternEditorTools.normalize(); 
-
 	undoUserData.clear();
 	notifyListener(NotificationFeedUndoData);
 
-	delete before; 
-	before = new PatternUndoStackEntry(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData);
+	beforeUserData = undoUserData;
+	beforeCursor = cursor;
+
+	delete before;
+	before = NULL;
+
+	// a step which hasn't been finished might have left changes behind
+	if (undoPending)
+		undoPatternOutdated = true;
+	undoPending = true;
+	undoCursorSlotOnly = false;
+
+	// undoPattern still holds the current pattern, nothing to compare
+	if (!undoPatternOutdated && undoPatternFits())
+	{
+		undoCursorSlotOnly = cursorSlotOnly;
+		return;
+	}
+
+	PatternEditorTools patternEditorTools(pattern); 
+	patternEditorTools.normalize(); 
+
+	// pattern has been changed outside the undo stack, take a full snapshot
+	if (!undoPatternFits() ||
+		(pattern->patternData && memcmp(undoPattern.patternData, pattern->patternData, undoPattern.len) != 0))
+	{
+		before = new PatternUndoStackEntry(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData);
+	}
+	else
+	{
+		undoPatternOutdated = false;
+	}
 }
 
 bool PatternEditor::finishUndo(LastChanges lastChange, bool nonRepeat/* = false*/)
 {
 	bool result = false;
 
+	// single slot changes only have to look at that slot
+	bool slotOnly = undoCursorSlotOnly && pattern->patternData &&
+		beforeCursor.channel >= 0 && beforeCursor.channel < pattern->channum &&
+		beforeCursor.row >= 0 && beforeCursor.row < pattern->rows;
+
+	PatternUndoStackEntry::CellRange slot;
+	slot.startChannel = slot.endChannel = beforeCursor.channel;
+	slot.startRow = slot.endRow = beforeCursor.row;
+
 	PatternEditorTools patternEditorTools(pattern); 
-	patternEditorTools.normalize(); 
+	if (slotOnly)
+		patternEditorTools.normalizeSlot(beforeCursor.channel, beforeCursor.row);
+	else
+		patternEditorTools.normalize(); 
+
+	undoPending = false;
+	undoCursorSlotOnly = false;
 
 	undoUserData.clear();
 	notifyListener(NotificationFeedUndoData);
 
-	PatternUndoStackEntry after(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData); 
-	if (*before != after) 
-	{ 
-		PatternEditorTools::Position afterPos;
-		afterPos.channel = after.getCursorPositionChannel();
-		afterPos.row = after.getCursorPositionRow();
-		afterPos.inner = after.getCursorPositionInner();
+	bool changed, complete;
+	bool structural = !undoPatternFits();
+	PatternUndoStackEntry::CellRange range;
 
-		PatternEditorTools::Position beforePos;		
-		beforePos.channel = before->getCursorPositionChannel();
-		beforePos.row = before->getCursorPositionRow();
-		beforePos.inner = before->getCursorPositionInner();
-	
+	if (before)
+	{
+		PatternUndoStackEntry after(*pattern, cursor.channel, cursor.row, cursor.inner, &undoUserData); 
+		changed = *before != after;
+		complete = true;
+	}
+	else
+	{
+		changed = structural || findUndoPatternChanges(range, slotOnly ? &slot : NULL);
+		// resizing etc. and operations which replace their last step keep full snapshots
+		complete = structural || nonRepeat;
+	}
+
+	if (changed) 
+	{ 
 		result = true;
 		
-		lastOperationDidChangeRows = after.GetPattern().rows != before->GetPattern().rows;
-		lastOperationDidChangeCursor = beforePos != afterPos;
+		lastOperationDidChangeRows = pattern->rows != (before ? before->getNumRows() : undoPattern.rows);
+		lastOperationDidChangeCursor = beforeCursor != cursor;
 		notifyListener(NotificationChanges);
+		
+		// outside of the changed cells the checksum stays the same
+		pp_uint32 checkSum;
+		if (before || structural)
+			checkSum = PatternUndoStackEntry::calcCheckSum(*pattern);
+		else
+			checkSum = undoPatternCheckSum ^ 
+				PatternUndoStackEntry::calcCheckSum(undoPattern, &range) ^ 
+				PatternUndoStackEntry::calcCheckSum(*pattern, &range);
+		
 		if (undoStack) 
 		{ 
-			if (nonRepeat && this->lastChange != lastChange)
-				undoStack->Push(*before); 	
-			else if (!nonRepeat)
-				undoStack->Push(*before); 				
+			PatternUndoStackEntry after(*pattern, cursor.channel, cursor.row, cursor.inner, 
+										&undoUserData, complete ? NULL : &range, &checkSum);
+
+			if (before)
+			{
+				// the stack still refers to the state before the outside changes,
+				// keep it so these changes can be undone as well
+				if (!undoStack->IsEmpty())
+					undoStack->Push(PatternUndoStackEntry(undoPattern, beforeCursor.channel, beforeCursor.row, beforeCursor.inner, 
+														  &beforeUserData, NULL, &undoPatternCheckSum));
+				undoStack->Push(*before);
+			}
+			else if (!nonRepeat || this->lastChange != lastChange)
+			{
+				// the before entry is also used to redo the previous step,
+				// so it must cover the cells changed by that step as well
+				PatternUndoStackEntry::CellRange beforeRange = range;
+				if (undoPatternRangeValid)
+					beforeRange.include(undoPatternRange);
+			
+				PatternUndoStackEntry beforeEntry(undoPattern, beforeCursor.channel, beforeCursor.row, beforeCursor.inner, 
+												  &beforeUserData, complete || !undoPatternRangeValid ? NULL : &beforeRange, 
+												  &undoPatternCheckSum);
+
+				// partial entries are only restored on top of the states next to them
+				if (undoPatternRangeValid)
+					beforeEntry.setPrevCheckSum(undoPatternPrevCheckSum);
+				beforeEntry.setNextCheckSum(checkSum);
+				after.setPrevCheckSum(undoPatternCheckSum);
+
+				undoStack->Push(beforeEntry); 	
+			}
 			undoStack->Push(after); 
 			undoStack->Pop(); 
 		} 
+		
+		// a partial step always comes with a before entry taken from undoPattern
+		undoPatternPrevCheckSum = undoPatternCheckSum;
+		if (before || structural)
+			storeUndoPattern();
+		else
+			storeUndoPattern(range);
+		undoPatternCheckSum = checkSum;
+		undoPatternRange = range;
+		undoPatternRangeValid = !complete;
 	} 
 	this->lastChange = lastChange; 
 
+	delete before;
+	before = NULL;
+
 	return result;
 }
 
+bool PatternEditor::undoPatternFits() const
+{
+	return undoPattern.rows == pattern->rows &&
+		undoPattern.channum == pattern->channum &&
+		undoPattern.effnum == pattern->effnum &&
+		(undoPattern.patternData == NULL) == (pattern->patternData == NULL);
+}
+
+void PatternEditor::storeUndoPattern()
+{
+	mp_uint32 size = pattern->patternData ? pattern->rows*pattern->channum*(2+pattern->effnum*2) : 0;
+
+	if (size != undoPattern.len)
+	{
+		delete[] undoPattern.patternData;
+		undoPattern.patternData = size ? new mp_ubyte[size] : NULL;
+		undoPattern.len = size;
+	}
+	
+	undoPattern.rows = pattern->rows;
+	undoPattern.channum = pattern->channum;
+	undoPattern.effnum = pattern->effnum;
+	
+	if (size)
+		memcpy(undoPattern.patternData, pattern->patternData, size);
+		
+	undoPatternOutdated = false;
+}
+
+void PatternEditor::storeUndoPattern(const PatternUndoStackEntry::CellRange& range)
+{
+	const pp_int32 slotSize = 2 + pattern->effnum*2;
+	const pp_int32 rowLen = pattern->channum*slotSize;
+	const pp_int32 rangeLen = (range.endChannel - range.startChannel + 1)*slotSize;
+	
+	for (pp_int32 r = range.startRow; r <= range.endRow; r++)
+	{
+		const pp_int32 offset = r*rowLen + range.startChannel*slotSize;
+		memcpy(undoPattern.patternData + offset, pattern->patternData + offset, rangeLen);
+	}
+}
+
+bool PatternEditor::findUndoPatternChanges(PatternUndoStackEntry::CellRange& range, 
+										   const PatternUndoStackEntry::CellRange* within/* = NULL*/) const
+{
+	if (pattern->patternData == NULL || undoPattern.patternData == NULL)
+		return false;
+
+	const pp_int32 slotSize = 2 + pattern->effnum*2;
+	const pp_int32 rowLen = pattern->channum*slotSize;
+
+	PatternUndoStackEntry::CellRange area;
+	if (within)
+	{
+		area = *within;
+	}
+	else
+	{
+		area.startChannel = area.startRow = 0;
+		area.endChannel = pattern->channum - 1;
+		area.endRow = pattern->rows - 1;
+	}
+
+	const pp_int32 areaLen = (area.endChannel - area.startChannel + 1)*slotSize;
+
+	bool changed = false;
+	
+	for (pp_int32 r = area.startRow; r <= area.endRow; r++)
+	{
+		const mp_ubyte* src = pattern->patternData + r*rowLen;
+		const mp_ubyte* ref = undoPattern.patternData + r*rowLen;
+
+		if (memcmp(src + area.startChannel*slotSize, ref + area.startChannel*slotSize, areaLen) == 0)
+			continue;
+		
+		PatternUndoStackEntry::CellRange rowRange;
+		rowRange.startRow = rowRange.endRow = r;
+		
+		rowRange.startChannel = area.startChannel;
+		while (memcmp(src + rowRange.startChannel*slotSize, ref + rowRange.startChannel*slotSize, slotSize) == 0)
+			rowRange.startChannel++;
+			
+		rowRange.endChannel = area.endChannel;
+		while (memcmp(src + rowRange.endChannel*slotSize, ref + rowRange.endChannel*slotSize, slotSize) == 0)
+			rowRange.endChannel--;
+		
+		if (changed)
+			range.include(rowRange);
+		else
+			range = rowRange;
+		changed = true;
+	}
+	
+	return changed;
+}
+
 PatternEditor::PatternEditor() :
 	EditorBase(),
 	pattern(NULL),
@@ -122,6 +317,13 @@ PatternEditor::PatternEditor() :
 	instrumentBackTrace(false),
 	currentOctave(5),
 	before(NULL),
+	undoPattern(),
+	undoPatternCheckSum(0),
+	undoPatternPrevCheckSum(0),
+	undoPatternRangeValid(false),
+	undoPatternOutdated(false),
+	undoPending(false),
+	undoCursorSlotOnly(false),
 	undoStack(NULL),
 	lastChange(LastChangeNone)	
 {
@@ -139,6 +341,7 @@ PatternEditor::~PatternEditor()
 	delete undoHistory;
 	delete undoStack;
 	delete before;
+	delete[] undoPattern.patternData;
 }
 
 void PatternEditor::attachPattern(TXMPattern* pattern, XModule* module) 
@@ -167,6 +370,13 @@ void PatternEditor::attachPattern(TXMPattern* pattern, XModule* module)
 	attachModule(module);	
 	this->pattern = pattern; 
 	
+	if (pattern)
+	{
+		storeUndoPattern();
+		undoPatternCheckSum = PatternUndoStackEntry::calcCheckSum(*pattern);
+	}
+	undoPatternRangeValid = false;
+	
 	// couldn't get any from history, create new one
 	if (!undoStack)
 	{
@@ -185,6 +395,10 @@ void PatternEditor::reset()
 			
 	delete undoStack;
 	undoStack = new PPUndoStack<PatternUndoStackEntry>(UNDODEPTH_PATTERNEDITOR);	
+	
+	undoPatternRangeValid = false;
+	// usually a new song has been loaded into the same pattern
+	invalidateUndoPattern();
 }
 
 pp_int32 PatternEditor::getNumChannels() const
@@ -295,21 +509,36 @@ bool PatternEditor::redo()
 	return false;
 }
 
-bool PatternEditor::revoke(const PatternUndoStackEntry* stackEntry)
+void PatternEditor::resetUndoStack()
 {
-	const TXMPattern& stackPattern = stackEntry->GetPattern();
+	// pattern has been modified without going through the undo stack,
+	// the undo history doesn't apply anymore
+	delete undoStack;
+	undoStack = new PPUndoStack<PatternUndoStackEntry>(UNDODEPTH_PATTERNEDITOR);
+	undoPatternRangeValid = false;
+}
 
+bool PatternEditor::revoke(const PatternUndoStackEntry* stackEntry)
+{
 	enterCriticalSection();
 
 	bool res = false;
 
-	if (stackPattern.rows != pattern->rows ||
-		stackPattern.channum != pattern->channum ||
-		stackPattern.effnum != pattern->effnum)
+	if (stackEntry->getNumRows() != pattern->rows ||
+		stackEntry->getNumChannels() != pattern->channum ||
+		stackEntry->getNumEffects() != pattern->effnum)
 	{
-		pattern->rows = stackPattern.rows;
-		pattern->channum = stackPattern.channum;
-		pattern->effnum = stackPattern.effnum;
+		// a range of cells can't be put into a pattern of different size
+		if (!stackEntry->isComplete())
+		{
+			leaveCriticalSection();
+			resetUndoStack();
+			return false;
+		}
+	
+		pattern->rows = stackEntry->getNumRows();
+		pattern->channum = stackEntry->getNumChannels();
+		pattern->effnum = stackEntry->getNumEffects();
 	
 		mp_sint32 patternSize = pattern->rows*pattern->channum*(2+pattern->effnum*2);	
 
@@ -321,15 +550,48 @@ bool PatternEditor::revoke(const PatternUndoStackEntry* stackEntry)
 		}
 	}
 	
-	if (stackPattern.rows == pattern->rows &&
-		stackPattern.channum == pattern->channum &&
-		stackPattern.effnum == pattern->effnum)
+	if (stackEntry->getNumRows() == pattern->rows &&
+		stackEntry->getNumChannels() == pattern->channum &&
+		stackEntry->getNumEffects() == pattern->effnum)
 	{
 		cursor.channel = stackEntry->getCursorPositionChannel();
 		cursor.row = stackEntry->getCursorPositionRow();
 		cursor.inner = stackEntry->getCursorPositionInner();
 		
-		pattern->decompress(stackPattern.patternData, stackPattern.len);
+		if (!stackEntry->isComplete())
+		{
+			// the entry only holds the cells which differ from the states next 
+			// to it on the stack, the rest has to come from one of those
+			if (!undoPatternFits() || !pattern->patternData ||
+				!stackEntry->canRestoreFrom(undoPatternCheckSum))
+			{
+				leaveCriticalSection();
+				resetUndoStack();
+				return false;
+			}
+			
+			// drop changes made outside the undo stack, like a full snapshot would
+			if (undoPatternOutdated)
+			{
+				memcpy(pattern->patternData, undoPattern.patternData, undoPattern.len);
+				undoPatternOutdated = false;
+			}
+
+			stackEntry->restore(*pattern);
+			stackEntry->restore(undoPattern);
+		}
+		else
+		{
+			stackEntry->restore(*pattern);
+			storeUndoPattern();
+		}
+		undoPatternCheckSum = stackEntry->getCheckSum();
+		undoPending = false;
+
+		// the entry covers everything that differs from its neighbouring steps
+		undoPatternRange = stackEntry->getRange();
+		undoPatternPrevCheckSum = stackEntry->getPrevCheckSum();
+		undoPatternRangeValid = stackEntry->hasPrevCheckSum();
 
 		// keep over userdata
 		undoUserData = stackEntry->getUserData();
@@ -376,6 +638,8 @@ void PatternEditor::clearPattern()
 	pp_int32 patSize = pattern->channum * (pattern->effnum*2+2) * pattern->rows;	
 
 	memset(pattern->patternData, 0, patSize);
+
+	invalidateUndoPattern();
 }
 
 void PatternEditor::cut(ClipBoard& clipBoard)
@@ -1168,7 +1432,9 @@ bool PatternEditor::writeNote(pp_int32 note,
 							  PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
 	if (withUndo)
-		prepareUndo();
+		prepareUndo(true);
+	else
+		invalidateUndoPattern();
 
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
@@ -1214,6 +1480,10 @@ void PatternEditor::writeDirectNote(pp_int32 note,
 	if (order != -1)
 		pattern = &module->phead[module->header.ord[order]];
 
+	// live recording, not on the undo stack
+	if (pattern == this->pattern)
+		invalidateUndoPattern();
+
 	if (track == -1)
 		track = cursor.channel;
 		
@@ -1244,7 +1514,9 @@ bool PatternEditor::writeEffect(pp_int32 effNum, pp_uint8 eff, pp_uint8 op,
 								PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
 	if (withUndo)
-		prepareUndo();
+		prepareUndo(true);
+	else
+		invalidateUndoPattern();
 
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
@@ -1273,6 +1545,10 @@ void PatternEditor::writeDirectEffect(pp_int32 effNum, pp_uint8 eff, pp_uint8 op
 	if (order != -1)
 		pattern = &module->phead[module->header.ord[order]];
 
+	// live recording, not on the undo stack
+	if (pattern == this->pattern)
+		invalidateUndoPattern();
+
 	if (track == -1)
 		track = cursor.channel;
 		
@@ -1292,7 +1568,9 @@ void PatternEditor::writeDirectEffect(pp_int32 effNum, pp_uint8 eff, pp_uint8 op
 bool PatternEditor::writeInstrument(NibbleTypes nibleType, pp_uint8 value, bool withUndo/* = false*/, PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
 	if (withUndo)
-		prepareUndo();
+		prepareUndo(true);
+	else
+		invalidateUndoPattern();
 
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
@@ -1344,7 +1622,9 @@ bool PatternEditor::writeInstrument(NibbleTypes nibleType, pp_uint8 value, bool
 bool PatternEditor::writeFT2Volume(NibbleTypes nibleType, pp_uint8 value, bool withUndo/* = false*/, PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
 	if (withUndo)
-		prepareUndo();
+		prepareUndo(true);
+	else
+		invalidateUndoPattern();
 
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
@@ -1448,7 +1728,9 @@ bool PatternEditor::writeFT2Volume(NibbleTypes nibleType, pp_uint8 value, bool w
 bool PatternEditor::writeEffectNumber(pp_uint8 value, bool withUndo/* = false*/, PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
 	if (withUndo)
-		prepareUndo();
+		prepareUndo(true);
+	else
+		invalidateUndoPattern();
 
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
@@ -1501,7 +1783,9 @@ bool PatternEditor::writeEffectNumber(pp_uint8 value, bool withUndo/* = false*/,
 bool PatternEditor::writeEffectOperand(NibbleTypes nibleType, pp_uint8 value, bool withUndo/* = false*/, PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
 	if (withUndo)
-		prepareUndo();
+		prepareUndo(true);
+	else
+		invalidateUndoPattern();
 
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
@@ -1595,7 +1879,7 @@ void PatternEditor::writeMacroToCursor(pp_int32 slot, PatternAdvanceInterface* a
 	if (slot > 10 || slot < 0)
 		return;
 
-	prepareUndo();	
+	prepareUndo(true);	
 
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
@@ -1643,7 +1927,7 @@ void PatternEditor::setMacroOperands(pp_int32 slot, pp_uint8 eff, pp_uint8 op)
 
 void PatternEditor::deleteCursorSlotData(PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {	
-	prepareUndo();
+	prepareUndo(true);
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
 	if (cursor.inner == 3 || cursor.inner == 4)
@@ -1672,7 +1956,7 @@ void PatternEditor::deleteCursorSlotData(PatternAdvanceInterface* advanceImpl/*
 
 void PatternEditor::deleteCursorSlotDataEntire(PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
-	prepareUndo();
+	prepareUndo(true);
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
 	patternTools.setNote(0);
@@ -1688,7 +1972,7 @@ void PatternEditor::deleteCursorSlotDataEntire(PatternAdvanceInterface* advanceI
 
 void PatternEditor::deleteCursorSlotDataVolumeAndEffect(PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
-	prepareUndo();
+	prepareUndo(true);
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
 	patternTools.setFirstEffect(0,0);
@@ -1702,7 +1986,7 @@ void PatternEditor::deleteCursorSlotDataVolumeAndEffect(PatternAdvanceInterface*
 
 void PatternEditor::deleteCursorSlotDataEffect(PatternAdvanceInterface* advanceImpl/* = NULL*/)
 {
-	prepareUndo();
+	prepareUndo(true);
 	PatternTools patternTools;
 	patternTools.setPosition(pattern, cursor.channel, cursor.row);
 	pp_int32 eff, op;
@@ -1892,6 +2176,8 @@ bool PatternEditor::writeStep(pp_uint32 channel,
 {
 	if (withUndo)
 		prepareUndo();
+	else
+		invalidateUndoPattern();
 	// ASCIISTEP16 standard (https://gist.github.com/coderofsalvation/8d760b191f4bb5465c8772d5618e5c4b)
 	// determines final cursor position based on pckeyboard stepvalue
 	cursor.row = step;
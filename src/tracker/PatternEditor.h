@@ -213,7 +213,25 @@ private:
 		
 	// undo/redo information
 	UndoStackEntry::UserData undoUserData;
+	UndoStackEntry::UserData beforeUserData;
+	PatternEditorTools::Position beforeCursor;
+	// full snapshot, only taken if the pattern was changed outside the undo stack
 	PatternUndoStackEntry* before;
+	// pattern contents after the last undo step, undo entries only keep
+	// the cells that differ from it
+	TXMPattern undoPattern;
+	pp_uint32 undoPatternCheckSum;
+	// cells in which undoPattern differs from the undo step before
+	// and the checksum of that step
+	PatternUndoStackEntry::CellRange undoPatternRange;
+	pp_uint32 undoPatternPrevCheckSum;
+	bool undoPatternRangeValid;
+	// the pattern might have been changed without going through the undo
+	// stack, only then it's compared against undoPattern
+	bool undoPatternOutdated;
+	bool undoPending;
+	// the prepared step only changes the slot under the cursor
+	bool undoCursorSlotOnly;
 	PPUndoStack<PatternUndoStackEntry>* undoStack;	
 	UndoHistory<TXMPattern, PatternUndoStackEntry>* undoHistory;
 	LastChanges lastChange;	
@@ -222,9 +240,15 @@ private:
 
 	TCommand effectMacros[20];
 
-	void prepareUndo();
+	void prepareUndo(bool cursorSlotOnly = false);
 	bool finishUndo(LastChanges lastChange, bool nonRepeat = false);
+	bool undoPatternFits() const;
+	void storeUndoPattern();
+	void storeUndoPattern(const PatternUndoStackEntry::CellRange& range);
+	bool findUndoPatternChanges(PatternUndoStackEntry::CellRange& range, 
+								const PatternUndoStackEntry::CellRange* within = NULL) const;
 	
+	void resetUndoStack();
 	bool revoke(const PatternUndoStackEntry* stackEntry);
 
 	void cut(ClipBoard& clipBoard);
@@ -296,6 +320,8 @@ public:
 	void setUndoUserData(const void* data, pp_uint32 dataLen) { this->undoUserData = UndoStackEntry::UserData((pp_uint8*)data, dataLen); }
 	pp_uint32 getUndoUserDataLen() const { return undoUserData.getDataLen(); }
 	const void* getUndoUserData() const { return (void*)undoUserData.getData(); }
+	// call after changing the pattern without going through the undo stack
+	void invalidateUndoPattern() { undoPatternOutdated = true; }
 	
 	// --- dealing with the pattern data -------------------------------------
 	void clearSelection();
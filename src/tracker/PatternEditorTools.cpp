@@ -1718,6 +1718,25 @@ void PatternEditorTools::normalize()
 	
 }
 
+void PatternEditorTools::normalizeSlot(pp_int32 channel, pp_int32 row)
+{
+	if (pattern == NULL || pattern->patternData == NULL) 
+		return;
+
+	if (channel < 0 || channel >= pattern->channum || row < 0 || row >= pattern->rows)
+		return;
+
+	mp_sint32 slotSize = pattern->effnum * 2 + 2;
+
+	mp_ubyte* eff = pattern->patternData + (row*pattern->channum + channel)*slotSize + 2;
+	for (pp_int32 k = 0; k < pattern->effnum; k++)
+	{
+		// check for empty arpeggio
+		if (eff[k*2] == 0x20 && eff[k*2+1] == 0)
+			eff[k*2] = 0;
+	}
+}
+
 bool PatternEditorTools::selectionContains(const TXMPattern* pattern, const Position& ss, const Position& se, const Position& pos)
 {
 	pp_int32 selectionStartChannel;
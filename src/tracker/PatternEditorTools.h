@@ -196,6 +196,7 @@ public:
 	pp_int32 swapChannels(pp_int32 dstChannel, pp_int32 srcChannel);
 	
 	void normalize();
+	void normalizeSlot(pp_int32 channel, pp_int32 row);
 	
 	static void slotCopy(mp_ubyte* dst, mp_ubyte* src, pp_int32 from, pp_int32 to);
 	static void slotTransparentCopy(mp_ubyte* dst, mp_ubyte* src, pp_int32 from, pp_int32 to);
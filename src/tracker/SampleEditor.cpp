@@ -40,6 +40,10 @@
 #include "PlayerMaster.h"
 #include "Addon.h"
 #include "SampleLoaderSF2.h"
+#include "ParallelFor.h"
+#include "fx/STFT.h"
+#include <thread>
+#include <vector>
 
 #define ZEROCROSS(a,b) (a > 0.0 && b <= 0.0 || a < 0.0 && b >= 0.0)
 
@@ -48,6 +52,21 @@ SampleEditor::ClipBoard::ClipBoard() :
 {
 }
 
+SampleEditor::ClipBoard::ClipBoard(const ClipBoard& source) :
+		numBits(source.numBits),
+		buffer(NULL),
+		selectionStart(source.selectionStart),
+		selectionEnd(source.selectionEnd),
+		selectionWidth(source.selectionWidth)
+{
+	if (source.buffer == NULL)
+		return;
+
+	pp_uint32 size = (selectionWidth+1) * (numBits == 16 ? 2 : 1);
+	buffer = new mp_sbyte[size];
+	memcpy(buffer, source.buffer, size);
+}
+
 SampleEditor::ClipBoard::~ClipBoard()
 {
 	delete[] buffer;
@@ -177,6 +196,41 @@ void SampleEditor::ClipBoard::paste(TXMSample& sample, XModule& module, pp_int32
 
 }
 
+// Find how many bytes at the start and at the end of the sample
+// data didn't change, returns true if nothing changed at all
+static bool findUnchangedRange(const SampleUndoStackEntry& before, const TXMSample& after, 
+							   pp_uint32& prefixLen, pp_uint32& suffixLen)
+{
+	prefixLen = suffixLen = 0;
+
+	bool afterHasData = after.sample != NULL && after.samplen != 0;
+	if (!before.hasData() || !afterHasData)
+		return before.hasData() == afterHasData;
+	
+	const pp_uint8* src = before.getBuffer();
+	if (src == NULL || (before.getFlags() & 16) != (after.type & 16))
+		return false;
+	
+	const pp_uint8* dst = (const pp_uint8*)after.sample;
+	pp_uint32 srcSize = before.getSize();
+	pp_uint32 dstSize = (after.type & 16) ? after.samplen*2 : after.samplen;
+	pp_uint32 minSize = srcSize < dstSize ? srcSize : dstSize;
+	
+	while (prefixLen < minSize && src[prefixLen] == dst[prefixLen])
+		prefixLen++;
+	while (suffixLen < minSize - prefixLen && src[srcSize-1-suffixLen] == dst[dstSize-1-suffixLen])
+		suffixLen++;
+
+	// don't split 16 bit sample values
+	if (after.type & 16)
+	{
+		prefixLen&=~1;
+		suffixLen&=~1;
+	}
+	
+	return srcSize == dstSize && prefixLen == srcSize;
+}
+
 void SampleEditor::prepareUndo()
 {
 	delete before; 
@@ -187,10 +241,18 @@ void SampleEditor::prepareUndo()
 		undoUserData.clear();
 		notifyListener(NotificationFeedUndoData);
 
+		// compare sample data without the loop double buffering
+		sample->restoreOriginalState();
+
 		before = new SampleUndoStackEntry(*sample, 
 										  getSelectionStart(), 
 										  getSelectionEnd(), 
 										  &undoUserData);
+		
+		// sample has been modified without going through the undo stack
+		if (undoStateValid && 
+			(before->getSize() != undoStateSize || before->getCheckSum() != undoStateCheckSum))
+			undoStateValid = false;
 	}
 }
 
@@ -198,6 +260,9 @@ void SampleEditor::finishUndo()
 {
 	lastOperationDidChangeSize = before == NULL || (sample->samplen != before->getSampLen());
 
+	// without a state to compare with all of the sample counts as changed
+	pp_int32 changedStart = 0, changedEnd = sample->samplen;
+
 	if (undoStackEnabled && undoStackActivated && undoStack) 
 	{ 
 		// first of all the listener should get the chance to adjust
@@ -209,21 +274,65 @@ void SampleEditor::finishUndo()
 		// we want some user data now
 		notifyListener(NotificationFeedUndoData);
 
+		sample->restoreOriginalState();
+
+		pp_uint32 prefixLen = 0, suffixLen = 0;
+		bool unchanged = before != NULL && findUnchangedRange(*before, *sample, prefixLen, suffixLen);
+
+		if (unchanged)
+			changedStart = changedEnd = 0;
+		else if (before != NULL)
+		{
+			pp_int32 shift = (sample->type & 16) ? 1 : 0;
+			changedStart = prefixLen >> shift;
+			if (!lastOperationDidChangeSize)
+				changedEnd = sample->samplen - (suffixLen >> shift);
+		}
+
+		// only the changed part of the sample is stored
 		SampleUndoStackEntry after(SampleUndoStackEntry(*sample, 
 										 getSelectionStart(), 
 										 getSelectionEnd(), 
-										 &undoUserData)); 
-		if (before != NULL && *before != after) 
+										 &undoUserData,
+										 prefixLen,
+										 suffixLen)); 
+		if (before != NULL && (!unchanged || *before != after)) 
 		{ 
+			// the state before has to be restorable from the state after it
+			// and from the state before it on the stack
+			if (undoStateValid)
+			{
+				before->trim(prefixLen < undoStatePrefixLen ? prefixLen : undoStatePrefixLen,
+							 suffixLen < undoStateSuffixLen ? suffixLen : undoStateSuffixLen);
+				before->setPrevCheckSum(undoStatePrevCheckSum);
+			}
+			before->setNextCheckSum(after.getCheckSum());
+			before->pack();
+			
+			after.setPrevCheckSum(before->getCheckSum());
+			after.pack();
+
 			if (undoStack) 
 			{ 
 				undoStack->Push(*before); 
 				undoStack->Push(after); 
 				undoStack->Pop(); 
 			} 
+			
+			undoStateValid = true;
+			undoStateSize = after.getSize();
+			undoStateCheckSum = after.getCheckSum();
+			undoStatePrevCheckSum = before->getCheckSum();
+			undoStatePrefixLen = prefixLen;
+			undoStateSuffixLen = suffixLen;
 		} 
 	} 
 	
+	if (undoStackEnabled)
+		enforceUndoBudget();
+	
+	notifyChangedRange(changedStart, changedEnd);
+
 	// we're done, client might want to refresh the screen or whatever
 	notifyListener(NotificationChanges);			
 }
@@ -235,6 +344,52 @@ bool SampleEditor::revoke(const SampleUndoStackEntry* stackEntry)
 	 if (undoStack == NULL || !undoStackEnabled)
 		return false;
 		
+	enterCriticalSection();
+	
+	sample->restoreOriginalState();
+	
+	pp_uint32 size = 0;
+	if (sample->sample && sample->samplen)
+		size = (sample->type & 16) ? sample->samplen*2 : sample->samplen;
+
+	// entry only contains the part which differs from the neighbouring
+	// states, the rest comes from the current sample
+	if (!stackEntry->isComplete() && 
+		!stackEntry->canRestoreFrom(SampleUndoStackEntry::calcCheckSum((const pp_uint8*)sample->sample, size), size))
+	{
+		leaveCriticalSection();
+		
+		// sample has been modified without going through the undo stack,
+		// the undo history doesn't apply anymore
+		delete undoStack;
+		undoStack = new PPUndoStack<SampleUndoStackEntry>(UNDODEPTH_SAMPLEEDITOR);
+		undoStateValid = false;
+		return false;
+	}
+	
+	// the stored part is all that differs from the current state
+	pp_int32 changedStart = 0, changedEnd = stackEntry->getSampLen();
+	if (stackEntry->hasData() && sample->sample && (sample->type & 16) == (stackEntry->getFlags() & 16))
+	{
+		pp_int32 shift = (sample->type & 16) ? 1 : 0;
+		changedStart = stackEntry->getPrefixLen() >> shift;
+		if (size == stackEntry->getSize())
+			changedEnd -= stackEntry->getSuffixLen() >> shift;
+	}
+
+	mp_sbyte* newSample = NULL;
+	if (stackEntry->hasData())
+	{
+		newSample = (mp_sbyte*)module->allocSampleMem(stackEntry->getSize());
+		if (newSample)
+			stackEntry->restoreData((pp_uint8*)newSample, (const pp_uint8*)sample->sample, size);
+	}
+	
+	// free old sample memory
+	if (sample->sample)
+		module->freeSampleMem((mp_ubyte*)sample->sample);
+	sample->sample = newSample;
+	
 	sample->samplen = stackEntry->getSampLen();
 	sample->loopstart = stackEntry->getLoopStart(); 
 	sample->looplen = stackEntry->getLoopLen(); 
@@ -242,39 +397,38 @@ bool SampleEditor::revoke(const SampleUndoStackEntry* stackEntry)
 	sample->finetune = stackEntry->getFineTune(); 
 	sample->type = (mp_ubyte)stackEntry->getFlags();
 	
+	leaveCriticalSection();
+
 	setSelectionStart(stackEntry->getSelectionStart());
 	setSelectionEnd(stackEntry->getSelectionEnd());
 	
-	enterCriticalSection();
+	undoStateValid = stackEntry->hasPrevCheckSum();
+	undoStateSize = stackEntry->getSize();
+	undoStateCheckSum = stackEntry->getCheckSum();
+	undoStatePrevCheckSum = stackEntry->getPrevCheckSum();
+	undoStatePrefixLen = stackEntry->getPrefixLen();
+	undoStateSuffixLen = stackEntry->getSuffixLen();
 	
-	// free old sample memory
-	if (sample->sample)
-	{
-		module->freeSampleMem((mp_ubyte*)sample->sample);
-		sample->sample = NULL;
-	}
-	
-	if (stackEntry->getBuffer())
-	{			
-		if (sample->type & 16)
-		{
-			sample->sample = (mp_sbyte*)module->allocSampleMem(sample->samplen*2);
-			TXMSample::copyPaddedMem(sample->sample, stackEntry->getBuffer(), sample->samplen*2);
-		}
-		else
-		{
-			sample->sample = (mp_sbyte*)module->allocSampleMem(sample->samplen);
-			TXMSample::copyPaddedMem(sample->sample, stackEntry->getBuffer(), sample->samplen);
-		}
-	}
-	
-	leaveCriticalSection();
 	undoUserData = stackEntry->getUserData();
 	notifyListener(NotificationFetchUndoData);
+	notifyChangedRange(changedStart, changedEnd);
 	notifyListener(NotificationChanges);
 	return true;
 }
 
+void SampleEditor::enforceUndoBudget()
+{
+	// drop the history of other samples first, then the oldest steps
+	while (SampleUndoStackEntry::getTotalMemoryUsage() > UNDOBUDGET_SAMPLEEDITOR)
+	{
+		if (undoHistory && undoHistory->removeOldest())
+			continue;
+		if (undoStack && undoStack->RemoveBottom())
+			continue;
+		break;
+	}
+}
+
 void SampleEditor::notifyChanges(bool condition, bool lazy/* = true*/)
 {
 	lastOperation = OperationRegular;	
@@ -293,6 +447,16 @@ void SampleEditor::notifyChanges(bool condition, bool lazy/* = true*/)
 	}
 }
 
+void SampleEditor::notifyChangedRange(pp_int32 start, pp_int32 end)
+{
+	if (start >= end)
+		return;
+
+	changedRangeStart = start;
+	changedRangeEnd = end;
+	notifyListener(NotificationChangesRange);
+}
+
 SampleEditor::SampleEditor() :
 	EditorBase(),
 	sample(NULL),
@@ -300,10 +464,22 @@ SampleEditor::SampleEditor() :
 	undoStackActivated(true),	
 	before(NULL),
 	undoStack(NULL),
+	undoStateValid(false),
+	undoStateSize(0),
+	undoStateCheckSum(0),
+	undoStatePrevCheckSum(0),
+	undoStatePrefixLen(0),
+	undoStateSuffixLen(0),
 	lastOperationDidChangeSize(false),
 	lastOperation(OperationRegular),
+	changedRangeStart(0),
+	changedRangeEnd(0),
 	drawing(false),
 	lastSamplePos(-1),
+	toolJob(NULL),
+	toolProgress(0.0f),
+	toolCancelled(false),
+	toolClipBoard(NULL),
 	lastParameters(NULL),
 	lastFilterFunc(NULL)
 {
@@ -320,6 +496,8 @@ SampleEditor::SampleEditor() :
 
 SampleEditor::~SampleEditor()
 {
+	cancelToolJob();
+
 	delete lastParameters;
 	delete undoHistory;
 	delete undoStack;
@@ -333,8 +511,12 @@ void SampleEditor::attachSample(TXMSample* sample, XModule* module)
 	if (sample->equals(lastSample) && sample == this->sample)
 		return;
 
+	cancelToolJob();
+
 	lastSample = *sample;
 
+	undoStateValid = false;
+
 	// --------- update undo history information --------------------	
 	if (undoStackEnabled && undoStackActivated)
 	{
@@ -372,6 +554,8 @@ void SampleEditor::attachSample(TXMSample* sample, XModule* module)
 
 void SampleEditor::reset()
 {
+	undoStateValid = false;
+
 	if (undoStackEnabled)
 	{
 		if (undoHistory)
@@ -867,6 +1051,9 @@ void SampleEditor::drawSample(pp_int32 sampleIndex, float s)
 		setFloatSampleInWaveform(si, froms);
 		froms+=step;
 	}	
+
+	// the whole stroke is reported again by endDrawing
+	notifyChangedRange(from, to+1 < (signed)sample->samplen ? to+1 : sample->samplen);
 }
 
 void SampleEditor::endDrawing()
@@ -1177,6 +1364,396 @@ void SampleEditor::setFloatSampleInWaveform(pp_int32 index, float singleSample,
 	}
 }
 
+// spans of the sample converted to floats at once
+#define FLOATSPANSIZE 4096
+
+/*
+  Call func(block, pos, data, count) for float spans of every block of parallel,
+  the spans are stored back into the sample afterwards when write is set
+ */
+template<class Func>
+void SampleEditor::processFloat(ParallelFor& parallel, bool write, Func func)
+{
+	// get the real loop area data in place now, the blocks would race for it otherwise
+	if (write)
+		sample->restoreOriginalState();
+
+	std::atomic<pp_int32> processed(0);
+
+	parallel.run([&](pp_int32 block, pp_int32 from, pp_int32 to)
+	{
+		float data[FLOATSPANSIZE];
+		for (pp_int32 pos = from; pos < to; pos += FLOATSPANSIZE)
+		{
+			pp_int32 count = to - pos < FLOATSPANSIZE ? to - pos : FLOATSPANSIZE;
+			sample->readFloat(pos, count, data);
+			func(block, pos, data, count);
+			if (write)
+				sample->writeFloat(pos, count, data);
+
+			if (!reportProgress(processed += count, parallel.getLength()))
+			{
+				parallel.cancel();
+				break;
+			}
+		}
+	});
+}
+
+float SampleEditor::getPeak(pp_int32 sStart, pp_int32 sEnd)
+{
+	ParallelFor parallel(sStart, sEnd);
+	std::vector<float> peaks(parallel.getNumBlocks(), 0.0f);
+
+	processFloat(parallel, false, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
+	{
+		float peak = peaks[block];
+		for (pp_int32 i = 0; i < count; i++)
+		{
+			float f = ppfabs(data[i]);
+			if (f > peak) peak = f;
+		}
+		peaks[block] = peak;
+	});
+
+	float peak = 0.0f;
+	for (size_t i = 0; i < peaks.size(); i++)
+		if (peaks[i] > peak) peak = peaks[i];
+
+	return peak;
+}
+
+/*
+  Run a linear recursive filter over [sStart, sEnd) on all cores:
+   [1] filter every block from a silent state and keep the end state
+   [2] chain the real block start states: the end state of the previous
+       block plus what is left of the previous start state after feeding
+       it silence over the previous block (stops early once it died out)
+   [3] filter every block again from its real start state
+  State needs clear(), add(), isSilent() and float process(index, in),
+  output(index, in, filtered) returns the value to store
+ */
+template<class State, class Output>
+void SampleEditor::filterParallel(pp_int32 sStart, pp_int32 sEnd, const State& initial, Output output)
+{
+	// splitting only pays off with more than one core
+	ParallelFor parallel(sStart, sEnd, ParallelFor::getNumThreads() > 1 ? 65536 : sEnd - sStart);
+	pp_int32 numBlocks = parallel.getNumBlocks();
+	std::vector<State> starts(numBlocks, initial);
+
+	if (numBlocks > 1)
+	{
+		std::vector<State> ends(numBlocks, initial);
+		for (pp_int32 block = 0; block < numBlocks; block++)
+			ends[block].clear();
+
+		processFloat(parallel, false, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
+		{
+			State& state = ends[block];
+			for (pp_int32 i = 0; i < count; i++)
+				state.process(pos + i, data[i]);
+		});
+
+		for (pp_int32 block = 1; block < numBlocks; block++)
+		{
+			State decay = starts[block - 1];
+			pp_int32 to = parallel.getBlockEnd(block - 1);
+			for (pp_int32 i = parallel.getBlockStart(block - 1); i < to && !decay.isSilent(); i++)
+				decay.process(i, 0.0f);
+
+			starts[block] = ends[block - 1];
+			if (!decay.isSilent())
+				starts[block].add(decay);
+		}
+	}
+
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
+	{
+		State& state = starts[block];
+		for (pp_int32 i = 0; i < count; i++)
+			data[i] = output(pos + i, data[i], state.process(pos + i, data[i]));
+	});
+}
+
+// filter states for filterParallel()
+struct EQState
+{
+	Equalizer eqs[10];
+	pp_int32 numBands;
+
+	void clear()
+	{
+		for (pp_int32 i = 0; i < numBands; i++)
+			eqs[i].ClearHistory();
+	}
+
+	void add(const EQState& state)
+	{
+		for (pp_int32 i = 0; i < numBands; i++)
+			eqs[i].AddHistory(state.eqs[i]);
+	}
+
+	bool isSilent() const
+	{
+		for (pp_int32 i = 0; i < numBands; i++)
+			if (!eqs[i].IsSilent(1e-9))
+				return false;
+		return true;
+	}
+
+	float process(pp_int32 index, float in)
+	{
+		// Fetch a stereo signal
+		double xL = in;
+		double xR = xL;
+
+		for (pp_int32 j = 0; j < numBands; j++)
+		{
+			double yL, yR;
+			// Pass the stereo input
+			eqs[j].Filter(xL, xR, yL, yR);
+
+			xL = yL;
+			xR = yR;
+		}
+
+		return (float)xL;
+	}
+};
+
+static void clearMultifilterState(multifilter_state_t& state)
+{
+	state.x1 = state.x2 = state.y1 = state.y2 = 0.0f;
+}
+
+static void addMultifilterState(multifilter_state_t& state, const multifilter_state_t& other)
+{
+	state.x1 += other.x1; state.x2 += other.x2;
+	state.y1 += other.y1; state.y2 += other.y2;
+}
+
+static bool isSilentMultifilterState(const multifilter_state_t& state)
+{
+	return ppfabs(state.x1) < 1e-9f && ppfabs(state.x2) < 1e-9f && ppfabs(state.y1) < 1e-9f && ppfabs(state.y2) < 1e-9f;
+}
+
+struct MultifilterState
+{
+	multifilter_t filter;
+	multifilter_state_t state;
+
+	void clear() { clearMultifilterState(state); }
+	void add(const MultifilterState& other) { addMultifilterState(state, other.state); }
+	bool isSilent() const { return isSilentMultifilterState(state); }
+	float process(pp_int32 index, float in) { return Filter::multifilter(&filter, &state, in); }
+};
+
+// low pass followed by a high pass or a sweeping multifilter
+struct SweepFilterState
+{
+	filter_t lp;
+	filter_t hp;
+	multifilter_state_t sweepState;
+	multifilter_type_t type;
+	pp_int32 sweep;
+	pp_int32 samplerate;
+	float sweepmin;
+	float sweepadd;
+
+	void clear()
+	{
+		lp.s0 = lp.s1 = hp.s0 = hp.s1 = 0.0f;
+		clearMultifilterState(sweepState);
+	}
+
+	void add(const SweepFilterState& other)
+	{
+		lp.s0 += other.lp.s0; lp.s1 += other.lp.s1;
+		hp.s0 += other.hp.s0; hp.s1 += other.hp.s1;
+		addMultifilterState(sweepState, other.sweepState);
+	}
+
+	bool isSilent() const
+	{
+		return ppfabs(lp.s0) < 1e-9f && ppfabs(lp.s1) < 1e-9f && ppfabs(hp.s0) < 1e-9f && ppfabs(hp.s1) < 1e-9f &&
+			   isSilentMultifilterState(sweepState);
+	}
+
+	float process(pp_int32 index, float in)
+	{
+		Filter::process( in, (filter_t *)&lp );               // apply LP (+grit)
+		float out = lp.out_lp;
+		if( sweep == 0 ){
+			Filter::process( out, (filter_t *)&hp );          // apply HP
+			out = hp.out_hp;
+		}else{
+			multifilter_t filter;
+			Filter::multifilter_set(&filter,
+					samplerate,
+					type,
+					sweepmin + (float(index)*sweepadd),        // freq
+					0.1+hp.q,                                  // res
+					1.0);                                      // gain
+			out = Filter::multifilter(&filter, &sweepState, out );// sweep it!
+		}
+		return out;
+	}
+};
+
+bool SampleEditor::reportProgress(pp_int32 pos, pp_int32 len)
+{
+	if (len > 0)
+		toolProgress = (float)pos / (float)len;
+	return !toolCancelled;
+}
+
+bool SampleEditor::reportConvolverProgress(void* editor, int pos, int len)
+{
+	return static_cast<SampleEditor*>(editor)->reportProgress(pos, len);
+}
+
+// the copy of the sample lives in a module of its own, so the tool can
+// allocate and free sample memory without touching the song
+class SampleEditor::ToolJob
+{
+public:
+	XModule module;
+	SampleEditor editor;
+	TFilterFunc filterFuncPtr;
+	FilterParameters* par;
+	ClipBoard* clipBoard;
+	std::thread thread;
+	std::atomic<bool> done;
+
+	ToolJob(TFilterFunc filterFuncPtr, const FilterParameters* par) :
+		filterFuncPtr(filterFuncPtr),
+		par(par ? new FilterParameters(*par) : NULL),
+		clipBoard(NULL),
+		done(false)
+	{
+	}
+
+	~ToolJob()
+	{
+		delete clipBoard;
+		delete par;
+	}
+
+	void run()
+	{
+		(editor.*filterFuncPtr)(par);
+		done = true;
+	}
+};
+
+bool SampleEditor::startToolJob(TFilterFunc filterFuncPtr, const FilterParameters* par)
+{
+	// these go through the tracker, the synth dialog or the file system
+	if (filterFuncPtr == &SampleEditor::tool_addon || 
+		filterFuncPtr == &SampleEditor::tool_soundfont || 
+		filterFuncPtr == &SampleEditor::tool_synth)
+		return false;
+
+	if (isEmptySample())
+		return false;
+
+	cancelToolJob();
+
+	toolJob = new ToolJob(filterFuncPtr, par);
+
+	// copy the sample data along with the loop double buffer
+	TXMSample& copy = toolJob->module.smp[0];
+	copy = *sample;
+	mp_uint32 size = TXMSample::getSampleSizeInBytes((mp_ubyte*)sample->sample);
+	copy.sample = (mp_sbyte*)toolJob->module.allocSampleMem(size);
+	TXMSample::copyPaddedMem(copy.sample, sample->sample, size);
+
+	SampleEditor& editor = toolJob->editor;
+	editor.enableUndoStack(false);
+	editor.attachSample(&copy, &toolJob->module);
+	editor.setSelectionStart(selectionStart);
+	editor.setSelectionEnd(selectionEnd);
+
+	// the clipboard can change while the job runs, these read it
+	if ((filterFuncPtr == &SampleEditor::tool_convolution || 
+		filterFuncPtr == &SampleEditor::tool_vocodeSample) && 
+		!ClipBoard::getInstance()->isEmpty())
+	{
+		toolJob->clipBoard = new ClipBoard(*ClipBoard::getInstance());
+		editor.toolClipBoard = toolJob->clipBoard;
+	}
+
+	toolJob->thread = std::thread(&ToolJob::run, toolJob);
+	return true;
+}
+
+bool SampleEditor::isToolJobDone() const
+{
+	return toolJob != NULL && toolJob->done;
+}
+
+float SampleEditor::getToolJobProgress() const
+{
+	return toolJob ? toolJob->editor.toolProgress.load() : 0.0f;
+}
+
+bool SampleEditor::cancelToolJob()
+{
+	if (toolJob == NULL)
+		return false;
+
+	toolJob->editor.toolCancelled = true;
+	toolJob->thread.join();
+
+	delete toolJob;
+	toolJob = NULL;
+	return true;
+}
+
+bool SampleEditor::finishToolJob()
+{
+	if (toolJob == NULL)
+		return false;
+
+	toolJob->thread.join();
+
+	// the player is only held up while the result is swapped in
+	preFilter(toolJob->filterFuncPtr, toolJob->par);
+
+	prepareUndo();
+
+	const TXMSample& result = toolJob->module.smp[0];
+
+	mp_ubyte* oldSample = (mp_ubyte*)sample->sample;
+	sample->sample = NULL;
+	if (result.sample)
+	{
+		mp_uint32 size = TXMSample::getSampleSizeInBytes((mp_ubyte*)result.sample);
+		sample->sample = (mp_sbyte*)module->allocSampleMem(size);
+		TXMSample::copyPaddedMem(sample->sample, result.sample, size);
+	}
+	if (oldSample)
+		module->freeSampleMem(oldSample);
+
+	sample->samplen = result.samplen;
+	sample->loopstart = result.loopstart;
+	sample->looplen = result.looplen;
+	sample->type = result.type;
+	sample->relnote = result.relnote;
+	sample->finetune = result.finetune;
+
+	selectionStart = toolJob->editor.selectionStart;
+	selectionEnd = toolJob->editor.selectionEnd;
+
+	delete toolJob;
+	toolJob = NULL;
+
+	finishUndo();
+
+	postFilter();
+	return true;
+}
+
 void SampleEditor::preFilter(TFilterFunc filterFuncPtr, const FilterParameters* par)
 {
 	if (filterFuncPtr)
@@ -1860,12 +2437,12 @@ void SampleEditor::tool_scaleSample(const FilterParameters* par)
 	
 	float step = (endScale - startScale) / (float)(sEnd - sStart);
 	
-	for (pp_int32 i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float f = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, f*startScale);
-		startScale+=step;
-	}
+		for (pp_int32 i = 0; i < count; i++)
+			data[i] *= startScale + step*(float)(pos + i - sStart);
+	});
 				
 	finishUndo();	
 	
@@ -1901,24 +2478,18 @@ void SampleEditor::tool_normalizeSample(const FilterParameters* par)
 	prepareUndo();
 	
 	float maxLevel = ((par == NULL)? 1.0f : par->getParameter(0).floatPart);
-	float peak = 0.0f;
-
-	pp_int32 i;
 
 	// find peak value
-	for (i = sStart; i < sEnd; i++)
-	{
-		float f = getFloatSampleFromWaveform(i);
-		if (ppfabs(f) > peak) peak = ppfabs(f);
-	}
+	float peak = getPeak(sStart, sEnd);
 	
 	float scale = maxLevel / peak;
 	
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float f = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, f*scale);
-	}
+		for (pp_int32 i = 0; i < count; i++)
+			data[i] *= scale;
+	});
 				
 	finishUndo();	
 	
@@ -1953,56 +2524,88 @@ void SampleEditor::tool_compressSample(const FilterParameters* par)
 
 	prepareUndo();
 
-	pp_int32 i;
-	float peak = 0.0f;
-
 	// find peak value (pre)
-	for (i = sStart; i < sEnd; i++)
-	{
-		float f = getFloatSampleFromWaveform(i);
-		if (ppfabs(f) > peak) peak = ppfabs(f);
-	}
+	float peak = getPeak(sStart, sEnd);
 
-	float max = 0.0f;
-	float compress = peak * 0.66;
-	float last  = 0.0;
-	float wpeak = 0.0;
-	int zerocross[2];
-	zerocross[0] = -1;
-	zerocross[1] = -1;
 	float treshold = 0.8;
 	float peakTreshold = peak * treshold;
 
 	// scaling limiter inspired by awesome 'TAP scaling limiter'
-	for (i = sStart; i < sEnd; i++) {
-		float f = getFloatSampleFromWaveform(i);
-		if (ZEROCROSS(f, last)) {
-			zerocross[0] = zerocross[1];
-			zerocross[1] = i;
-			if (zerocross[0] >= 0 && zerocross[1] > 0) {                   // detected waveset 
-				wpeak = 0;
-				for (int j = zerocross[0]; j < zerocross[1]; j++) {        // get peak from waveset
-					float w = getFloatSampleFromWaveform(j);
-					if (ppfabs(w) > wpeak) wpeak = ppfabs(w);
+	// every waveset is scaled on its own, so the blocks only need
+	// to know where their first waveset starts
+	ParallelFor parallel(sStart, sEnd);
+	pp_int32 numBlocks = parallel.getNumBlocks();
+	std::vector<pp_int32> zerocross(numBlocks + 1, sEnd);
+
+	// the wavesets are scaled sample by sample from all blocks,
+	// get the real loop area data in place before they race for it
+	sample->restoreOriginalState();
+
+	parallel.run([&](pp_int32 block, pp_int32 from, pp_int32 to)
+	{
+		float last = from > sStart ? getFloatSampleFromWaveform(from - 1) : 0.0f;
+		for (pp_int32 i = from; i < to; i++)
+		{
+			float f = getFloatSampleFromWaveform(i);
+			if (ZEROCROSS(f, last))
+			{
+				zerocross[block] = i;
+				break;
+			}
+			last = f;
+		}
+	});
+
+	// blocks without a zero crossing start at the next one
+	for (pp_int32 block = numBlocks - 1; block >= 0; block--)
+	{
+		if (zerocross[block] == sEnd)
+			zerocross[block] = zerocross[block + 1];
+	}
+
+	parallel.run([&](pp_int32 block, pp_int32 from, pp_int32 to)
+	{
+		pp_int32 start = zerocross[block];
+		while (start < to)
+		{
+			// the last waveset of a block ends at the first zero crossing of the next one
+			pp_int32 end = zerocross[block + 1];
+			float last = getFloatSampleFromWaveform(start);
+			for (pp_int32 i = start + 1; i < to; i++)
+			{
+				float f = getFloatSampleFromWaveform(i);
+				if (ZEROCROSS(f, last))
+				{
+					end = i;
+					break;
 				}
-				if (wpeak > peakTreshold) {                                    // scale down waveset if wpeak exceeds treshold
-					for (int j = zerocross[0]; j < zerocross[1]; j++) {
-						float b = getFloatSampleFromWaveform(j) * (peakTreshold / wpeak);
-						this->setFloatSampleInWaveform(j,b );
-					}
+				last = f;
+			}
+			if (end >= sEnd)
+				break;
+
+			float wpeak = 0.0f;
+			for (pp_int32 j = start; j < end; j++) {                       // get peak from waveset
+				float w = getFloatSampleFromWaveform(j);
+				if (ppfabs(w) > wpeak) wpeak = ppfabs(w);
+			}
+			if (wpeak > peakTreshold) {                                    // scale down waveset if wpeak exceeds treshold
+				for (pp_int32 j = start; j < end; j++) {
+					float b = getFloatSampleFromWaveform(j) * (peakTreshold / wpeak);
+					this->setFloatSampleInWaveform(j,b );
 				}
 			}
+			start = end;
 		}
-		last = f;
-	}
+	});
 
 	// post-compensate amplitudes 
 	float scale = (peak/peakTreshold);
-	for (i = sStart; i < sEnd; i++)
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float f = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, f * scale);
-	}
+		for (pp_int32 i = 0; i < count; i++)
+			data[i] *= scale;
+	});
 
 	finishUndo();
 
@@ -2038,16 +2641,21 @@ void SampleEditor::tool_reverseSample(const FilterParameters* par)
 	
 	prepareUndo();
 	
-	pp_int32 i;
-	for (i = 0; i < (sEnd-sStart)>>1; i++)
+	// every span of the first half is swapped with its mirror in the second half
+	ParallelFor parallel(sStart, sStart + ((sEnd-sStart)>>1));
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float f1 = getFloatSampleFromWaveform(sStart + i);
-		float f2 = getFloatSampleFromWaveform(sEnd - 1 - i);
-		float h = f2;
-		f2 = f1; f1 = h;
-		setFloatSampleInWaveform(sStart + i, f1);
-		setFloatSampleInWaveform(sEnd - 1 - i, f2);
-	}
+		float mirror[FLOATSPANSIZE];
+		pp_int32 mirrorPos = sEnd - (pos - sStart) - count;
+		sample->readFloat(mirrorPos, count, mirror);
+		for (pp_int32 i = 0; i < count; i++)
+		{
+			float h = data[i];
+			data[i] = mirror[count - 1 - i];
+			mirror[count - 1 - i] = h;
+		}
+		sample->writeFloat(mirrorPos, count, mirror);
+	});
 				
 	finishUndo();	
 	
@@ -2082,35 +2690,43 @@ void SampleEditor::tool_PTboostSample(const FilterParameters* par)
 	
 	prepareUndo();
 	
-	pp_int32 i;
-	
-	float d0 = 0.0f, d1, d2;
-	for (i = sStart; i < sEnd; i++)
+	// every block starts from the sample before it, taken before anything gets written
+	ParallelFor parallel(sStart, sEnd);
+	std::vector<float> last(parallel.getNumBlocks(), 0.0f);
+	for (pp_int32 block = 1; block < parallel.getNumBlocks(); block++)
+		last[block] = getFloatSampleFromWaveform(parallel.getBlockStart(block) - 1);
+
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		d1 = d2 = getFloatSampleFromWaveform(i);
-		d1 -= d0;
-		d0 = d2;
-		
-		if (d1 < 0.0f)
-		{
-			d1 = -d1;
-			d1*= 0.25f;
-			d2 -= d1;
-		}
-		else
+		float d0 = last[block], d1, d2;
+		for (pp_int32 i = 0; i < count; i++)
 		{
-			d1*= 0.25f;
-			d2 += d1;
+			d1 = d2 = data[i];
+			d1 -= d0;
+			d0 = d2;
+			
+			if (d1 < 0.0f)
+			{
+				d1 = -d1;
+				d1*= 0.25f;
+				d2 -= d1;
+			}
+			else
+			{
+				d1*= 0.25f;
+				d2 += d1;
+			}
+			
+			if (d2 > 1.0f)
+				d2 = 1.0f;
+			
+			if (d2 < -1.0f)
+				d2 = -1.0f;
+			
+			data[i] = d2;
 		}
-		
-		if (d2 > 1.0f)
-			d2 = 1.0f;
-		
-		if (d2 < -1.0f)
-			d2 = -1.0f;
-		
-		setFloatSampleInWaveform(i, d2);
-	}
+		last[block] = d0;
+	});
 	
 	finishUndo();	
 	
@@ -2186,32 +2802,42 @@ void SampleEditor::tool_xFadeSample(const FilterParameters* par)
 
 	prepareUndo();	
 	
-	pp_int32 i = 0;
-	
 	// loop start
 	if ((sample->type & 3) == 1)
 	{	
-		for (i = sStart; i < (signed)sample->loopstart; i++)
+		ParallelFor loopStartIn(sStart, (signed)sample->loopstart);
+		processFloat(loopStartIn, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 		{
-			float t = (((float)i - sStart) / (float)(sample->loopstart - sStart))*0.5f;
+			for (pp_int32 j = 0; j < count; j++)
+			{
+				pp_int32 i = pos + j;
+
+				float t = (((float)i - sStart) / (float)(sample->loopstart - sStart))*0.5f;
 			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(loopend - (sample->loopstart - sStart) + (i - sStart), buffer, sample->samplen);		
+				float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
+				float f2 = getFloatSampleFromWaveform(loopend - (sample->loopstart - sStart) + (i - sStart), buffer, sample->samplen);		
 			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
+				float f = f1*(1.0f-t) + f2*t;
+				data[j] = f;
+			}
+		});
 		
-		for (i = sample->loopstart; i < sEnd; i++)
+		ParallelFor loopStartOut(sample->loopstart, sEnd);
+		processFloat(loopStartOut, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 		{
-			float t = 0.5f - ((((float)i - sample->loopstart) / (float)(sEnd-sample->loopstart))*0.5f);
+			for (pp_int32 j = 0; j < count; j++)
+			{
+				pp_int32 i = pos + j;
+
+				float t = 0.5f - ((((float)i - sample->loopstart) / (float)(sEnd-sample->loopstart))*0.5f);
 			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(loopend + (i - sample->loopstart), buffer, sample->samplen);		
+				float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
+				float f2 = getFloatSampleFromWaveform(loopend + (i - sample->loopstart), buffer, sample->samplen);		
 			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
+				float f = f1*(1.0f-t) + f2*t;
+				data[j] = f;
+			}
+		});
 		
 		// loop end
 		sStart-=sample->loopstart;
@@ -2219,52 +2845,76 @@ void SampleEditor::tool_xFadeSample(const FilterParameters* par)
 		sEnd-=sample->loopstart;
 		sEnd+=loopend;	
 		
-		for (i = sStart; i < loopend; i++)
+		ParallelFor loopEndIn(sStart, loopend);
+		processFloat(loopEndIn, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 		{
-			float t = (((float)i - sStart) / (float)(loopend - sStart))*0.5f;
+			for (pp_int32 j = 0; j < count; j++)
+			{
+				pp_int32 i = pos + j;
+
+				float t = (((float)i - sStart) / (float)(loopend - sStart))*0.5f;
 			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart - (loopend - sStart) + (i - sStart), buffer, sample->samplen);		
+				float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
+				float f2 = getFloatSampleFromWaveform(sample->loopstart - (loopend - sStart) + (i - sStart), buffer, sample->samplen);		
 			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}	
+				float f = f1*(1.0f-t) + f2*t;
+				data[j] = f;
+			}
+		});	
 		
-		for (i = loopend; i < sEnd; i++)
+		ParallelFor loopEndOut(loopend, sEnd);
+		processFloat(loopEndOut, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 		{
-			float t = 0.5f - ((((float)i - loopend) / (float)(sEnd-loopend))*0.5f);
+			for (pp_int32 j = 0; j < count; j++)
+			{
+				pp_int32 i = pos + j;
+
+				float t = 0.5f - ((((float)i - loopend) / (float)(sEnd-loopend))*0.5f);
 			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart + (i - loopend), buffer, sample->samplen);		
+				float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
+				float f2 = getFloatSampleFromWaveform(sample->loopstart + (i - loopend), buffer, sample->samplen);		
 			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
+				float f = f1*(1.0f-t) + f2*t;
+				data[j] = f;
+			}
+		});
 		
 	}
 	else if ((sample->type & 3) == 2)
 	{
-		for (i = sStart; i < (signed)sample->loopstart; i++)
+		ParallelFor loopStartIn(sStart, (signed)sample->loopstart);
+		processFloat(loopStartIn, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 		{
-			float t = (((float)i - sStart) / (float)(sample->loopstart - sStart))*0.5f;
+			for (pp_int32 j = 0; j < count; j++)
+			{
+				pp_int32 i = pos + j;
+
+				float t = (((float)i - sStart) / (float)(sample->loopstart - sStart))*0.5f;
 			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart + (i - sStart), buffer, sample->samplen);		
+				float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
+				float f2 = getFloatSampleFromWaveform(sample->loopstart + (i - sStart), buffer, sample->samplen);		
 			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
+				float f = f1*(1.0f-t) + f2*t;
+				data[j] = f;
+			}
+		});
 		
-		for (i = sample->loopstart; i < sEnd; i++)
+		ParallelFor loopStartOut(sample->loopstart, sEnd);
+		processFloat(loopStartOut, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 		{
-			float t = 0.5f - ((((float)i - sample->loopstart) / (float)(sEnd-sample->loopstart))*0.5f);
+			for (pp_int32 j = 0; j < count; j++)
+			{
+				pp_int32 i = pos + j;
+
+				float t = 0.5f - ((((float)i - sample->loopstart) / (float)(sEnd-sample->loopstart))*0.5f);
 			
-			float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
-			float f2 = getFloatSampleFromWaveform(sample->loopstart - (i - sample->loopstart), buffer, sample->samplen);		
+				float f1 = getFloatSampleFromWaveform(i, buffer, sample->samplen);
+				float f2 = getFloatSampleFromWaveform(sample->loopstart - (i - sample->loopstart), buffer, sample->samplen);		
 			
-			float f = f1*(1.0f-t) + f2*t;
-			setFloatSampleInWaveform(i, f);
-		}
+				float f = f1*(1.0f-t) + f2*t;
+				data[j] = f;
+			}
+		});
 	}
 	
 	delete[] buffer;
@@ -2449,18 +3099,27 @@ void SampleEditor::tool_DCNormalizeSample(const FilterParameters* par)
 	
 	prepareUndo();
 	
-	pp_int32 i;
+	ParallelFor parallel(sStart, sEnd);
+	std::vector<double> sums(parallel.getNumBlocks(), 0.0);
 
-	float DC = 0.0f;
-	for (i = sStart; i < sEnd; i++)
+	processFloat(parallel, false, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		DC += getFloatSampleFromWaveform(i);		
-	}
-	DC = DC / (float)(sEnd-sStart);
-	for (i = sStart; i < sEnd; i++)
+		double sum = 0.0;
+		for (pp_int32 i = 0; i < count; i++)
+			sum += data[i];
+		sums[block] += sum;
+	});
+
+	double sum = 0.0;
+	for (size_t i = 0; i < sums.size(); i++)
+		sum += sums[i];
+
+	float DC = (float)(sum / (double)(sEnd-sStart));
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		setFloatSampleInWaveform(i, getFloatSampleFromWaveform(i) - DC);
-	}
+		for (pp_int32 i = 0; i < count; i++)
+			data[i] -= DC;
+	});
 	
 	finishUndo();	
 	
@@ -2495,13 +3154,14 @@ void SampleEditor::tool_DCOffsetSample(const FilterParameters* par)
 	
 	prepareUndo();
 	
-	pp_int32 i;
-
 	float DC = par->getParameter(0).floatPart;
-	for (i = sStart; i < sEnd; i++)
+
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		setFloatSampleInWaveform(i, getFloatSampleFromWaveform(i) + DC);
-	}
+		for (pp_int32 i = 0; i < count; i++)
+			data[i] += DC;
+	});
 	
 	finishUndo();	
 	
@@ -2544,16 +3204,20 @@ void SampleEditor::tool_rectangularSmoothSample(const FilterParameters* par)
 
 	prepareUndo();	
 	
-	pp_int32 i;
-
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float f = (getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen) +
-				  getFloatSampleFromWaveform(i - sStart, buffer, sLen) +
-				  getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)) * (1.0f/3.0f);
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+
+			float f = (getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen) +
+					  getFloatSampleFromWaveform(i - sStart, buffer, sLen) +
+					  getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)) * (1.0f/3.0f);
 				  
-		setFloatSampleInWaveform(i, f);		
-	}
+			data[j] = f;		
+		}
+	});
 	
 	delete[] buffer;
 	
@@ -2598,18 +3262,22 @@ void SampleEditor::tool_triangularSmoothSample(const FilterParameters* par)
 
 	prepareUndo();	
 	
-	pp_int32 i;
-
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float f = (getFloatSampleFromWaveform(i - sStart - 2, buffer, sLen) +
-				   getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen)*2.0f +
-				   getFloatSampleFromWaveform(i - sStart, buffer, sLen)*3.0f +
-				   getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)*2.0f +
-				   getFloatSampleFromWaveform(i - sStart + 2, buffer, sLen)) * (1.0f/9.0f);
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+
+			float f = (getFloatSampleFromWaveform(i - sStart - 2, buffer, sLen) +
+					   getFloatSampleFromWaveform(i - sStart - 1, buffer, sLen)*2.0f +
+					   getFloatSampleFromWaveform(i - sStart, buffer, sLen)*3.0f +
+					   getFloatSampleFromWaveform(i - sStart + 1, buffer, sLen)*2.0f +
+					   getFloatSampleFromWaveform(i - sStart + 2, buffer, sLen)) * (1.0f/9.0f);
 				  
-		setFloatSampleInWaveform(i, f);		
-	}
+			data[j] = f;		
+		}
+	});
 	
 	delete[] buffer;
 	
@@ -2661,7 +3329,6 @@ void SampleEditor::tool_eqSample(const FilterParameters* par, bool selective)
 	
 	ClipBoard* clipBoard;
 	float step;
-	float j2 = 0.0f;
 	if (selective) {
 		clipBoard = ClipBoard::getInstance();
 		step = (float)clipBoard->getWidth() / (float)(sEnd-sStart);
@@ -2669,54 +3336,37 @@ void SampleEditor::tool_eqSample(const FilterParameters* par, bool selective)
 	
 	float c4spd = 8363; // there really should be a global constant for this
 	
-	Equalizer** eqs = new Equalizer*[par->getNumParameters()];
+	EQState eq;
+	eq.numBands = par->getNumParameters();
 	
 	// three band EQ
-	if (par->getNumParameters() == 3)
+	if (eq.numBands == 3)
 	{
-		for (pp_int32 i = 0; i < par->getNumParameters(); i++)
+		for (pp_int32 i = 0; i < eq.numBands; i++)
 		{
-			eqs[i] = new Equalizer();
-			eqs[i]->CalcCoeffs(EQConstants::EQ3bands[i], EQConstants::EQ3bandwidths[i], c4spd, Equalizer::CalcGain(par->getParameter(i).floatPart));
+			eq.eqs[i].CalcCoeffs(EQConstants::EQ3bands[i], EQConstants::EQ3bandwidths[i], c4spd, Equalizer::CalcGain(par->getParameter(i).floatPart));
 		}
 	}
 	// ten band EQ
-	else if (par->getNumParameters() == 10)
+	else if (eq.numBands == 10)
 	{
-		for (pp_int32 i = 0; i < par->getNumParameters(); i++)
+		for (pp_int32 i = 0; i < eq.numBands; i++)
 		{
-			eqs[i] = new Equalizer();
-			eqs[i]->CalcCoeffs(EQConstants::EQ10bands[i], EQConstants::EQ10bandwidths[i], c4spd, Equalizer::CalcGain(par->getParameter(i).floatPart));
+			eq.eqs[i].CalcCoeffs(EQConstants::EQ10bands[i], EQConstants::EQ10bandwidths[i], c4spd, Equalizer::CalcGain(par->getParameter(i).floatPart));
 		}
 	}
 	else
 	{
-		delete[] eqs;
 		finishUndo();
 		return;
 	}
 	
 	// apply EQ here
-	pp_int32 i;
-
-	for (i = sStart; i < sEnd; i++)
+	filterParallel(sStart, sEnd, eq, [&](pp_int32 i, float x, float xL)
 	{
-		// Fetch a stereo signal
-		double xL = getFloatSampleFromWaveform(i);
-		double xR = xL;
-		float x = (float)xL;
-			
-		for (pp_int32 j = 0; j < par->getNumParameters(); j++)
-		{
-			double yL, yR;
-			// Pass the stereo input
-			eqs[j]->Filter(xL, xR, yL, yR);
-			
-			xL = yL;
-			xR = yR;
-		}
 		if (selective)
 		{
+			float j2 = step * (float)(i - sStart);
 			float frac = j2 - (float)floor(j2);
 		
 			pp_int16 s = clipBoard->getSampleWord((pp_int32)j2);
@@ -2727,21 +3377,16 @@ void SampleEditor::tool_eqSample(const FilterParameters* par, bool selective)
 			float f = (1.0f-frac)*f1 + frac*f2;
 
 			if (f>=0) {
-				x = f * ((float)xL) + (1.0f-f) * x;
+				x = f * xL + (1.0f-f) * x;
 			} else {
-				x = -f * (x-(float)xL) + (1.0+f) * x; 
+				x = -f * (x-xL) + (1.0+f) * x; 
 			}
-			j2+=step;
 		} else {
-			x = (float)xL;
+			x = xL;
 		}
-		setFloatSampleInWaveform(i, x);
-	}
-	
-	for (i = 0; i < par->getNumParameters(); i++)
-		delete eqs[i];
+		return x;
+	});
 	
-	delete[] eqs;
 	finishUndo();	
 
 	postFilter();
@@ -2860,35 +3505,32 @@ void SampleEditor::tool_generateNoise(const FilterParameters* par)
 	
 	prepareUndo();	
 	
-	pp_int32 i;
-
 	float    amp  = par->getParameter(0).floatPart;
 	pp_int32 type = par->getParameter(1).intPart;
 
 	VRand rand;
 	rand.seed();
 
-	switch (type)
+	// the noise generators carry their state from sample to sample, keep it one block
+	ParallelFor parallel(sStart, sEnd, sEnd - sStart);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		case 0:
-			for (i = sStart; i < sEnd; i++){
-				float x = getFloatSampleFromWaveform(i);
-				setFloatSampleInWaveform(i, x + (rand.white()*2.0f)*amp );		
-			}
-			break;
-		case 1:
-			for (i = sStart; i < sEnd; i++){
-				float x = getFloatSampleFromWaveform(i);
-				setFloatSampleInWaveform(i, x + (rand.pink()*2.0f)*amp );		
-			}
-			break;
-		case 2:
-			for (i = sStart; i < sEnd; i++){
-				float x = getFloatSampleFromWaveform(i);
-				setFloatSampleInWaveform(i, x + (rand.brown()*2.0f)*amp );		
-			}
-			break;
-	}
+		switch (type)
+		{
+			case 0:
+				for (pp_int32 i = 0; i < count; i++)
+					data[i] += (rand.white()*2.0f)*amp;
+				break;
+			case 1:
+				for (pp_int32 i = 0; i < count; i++)
+					data[i] += (rand.pink()*2.0f)*amp;
+				break;
+			case 2:
+				for (pp_int32 i = 0; i < count; i++)
+					data[i] += (rand.brown()*2.0f)*amp;
+				break;
+		}
+	});
 	
 	finishUndo();	
 
@@ -2925,18 +3567,20 @@ void SampleEditor::tool_generateSine(const FilterParameters* par)
 	
 	prepareUndo();	
 	
-	pp_int32 i;
-
 	const float numPeriods = (float)(6.283185307179586476925286766559 * par->getParameter(1).floatPart);
 	const float amplify = par->getParameter(0).floatPart;
 
 	// generate sine wave here
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float v = getFloatSampleFromWaveform(i);
-		float per = (i-sStart)/(float)sLen * numPeriods;
-		setFloatSampleInWaveform(i, v + (float)sin(per)*amplify);	
-	}
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+			float per = (i-sStart)/(float)sLen * numPeriods;
+			data[j] += (float)sin(per)*amplify;
+		}
+	});
 
 	finishUndo();	
 
@@ -2971,19 +3615,21 @@ void SampleEditor::tool_generateSquare(const FilterParameters* par)
 	
 	prepareUndo();	
 	
-	pp_int32 i;
-
 	const float numPeriods = par->getParameter(1).floatPart;
 	const float amplify = par->getParameter(0).floatPart;
 
 	// generate square wave here
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-    float v   = getFloatSampleFromWaveform(i);
-		float per = (i-sStart)/(float)sLen * numPeriods;
-		float frac = per-(float)floor(per);
-		setFloatSampleInWaveform(i, v + (frac < 0.5f ? amplify : -amplify) );	
-	}
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+			float per = (i-sStart)/(float)sLen * numPeriods;
+			float frac = per-(float)floor(per);
+			data[j] += (frac < 0.5f ? amplify : -amplify);
+		}
+	});
 
 	finishUndo();	
 
@@ -3018,24 +3664,26 @@ void SampleEditor::tool_generateTriangle(const FilterParameters* par)
 	
 	prepareUndo();	
 	
-	pp_int32 i;
-
 	const float numPeriods = par->getParameter(1).floatPart;
 	const float amplify = par->getParameter(0).floatPart;
 
 	// generate triangle wave here
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-    float v   = getFloatSampleFromWaveform(i);
-		float per = (i-sStart)/(float)sLen * numPeriods;
-		float frac = per-(float)floor(per);
-		if (frac < 0.25f)
-			setFloatSampleInWaveform(i, v + (frac*4.0f)*amplify);	
-		else if (frac < 0.75f)
-			setFloatSampleInWaveform(i, v + (1.0f-(frac-0.25f)*4.0f)*amplify);	
-		else	
-			setFloatSampleInWaveform(i, v + (-1.0f+(frac-0.75f)*4.0f)*amplify);	
-	}
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+			float per = (i-sStart)/(float)sLen * numPeriods;
+			float frac = per-(float)floor(per);
+			if (frac < 0.25f)
+				data[j] += (frac*4.0f)*amplify;
+			else if (frac < 0.75f)
+				data[j] += (1.0f-(frac-0.25f)*4.0f)*amplify;
+			else	
+				data[j] += (-1.0f+(frac-0.75f)*4.0f)*amplify;
+		}
+	});
 
 	finishUndo();	
 
@@ -3070,19 +3718,21 @@ void SampleEditor::tool_generateSawtooth(const FilterParameters* par)
 	
 	prepareUndo();	
 	
-	pp_int32 i;
-
 	const float numPeriods = par->getParameter(1).floatPart;
 	const float amplify = par->getParameter(0).floatPart;
 
 	// generate saw-tooth wave here
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float per = (i-sStart)/(float)sLen * numPeriods;
-		float frac = per-(float)floor(per);
-    float v   = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, v + (frac < 0.5f ? (frac*2.0f)*amplify : (-1.0f+((frac-0.5f)*2.0f))*amplify) );	
-	}
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+			float per = (i-sStart)/(float)sLen * numPeriods;
+			float frac = per-(float)floor(per);
+			data[j] += (frac < 0.5f ? (frac*2.0f)*amplify : (-1.0f+((frac-0.5f)*2.0f))*amplify);
+		}
+	});
 
 	finishUndo();	
 
@@ -3117,23 +3767,20 @@ void SampleEditor::tool_generateHalfSine(const FilterParameters* par)
 
 	prepareUndo();
 
-	pp_int32 i;
-
 	const float numPeriods = (float)(6.283185307179586476925286766559 * par->getParameter(1).floatPart);
 	const float amplify = par->getParameter(0).floatPart;
 
-	// generate half sine wave here
-	for (i = sStart; i < sStart + sLen / 2; i++)
-	{
-		float v   = getFloatSampleFromWaveform(i);
-		float per = (i - sStart) / (float)sLen * numPeriods;
-		setFloatSampleInWaveform(i, v + ((float)sin(per) * amplify) );
-	}
-	for (; i < sEnd; i++)
+	// generate half sine wave here, the second half stays as it is
+	ParallelFor parallel(sStart, sStart + sLen / 2);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-		float v   = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, 0 + v);
-	}
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+			float per = (i - sStart) / (float)sLen * numPeriods;
+			data[j] += (float)sin(per) * amplify;
+		}
+	});
 
 	finishUndo();
 
@@ -3168,18 +3815,20 @@ void SampleEditor::tool_generateAbsoluteSine(const FilterParameters* par)
 
 	prepareUndo();
 
-	pp_int32 i;
-
 	const float numPeriods = (float)(6.283185307179586476925286766559 * par->getParameter(1).floatPart);
 	const float amplify = par->getParameter(0).floatPart;
 
 	// generate absolute sine wave here
-	for (i = sStart; i < sEnd; i++)
+	ParallelFor parallel(sStart, sEnd);
+	processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
 	{
-    float v   = getFloatSampleFromWaveform(i);
-		float per = (i - sStart) / (float)sLen * numPeriods;
-		setFloatSampleInWaveform(i, v + (fabs((float)sin(per) * amplify)) );
-	}
+		for (pp_int32 j = 0; j < count; j++)
+		{
+			pp_int32 i = pos + j;
+			float per = (i - sStart) / (float)sLen * numPeriods;
+			data[j] += fabs((float)sin(per) * amplify);
+		}
+	});
 
 	finishUndo();
 
@@ -3214,33 +3863,25 @@ void SampleEditor::tool_generateQuarterSine(const FilterParameters* par)
 
 	prepareUndo();
 
-	pp_int32 i;
-
 	const float numPeriods = (float)(6.283185307179586476925286766559 * par->getParameter(1).floatPart);
 	const float amplify = par->getParameter(0).floatPart;
 
-	// generate quarter sine wave in first and third quarters
-	for (i = sStart; i < sStart + sLen / 4; i++)
+	// generate quarter sine wave in first and third quarters,
+	// the second and fourth quarters stay as they are
+	for (pp_int32 quarter = 0; quarter < 4; quarter += 2)
 	{
-    float v   = getFloatSampleFromWaveform(i);
-		float per = (i - sStart) / (float)sLen * numPeriods;
-		setFloatSampleInWaveform(i, v + ((float)sin(per) * amplify) );
-	}
-	for (; i < sStart + sLen / 2; i++)
-	{
-    float v   = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, v+0);
-	}
-	for (; i < sStart + sLen * 3 / 4; i++)
-	{
-    float v   = getFloatSampleFromWaveform(i);
-		float per = (i - (sStart + sLen / 2)) / (float)sLen * numPeriods;
-		setFloatSampleInWaveform(i, v + ((float)sin(per) * amplify) );
-	}
-	for (; i < sEnd; i++)
-	{
-    float v   = getFloatSampleFromWaveform(i);
-		setFloatSampleInWaveform(i, v+0);
+		pp_int32 qStart = sStart + sLen * quarter / 4;
+
+		ParallelFor parallel(qStart, sStart + sLen * (quarter + 1) / 4);
+		processFloat(parallel, true, [&](pp_int32 block, pp_int32 pos, float* data, pp_int32 count)
+		{
+			for (pp_int32 j = 0; j < count; j++)
+			{
+				pp_int32 i = pos + j;
+				float per = (i - qStart) / (float)sLen * numPeriods;
+				data[j] += (float)sin(per) * amplify;
+			}
+		});
 	}
 
 	finishUndo();
@@ -3328,6 +3969,8 @@ void SampleEditor::tool_reverb(const FilterParameters* par)
 	fx.convolve   = 100.0f;
 	fx.contrast   = 0.0f;
 	fx.windowsize = 100.0f;
+	fx.progress     = &SampleEditor::reportConvolverProgress;
+	fx.progressUser = this;
 
 	// create buffers (smpout will be calloc'ed by reverb)
 	float* smpin;
@@ -3336,9 +3979,9 @@ void SampleEditor::tool_reverb(const FilterParameters* par)
 
 	if( convolveWithClipboard ){
 
-		ClipBoard* clipBoard = ClipBoard::getInstance();
+		ClipBoard* clipBoard = getClipBoard();
 
-		if (!ClipBoard::getInstance()->isEmpty()){
+		if (!clipBoard->isEmpty()){
 			fx.convolve       = par->getParameter(2).floatPart;  // soothe
 			if( par->getNumParameters() > 3 ){
 				fx.contrast       = par->getParameter(3).floatPart; 
@@ -3367,13 +4010,13 @@ void SampleEditor::tool_reverb(const FilterParameters* par)
 	}
 
 	int outlength = convolveWithClipboard ? Convolver::reverb( smpin, &smpout, newSampleSize, size, impulseResponse, &fx )
-									      : Convolver::reverb( smpin, &smpout, newSampleSize, size);
+									      : Convolver::reverb( smpin, &smpout, newSampleSize, size, &fx );
 
 	for (pp_int32 i = sStart; i < sStart+outlength; i++) {
 		pp_uint32 pos = i % sEnd;
 		if( pos < sStart ) pos += sStart; // fold back reverb tail to beginning (aid seamless looping)
 		float dry      = this->getFloatSampleFromWaveform( pos ) * ( i < sEnd ?  (1.0-ratio) : 1.0 );
-		float wet      = 1.2 * (smpout[i] * ratio);
+		float wet      = 1.2 * (smpout[i-sStart] * ratio);
 		this->setFloatSampleInWaveform(pos, dry+wet );
 	}
 				
@@ -3435,7 +4078,10 @@ void SampleEditor::tool_MTboostSample(const FilterParameters* par)
 		smpin[i] = hp.out_hp;
 	}
 	// smear and smooth with a phasing roomverb
-	int outlength = Convolver::reverb( smpin, &smpout, sLength, 100 * (int)par->getParameter(1).floatPart );
+	Convolver::FX fx;
+	fx.progress     = &SampleEditor::reportConvolverProgress;
+	fx.progressUser = this;
+	int outlength = Convolver::reverb( smpin, &smpout, sLength, 100 * (int)par->getParameter(1).floatPart, &fx );
 	int phase     = (int)( float(samplerate/5000) * par->getParameter(2).floatPart );
 	float wet     = ( par->getParameter(3).floatPart / 100.0f) * 5.0f;
 
@@ -3483,10 +4129,6 @@ void SampleEditor::tool_saturate(const FilterParameters* par)
 
 	prepareUndo();
 
-	pp_int32 i;
-	float in;
-	float out;
-	float peak = 0.0f;
 	float foldback = par->getParameter(0).floatPart / 5.0;
 	if( foldback < 1.0 ) foldback = 1.0;
 	pp_int32 samplerate = XModule::getc4spd(sample->relnote, sample->finetune);
@@ -3499,37 +4141,29 @@ void SampleEditor::tool_saturate(const FilterParameters* par)
 	float scale;
 
 	// init filter
-	multifilter_t filter;
-	multifilter_state_t filter0;
-	Filter::multifilter_set(&filter,
+	MultifilterState filter;
+	Filter::multifilter_set(&filter.filter,
 		samplerate,
 	 	freq > 0.05 ? FILTER_BANDPASS: FILTER_NONE,
 		freq, // freq 
 		0.9,  // res 
 		1.5); // gain
-	filter0.x1 = filter0.x2 = filter0.y1 = filter0.y2 = 0.0;
+	filter.clear();
 
 	// find peak value 
-	for (i = sStart; i < sEnd; i++)
-	{
-		float f = getFloatSampleFromWaveform(i);
-		if (ppfabs(f) > peak) peak = ppfabs(f);
-	}
+	float peak = getPeak(sStart, sEnd);
 	scale = 1.0f/peak;
 
 	// process 
-	for (i = sStart; i < sEnd; i++)
-	{
-		in  = getFloatSampleFromWaveform(i);                  // normalized amp input
-		out = Filter::multifilter(&filter, &filter0, in );    // bandpass
-                                                          //
+	filterParallel(sStart, sEnd, filter, [&](pp_int32 i, float in, float out)
+	{                                                         // normalized amp input, bandpass
 		if( compand >= 1.0 ){                                 // we average with companded version  
 		  out = (out + tanh( out * compand ))/2.0;            // https://graphtoy.com/?f1(x,t)=(x%20+%20tanh(%20x%20*%205))/2
 		}
 		out = sin( (out*scale) * foldback ) / foldback;       // sinusoid foldback & denormalize 
 		out = (out*wet)  + (in*dry);					      //
-		setFloatSampleInWaveform(i, out * peak * volume );   // full harmonic fold complete
-	}
+		return out * peak * volume;                          // full harmonic fold complete
+	});
 
 	finishUndo();
 
@@ -3564,12 +4198,13 @@ void SampleEditor::tool_filter(const FilterParameters* par)
 
 	prepareUndo();
 
-	pp_int32 samplerate = 48000;
+	SweepFilterState state;
+	state.samplerate = 48000;
 	// static filter (for highpass/lowpass)
-	filter_t lp;
-	filter_t hp;
-	Filter::init( (filter_t *)&lp, samplerate ); 
-	Filter::init( (filter_t *)&hp, samplerate );
+	filter_t& lp = state.lp;
+	filter_t& hp = state.hp;
+	Filter::init( (filter_t *)&lp, state.samplerate ); 
+	Filter::init( (filter_t *)&hp, state.samplerate );
 	hp.cutoff  = par->getParameter(0).floatPart;
 	hp.q       = par->getParameter(2).floatPart / 10.0;
 	lp.cutoff  = par->getParameter(1).floatPart;
@@ -3578,10 +4213,8 @@ void SampleEditor::tool_filter(const FilterParameters* par)
 
 	// sweeping filter
 	int sweep   = (int)par->getParameter(3).floatPart;
-	multifilter_t filter;
-	multifilter_state_t filter0;
 	multifilter_type_t type;
-	filter0.x1 = filter0.x2 = filter0.y1 = filter0.y2 = 0.0;
+	clearMultifilterState(state.sweepState);
 
 	float sweepmin = 150.0f;
 	float sweepmax = 21000.0f;
@@ -3591,34 +4224,16 @@ void SampleEditor::tool_filter(const FilterParameters* par)
 		case 2: { type = FILTER_BANDPASS;sweepmax = lp.cutoff; sweepmin = hp.cutoff; break; }
 		case 3: { type = FILTER_NOTCH;   sweepmax = lp.cutoff; sweepmin = hp.cutoff; break; }
 	}  
-	float sweepadd = sweepmax/float(sample->samplen);
-
-	// lets go
-	pp_int32 i;
-	float in;
-	float out;
+	state.sweep = sweep;
+	state.type = type;
+	state.sweepmin = sweepmin;
+	state.sweepadd = sweepmax/float(sample->samplen);
 
 	// process 
-	for (i = sStart; i < sEnd; i++)
+	filterParallel(sStart, sEnd, state, [&](pp_int32 i, float in, float out)
 	{
-		in = getFloatSampleFromWaveform(i);
-
-		Filter::process( in, (filter_t *)&lp );               // apply LP (+grit)
-		out = lp.out_lp;                                      
-        if( sweep == 0 ){
-			Filter::process( out, (filter_t *)&hp );          // apply HP
-			out = hp.out_hp;
-        }else{												  
-			Filter::multifilter_set(&filter,
-					samplerate,
-					type,
-					sweepmin + (float(i)*sweepadd),            // freq 
-					0.1+hp.q,                                  // res 
-					1.0);                                      // gain
-			out = Filter::multifilter(&filter, &filter0, out );// sweep it!
-        }													   //
-		setFloatSampleInWaveform(i, sin(out * scale) );        // update 
-	}
+		return (float)sin(out * scale);                        // update 
+	});
 
 	finishUndo();
 
@@ -3646,12 +4261,49 @@ void SampleEditor::tool_timestretch(const FilterParameters* par)
   pp_int32 stretch  = 1+(int)par->getParameter(1).floatPart;  // stretch factor
   pp_int32 sLength2 = sample->samplen * (2+stretch);
 
+  bool spectral      = par->getNumParameters() > 2 && par->getParameter(2).floatPart >= 0.5f;
+
   pp_int32 samplerate = XModule::getc4spd(sample->relnote, sample->finetune);
   buf = (float*)malloc( sLength2 * sizeof(float));
   for( i = 0; i < sLength2; i++ ) buf[i] = 0.0f;
 
+  if( spectral ){
+    // phase vocoder, same output length as the grains: samplen*stretch/2
+    float factor  = stretch * 0.5f;
+    pp_int32 size = 256;                      // frame size from the grain size
+    while( size < grain && size < 8192 ) size <<= 1;
+    pp_int32 hop  = size / 4;
+    pp_int32 len  = (pp_int32)(sample->samplen * factor);
+    pp_int32 prev = 0;
+
+    float *in         = (float*)malloc( sample->samplen * sizeof(float));
+    complex *bins     = (complex*)malloc( size * sizeof(complex));
+    float *magnitude  = (float*)malloc( (size/2+1) * sizeof(float));
+    float *frequency  = (float*)malloc( (size/2+1) * sizeof(float));
+    for( i = 0; i < sample->samplen; i++ ) in[i] = getFloatSampleFromWaveform(i);
+
+    STFT stft(size, hop);
+    PhaseVocoder vocoder(size);
+    // frames are written every hop samples and read every hop/factor samples
+    for( pp_int32 s = hop - size; s < len; s += hop ){
+      if( !reportProgress(s + size - hop, len + size - hop) ) break;
+      pp_int32 pos = (pp_int32)floorf((s + size/2) / factor - size/2 + 0.5f);
+      stft.analyze(in, sample->samplen, pos, bins);
+      vocoder.analyze(bins, pos - prev, magnitude, frequency);
+      vocoder.synthesize(magnitude, frequency, hop, bins);
+      stft.synthesize(bins, buf, len, s);
+      prev = pos;
+    }
+    end = len;
+
+    free(frequency);
+    free(magnitude);
+    free(bins);
+    free(in);
+  }
 	// 90s akai-style timestretch algo
-	for (i = 0; i < sample->samplen; i++) {
+	else for (i = 0; i < sample->samplen; i++) {
+    if( !(i & 4095) && !reportProgress(i, sample->samplen) ) break;
     if( gi == 0 ){
       for( pp_int32 s = 0; s < stretch; s++ ){
         overlap += (grain/2);
@@ -3738,6 +4390,7 @@ void SampleEditor::tool_delay(const FilterParameters* par)
 
   // lets go
 	for (iecho= 0; iecho < echos; iecho++ ){
+    if( !reportProgress(iecho, echos) ) break;
     float fi = 0.0f;
     for ( i=0;i < sample->samplen; i++ ){
       fi += 1.0f - detune;
@@ -3836,12 +4489,12 @@ void SampleEditor::tool_vocodeSample(const FilterParameters* par)
 
 	prepareUndo();
 
-	ClipBoard* clipBoard = ClipBoard::getInstance();
+	ClipBoard* clipBoard = getClipBoard();
 
 	pp_int32 cLength = clipBoard->getWidth();
 	pp_int32 sLength = sEnd - sStart;
 	
-	if (ClipBoard::getInstance()->isEmpty())
+	if (clipBoard->isEmpty())
 		return;
 
 	///global internal variables
@@ -3955,6 +4608,9 @@ void SampleEditor::tool_vocodeSample(const FilterParameters* par)
 
 	/* process */
 	for (pp_int32 si = 0; si < sLength; si++) {
+		if (!(si & 4095) && !reportProgress(si, sLength))
+			break;
+
 		pp_int32 j  = si % clipBoard->getWidth();               // repeat carrier
 		pp_int16 s  = clipBoard->getSampleWord((pp_int32)j);   // get clipboard sample word
 		float fclip = s < 0 ? (s / 32768.0f) : (s / 32767.0f); // convert to float
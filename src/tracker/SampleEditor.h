@@ -40,10 +40,12 @@
 #include "fx/EQConstants.h"
 #include "fx/Convolver.h"
 #include <math.h>
+#include <atomic>
 
 struct TXMSample;
 
 class FilterParameters;
+class ParallelFor;
 
 class SampleEditor : public EditorBase
 {
@@ -63,6 +65,8 @@ public:
 		ClipBoard();
 		
 	public:
+		// private copy for tools running in the background
+		ClipBoard(const ClipBoard& source);
 		~ClipBoard();
 		
 		void makeCopy(TXMSample& sample, XModule& module, pp_int32 selectionStart, pp_int32 selectionEnd, bool cut = false);
@@ -123,20 +127,40 @@ private:
 	SampleUndoStackEntry* before;
 	PPUndoStack<SampleUndoStackEntry>* undoStack;	
 	UndoHistory<TXMSample, SampleUndoStackEntry>* undoHistory;
+	// what's known about the current sample state from the last undo step,
+	// used to store only the changed part of the sample in the next one
+	bool undoStateValid;
+	pp_uint32 undoStateSize, undoStateCheckSum, undoStatePrevCheckSum;
+	pp_uint32 undoStatePrefixLen, undoStateSuffixLen;
 	bool lastOperationDidChangeSize;
 	Operations lastOperation;
 
+	// sample data range of the last NotificationChangesRange
+	pp_int32 changedRangeStart, changedRangeEnd;
+
 	bool drawing;
 	pp_int32 lastSamplePos;
 
+	// tool running on a copy of the sample in the background
+	class ToolJob;
+	ToolJob* toolJob;
+	std::atomic<float> toolProgress;
+	std::atomic<bool> toolCancelled;
+	// clipboard of the job's editor, the shared one otherwise
+	ClipBoard* toolClipBoard;
+
+	ClipBoard* getClipBoard() const { return toolClipBoard ? toolClipBoard : ClipBoard::getInstance(); }
+
   Synth *synth;
 
 	void prepareUndo();
 	void finishUndo();
 	
 	bool revoke(const SampleUndoStackEntry* stackEntry);
+	void enforceUndoBudget();
 	
 	void notifyChanges(bool condition, bool lazy = true);
+	void notifyChangedRange(pp_int32 start, pp_int32 end);
  
   friend class Synth;
   friend class Tracker;
@@ -149,6 +173,10 @@ public:
 	// query status
 	bool getLastOperationDidChangeSize() const { return lastOperationDidChangeSize; }
 	Operations getLastOperation() const { return lastOperation; }
+	// sample data [start, end) which changed with the last NotificationChangesRange,
+	// when the length changed everything after start is reported as changed
+	pp_int32 getChangedRangeStart() const { return changedRangeStart; }
+	pp_int32 getChangedRangeEnd() const { return changedRangeEnd; }
 
 	void attachSample(TXMSample* sample, XModule* module);
 	void reset();
@@ -330,8 +358,35 @@ private:
 
 	float getFloatSampleFromWaveform(pp_int32 index, void* source = NULL, pp_int32 size = 0);
 	void setFloatSampleInWaveform(pp_int32 index, float singleSample, void* source = NULL);
-	
+
+	// these split the range over all cores
+	template<class Func>
+	void processFloat(ParallelFor& parallel, bool write, Func func);
+	float getPeak(pp_int32 sStart, pp_int32 sEnd);
+	template<class State, class Output>
+	void filterParallel(pp_int32 sStart, pp_int32 sEnd, const State& initial, Output output);
+
+	// called by the tools while they're busy, returns false when the tool should stop
+	bool reportProgress(pp_int32 pos, pp_int32 len);
+	static bool reportConvolverProgress(void* editor, int pos, int len);
+
+public:
 	typedef void (SampleEditor::*TFilterFunc)(const FilterParameters* par);
+
+	// --- tools running in the background ------------------------------------
+	// the tool processes a copy of the sample on a worker thread while the
+	// original keeps playing, poll isToolJobDone() and apply the result
+	// with finishToolJob(), returns false when the tool can't run that way
+	bool startToolJob(TFilterFunc filterFuncPtr, const FilterParameters* par);
+	bool isToolJobRunning() const { return toolJob != NULL; }
+	bool isToolJobDone() const;
+	float getToolJobProgress() const;
+	// throw away the running job, returns false when there was none
+	bool cancelToolJob();
+	// wait for the job and apply its result with undo
+	bool finishToolJob();
+
+private:
 	FilterParameters* lastParameters;
 	TFilterFunc lastFilterFunc;
 		
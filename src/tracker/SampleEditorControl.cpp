@@ -36,6 +36,7 @@
 #include "FilterParameters.h"
 #include "DialogSliders.h"
 #include "Addon.h"
+#include "SamplePeakCache.h"
 
 #include <algorithm>
 #include <math.h>
@@ -116,6 +117,8 @@ SampleEditorControl::SampleEditorControl(pp_int32 id,
 		showMarks[i].panning = 128;
 	}
 
+	peakCache = new SamplePeakCache();
+
 	// build submenu
 	static const char* seperatorStringLarge = "\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4";
 	static const char* seperatorStringMed = "\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4\xc4";
@@ -238,6 +241,8 @@ SampleEditorControl::~SampleEditorControl()
 
 	delete[] showMarks;
 
+	delete peakCache;
+
 	delete hScrollbar;
 	
 	delete editMenuControl;	
@@ -466,10 +471,30 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 		1.0f/(32768.0f / ((visibleHeight-4)/2)) :
 		1.0f/(128.0f / ((visibleHeight-4)/2));	
 	
-	mp_sint32 lasty = -(pp_int32)(sample->getSampleValue((pp_int32)(startPos*xScale))*scale);
+	// with more than one sample per pixel every column shows the
+	// peaks of the samples it covers instead of a single sample
+	bool drawPeaks = xScale > 1.0f;
+	peakCache->attachSample(sample);
+
+	mp_sint32 lasty = 0, lastTop = 0, lastBottom = 0;
+	if (drawPeaks)
+	{
+		pp_int32 min, max;
+		peakCache->getPeak((pp_int32)(startPos*xScale), (pp_int32)((startPos+1)*xScale), min, max);
+		lastTop = -(mp_sint32)(max*scale);
+		lastBottom = -(mp_sint32)(min*scale);
+	}
+	else
+		lasty = -(pp_int32)(sample->getSampleValue((pp_int32)(startPos*xScale))*scale);
 	
 	g->setColor(*borderColor);
 	g->setPixel(xOffset, yOffset);
+
+	if (drawPeaks)
+	{
+		g->setColor(TrackerConfig::colorSampleEditorWaveform);
+		g->drawVLine(yOffset + lastTop, yOffset + lastBottom + 1, xOffset);
+	}
 	
 	for (mp_sint32 x = 1; x < visibleWidth; x++)
 	{
@@ -488,6 +513,23 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 				g->setColor(TrackerConfig::colorSampleEditorWaveform);
 			}
 			
+			if (drawPeaks)
+			{
+				pp_int32 min, max;
+				peakCache->getPeak((pp_int32)((startPos+x)*xScale), (pp_int32)((startPos+x+1)*xScale), min, max);
+
+				mp_sint32 top = -(mp_sint32)(max*scale);
+				mp_sint32 bottom = -(mp_sint32)(min*scale);
+
+				// reach over to the previous column so steep edges stay connected
+				g->drawVLine(yOffset + (top < lastBottom ? top : lastBottom), 
+							 yOffset + (bottom > lastTop ? bottom : lastTop) + 1, 
+							 xOffset + x);
+				lastTop = top;
+				lastBottom = bottom;
+				continue;
+			}
+
 			float findex = ((startPos+x)*xScale);
 			pp_int32 index = (pp_int32)(floor(findex));
 			pp_int32 index2 = index+1;
@@ -607,6 +649,17 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 	g->setColor(255, 0, 255);
 	g->drawString(buffer, location.x + 2 + visibleWidth - font->getStrWidth(buffer), location.y + 2);
 	
+	// tool busy in the background
+	if (sampleEditor->isToolJobRunning())
+	{
+		sprintf(buffer, "Processing %d%%", (pp_int32)(sampleEditor->getToolJobProgress()*100.0f));
+
+		g->setColor(0, 0, 0);
+		g->drawString(buffer, location.x + 3, location.y + 3);
+		g->setColor(255, 255, 255);
+		g->drawString(buffer, location.x + 2, location.y + 2);
+	}
+
 	// Draw sample offset cursor is nearest to
 	if ((::getKeyModifier() & KeyModifierCTRL) && currentPosition.x >= 0 && currentPosition.y >= 0)
 	{
@@ -2091,6 +2144,8 @@ void SampleEditorControl::editorNotification(EditorBase* sender, EditorBase::Edi
 	
 		case SampleEditor::NotificationReload:
 		{
+			peakCache->invalidate();
+
 			if (!sampleEditor->isEmptySample())
 			{
 				xScale = calcScale();
@@ -2141,6 +2196,10 @@ void SampleEditorControl::editorNotification(EditorBase* sender, EditorBase::Edi
 			break;
 		}
 				
+		case SampleEditor::NotificationChangesRange:
+			peakCache->invalidate(sampleEditor->getChangedRangeStart(), sampleEditor->getChangedRangeEnd());
+			break;
+
 		case SampleEditor::NotificationChanges:
 		{
 			bool lazyUpdateNotifications = sampleEditor->getLazyUpdateNotifications();
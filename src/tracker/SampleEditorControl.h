@@ -39,6 +39,7 @@ class PPControl;
 class PPContextMenu;
 class FilterParameters;
 class PPDialogBase;
+class SamplePeakCache;
 
 class SampleEditorControl : public PPControl, public EventListenerInterface, public EditorBase::EditorNotificationListener
 {
@@ -108,6 +109,9 @@ private:
 	
 	// necessary for controlling
 	SampleEditor* sampleEditor;
+
+	// min/max values of the sample for drawing it zoomed out
+	SamplePeakCache* peakCache;
 	
 	pp_int32 relativeNote;
 	OffsetFormats offsetFormat;
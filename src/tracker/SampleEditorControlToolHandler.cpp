@@ -296,10 +296,11 @@ bool SampleEditorControl::invokeToolParameterDialog(SampleEditorControl::ToolHan
     }
 
     case ToolHandlerResponder::SampleToolTypeTimeStretch:{
-      dialog = new DialogSliders(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "90s Timestretch", 2, sampleEditor, &SampleEditor::tool_timestretch );
+      dialog = new DialogSliders(parentScreen, toolHandlerResponder, PP_DEFAULT_ID, "Timestretch", 3, sampleEditor, &SampleEditor::tool_timestretch );
       DialogSliders *sliders = static_cast<DialogSliders*>(dialog);
       sliders->initSlider(0,1,10000,3900,"Grainsize");
       sliders->initSlider(1,0,20,3,"Stretch");
+      sliders->initSlider(2,0,1,0,"90s \x1d Spectral");
 	  sliders->process();
       break;
     }
@@ -45,12 +45,77 @@ SampleEditorResampler::~SampleEditorResampler()
 {
 }
 
+// reads the sample without the loop double buffering
+class SampleSource : public PolyphaseResampler::Source
+{
+private:
+	TXMSample& sample;
+
+public:
+	SampleSource(TXMSample& sample) :
+		sample(sample)
+	{
+	}
+
+	virtual void read(pp_uint32 index, pp_uint32 count, float* dest)
+	{
+		sample.readFloat(index, count, dest);
+	}
+};
+
+bool SampleEditorResampler::resamplePolyphase(float oldRate, float newRate, PolyphaseResampler::Qualities quality)
+{
+	SampleSource source(sample);
+	PolyphaseResampler resampler(source, sample.samplen, oldRate, newRate, quality);
+
+	mp_uint32 finalSize = resampler.getOutputLength();
+
+	// the new data is converted block by block, no loop yet
+	TXMSample result = sample;
+	result.type = sample.type & 16;
+	result.samplen = finalSize;
+	result.sample = (mp_sbyte*)module.allocSampleMem((sample.type & 16) ? finalSize*2 : finalSize);
+
+	if (result.sample == NULL)
+		return false;
+
+	float block[4096];
+	for (mp_uint32 pos = 0; pos < finalSize; )
+	{
+		mp_uint32 count = resampler.process(block, sizeof(block) / sizeof(float));
+		result.writeFloat(pos, count, block);
+		pos += count;
+	}
+
+	module.freeSampleMem((mp_ubyte*)sample.sample);
+
+	sample.sample = result.sample;
+	sample.samplen = finalSize;
+	return true;
+}
+
 // we're going to abuse the resampler of the ChannelMixer class
 // Problem here is, we need to build up some temporary channel structure 
 // PLUS the resampler only deals with stereo channels, so basically we're 
 // resampling stereo data (left channel = full, right channel = empty)
 bool SampleEditorResampler::resample(float oldRate, float newRate)
 {
+	// the smooth interpolations use the band-limited offline resampler,
+	// the others mimic the player and go through its resamplers
+	ResamplerHelper resamplerHelper;
+	switch (resamplerHelper.getResamplerType(type, false))
+	{
+		case ChannelMixer::MIXER_LAGRANGE:
+		case ChannelMixer::MIXER_SPLINE:
+			return resamplePolyphase(oldRate, newRate, PolyphaseResampler::QualityFast);
+		case ChannelMixer::MIXER_SINCTABLE:
+			return resamplePolyphase(oldRate, newRate, PolyphaseResampler::QualityGood);
+		case ChannelMixer::MIXER_SINC:
+			return resamplePolyphase(oldRate, newRate, PolyphaseResampler::QualityBest);
+		default:
+			break;
+	}
+
 	float factor = oldRate / newRate;
 
 	mp_ubyte* buffer = TXMSample::allocPaddedMem(sample.samplen * ((sample.type & 16) ? 2 : 1));
@@ -132,7 +197,6 @@ bool SampleEditorResampler::resample(float oldRate, float newRate)
 	channel.rampFromVolStepL = channel.rampFromVolStepR = 0;	
 	channel.index = 0;
 	
-	ResamplerHelper resamplerHelper;
 	ChannelMixer::ResamplerBase* resampler = resamplerHelper.createResamplerFromIndex(type);
 
 	if (resampler == NULL)
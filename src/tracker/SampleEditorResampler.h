@@ -32,6 +32,7 @@
 #define __SAMPLEEDITORRESAMPLER_H__
 
 #include "BasicTypes.h"
+#include "PolyphaseResampler.h"
 
 class SampleEditorResampler
 {
@@ -40,6 +41,8 @@ private:
 	struct TXMSample& sample;
 	pp_uint32 type;
 
+	bool resamplePolyphase(float oldRate, float newRate, PolyphaseResampler::Qualities quality);
+
 public:
 	SampleEditorResampler(XModule& module, TXMSample& sample, pp_uint32 type);
 	virtual ~SampleEditorResampler();
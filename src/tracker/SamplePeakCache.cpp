@@ -0,0 +1,260 @@
+/*
+ *  tracker/SamplePeakCache.cpp
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SamplePeakCache.h"
+#include "XModule.h"
+
+// samples per level 0 block and blocks per block of the next level, as shifts
+#define BASESHIFT	5
+#define LEVELSHIFT	2
+
+static inline pp_uint32 blockShift(pp_int32 level)
+{
+	return BASESHIFT + level*LEVELSHIFT;
+}
+
+SamplePeakCache::SamplePeakCache() :
+	sample(NULL),
+	data(NULL),
+	samplen(0),
+	loopEnd(0),
+	is16Bit(false),
+	peaks(NULL),
+	peaksSize(0),
+	numLevels(0),
+	dirtyFrom(0),
+	dirtyTo(0)
+{
+}
+
+SamplePeakCache::~SamplePeakCache()
+{
+	delete[] peaks;
+}
+
+void SamplePeakCache::invalidate()
+{
+	dirtyFrom = 0;
+	dirtyTo = samplen;
+}
+
+void SamplePeakCache::invalidate(pp_uint32 from, pp_uint32 to)
+{
+	if (to > samplen)
+		to = samplen;
+	if (from >= to)
+		return;
+
+	if (dirtyFrom >= dirtyTo)
+	{
+		dirtyFrom = from;
+		dirtyTo = to;
+	}
+	else
+	{
+		if (from < dirtyFrom)
+			dirtyFrom = from;
+		if (to > dirtyTo)
+			dirtyTo = to;
+	}
+}
+
+void SamplePeakCache::attachSample(TXMSample* sample)
+{
+	this->sample = sample;
+
+	const pp_int8* newData = sample ? (const pp_int8*)sample->sample : NULL;
+	pp_uint32 newSamplen = newData ? sample->samplen : 0;
+	bool newIs16Bit = newData && (sample->type & 16);
+
+	// changes of the data itself are reported through invalidate(),
+	// the memory might just have moved somewhere else
+	data = newData;
+
+	if (newSamplen != samplen || newIs16Bit != is16Bit)
+	{
+		samplen = newSamplen;
+		is16Bit = newIs16Bit;
+
+		numLevels = 0;
+		pp_uint32 size = 0;
+		if (samplen)
+		{
+			// stop at the first level which fits into a single block
+			// or whose block size would not fit into 32 bits anymore
+			do
+			{
+				levelOffset[numLevels] = size;
+				levelBlocks[numLevels] = ((samplen - 1) >> blockShift(numLevels)) + 1;
+				size += levelBlocks[numLevels] * 2;
+				numLevels++;
+			} while (levelBlocks[numLevels - 1] > 1 && blockShift(numLevels) < 32 && numLevels < MAXLEVELS);
+		}
+
+		if (size > peaksSize)
+		{
+			delete[] peaks;
+			peaks = new pp_int16[size];
+			peaksSize = size;
+		}
+
+		loopEnd = newData && (sample->type & 3) ? sample->loopstart + sample->looplen : 0;
+		invalidate();
+		return;
+	}
+
+	// the few samples behind the loop end are read from the loop double buffer
+	pp_uint32 newLoopEnd = newData && (sample->type & 3) ? sample->loopstart + sample->looplen : 0;
+	if (newLoopEnd != loopEnd)
+	{
+		invalidate(loopEnd, loopEnd + (2 << BASESHIFT));
+		invalidate(newLoopEnd, newLoopEnd + (2 << BASESHIFT));
+		loopEnd = newLoopEnd;
+	}
+}
+
+void SamplePeakCache::buildBlock(pp_uint32 block)
+{
+	pp_uint32 from = block << BASESHIFT;
+	pp_uint32 to = from + (1 << BASESHIFT);
+	if (to > samplen)
+		to = samplen;
+
+	pp_int32 min = 32767, max = -32768;
+
+	// getSampleValue knows about the loop double buffer, reading the
+	// memory directly is fine everywhere else
+	if (loopEnd && loopEnd < to + (1 << BASESHIFT) && loopEnd + (1 << BASESHIFT) > from)
+	{
+		for (pp_uint32 i = from; i < to; i++)
+		{
+			pp_int32 s = sample->getSampleValue(i);
+			if (s < min) min = s;
+			if (s > max) max = s;
+		}
+	}
+	else if (is16Bit)
+	{
+		const pp_int16* src = (const pp_int16*)data;
+		for (pp_uint32 i = from; i < to; i++)
+		{
+			pp_int32 s = src[i];
+			if (s < min) min = s;
+			if (s > max) max = s;
+		}
+	}
+	else
+	{
+		for (pp_uint32 i = from; i < to; i++)
+		{
+			pp_int32 s = data[i];
+			if (s < min) min = s;
+			if (s > max) max = s;
+		}
+	}
+
+	peaks[block*2] = (pp_int16)min;
+	peaks[block*2+1] = (pp_int16)max;
+}
+
+void SamplePeakCache::update()
+{
+	if (dirtyFrom >= dirtyTo || !numLevels)
+		return;
+
+	pp_uint32 first = dirtyFrom >> BASESHIFT;
+	pp_uint32 last = (dirtyTo - 1) >> BASESHIFT;
+
+	for (pp_uint32 block = first; block <= last; block++)
+		buildBlock(block);
+
+	// every level only has to follow the blocks which changed below it
+	for (pp_int32 level = 1; level < numLevels; level++)
+	{
+		const pp_int16* src = peaks + levelOffset[level - 1];
+		pp_int16* dst = peaks + levelOffset[level];
+		pp_uint32 srcBlocks = levelBlocks[level - 1];
+
+		first >>= LEVELSHIFT;
+		last >>= LEVELSHIFT;
+
+		for (pp_uint32 block = first; block <= last; block++)
+		{
+			pp_uint32 from = block << LEVELSHIFT;
+			pp_uint32 to = from + (1 << LEVELSHIFT);
+			if (to > srcBlocks)
+				to = srcBlocks;
+
+			pp_int16 min = src[from*2], max = src[from*2+1];
+			for (pp_uint32 i = from + 1; i < to; i++)
+			{
+				if (src[i*2] < min) min = src[i*2];
+				if (src[i*2+1] > max) max = src[i*2+1];
+			}
+
+			dst[block*2] = min;
+			dst[block*2+1] = max;
+		}
+	}
+
+	dirtyFrom = dirtyTo = 0;
+}
+
+void SamplePeakCache::getPeak(pp_uint32 from, pp_uint32 to, pp_int32& min, pp_int32& max)
+{
+	if (to > samplen)
+		to = samplen;
+
+	min = max = 0;
+	if (from >= to)
+		return;
+
+	update();
+
+	min = 32767;
+	max = -32768;
+
+	// walk along the largest aligned blocks which fit into the range,
+	// the ends which don't fill a level 0 block are read sample by sample
+	pp_uint32 pos = from;
+	while (pos < to)
+	{
+		pp_int32 level = numLevels - 1;
+		while (level >= 0 &&
+			   ((pos & ((1u << blockShift(level)) - 1)) || to - pos < (1u << blockShift(level))))
+			level--;
+
+		if (level < 0)
+		{
+			pp_int32 s = sample->getSampleValue(pos);
+			if (s < min) min = s;
+			if (s > max) max = s;
+			pos++;
+			continue;
+		}
+
+		const pp_int16* entry = peaks + levelOffset[level] + (pos >> blockShift(level))*2;
+		if (entry[0] < min) min = entry[0];
+		if (entry[1] > max) max = entry[1];
+		pos += 1u << blockShift(level);
+	}
+}
@@ -0,0 +1,83 @@
+/*
+ *  tracker/SamplePeakCache.h
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Min/max pyramid of a sample for drawing the waveform.
+ * Level 0 holds the peaks of blocks of 32 samples, every following level
+ * combines 4 blocks of the level below. Any range can be answered with a
+ * few entries from each level, so a zoomed out waveform costs O(width)
+ * and shows the real peaks instead of whatever sample a pixel happens to hit.
+ */
+
+#ifndef __SAMPLEPEAKCACHE_H__
+#define __SAMPLEPEAKCACHE_H__
+
+#include "BasicTypes.h"
+
+struct TXMSample;
+
+class SamplePeakCache
+{
+private:
+	enum
+	{
+		MAXLEVELS = 16
+	};
+
+	TXMSample* sample;
+
+	// what the pyramid was built from
+	const pp_int8* data;
+	pp_uint32 samplen;
+	pp_uint32 loopEnd;
+	bool is16Bit;
+
+	// min/max pairs of all levels one after another
+	pp_int16* peaks;
+	pp_uint32 peaksSize;
+	pp_int32 numLevels;
+	pp_uint32 levelOffset[MAXLEVELS];
+	pp_uint32 levelBlocks[MAXLEVELS];
+
+	// sample range which has changed since the last update
+	pp_uint32 dirtyFrom, dirtyTo;
+
+	void buildBlock(pp_uint32 block);
+	void update();
+
+public:
+	SamplePeakCache();
+	~SamplePeakCache();
+
+	// mark sample data as changed, the pyramid is updated on the next query
+	void invalidate();
+	void invalidate(pp_uint32 from, pp_uint32 to);
+
+	// sample to answer the following queries from, changes of the length,
+	// resolution or loop are picked up here
+	void attachSample(TXMSample* sample);
+
+	// smallest and largest value in [from, to), in the sample's own resolution
+	void getPeak(pp_uint32 from, pp_uint32 to, pp_int32& min, pp_int32& max);
+};
+
+#endif
@@ -417,7 +417,7 @@ pp_int32 SectionDiskMenu::handleEvent(PPObject* sender, PPEvent* event)
 				break;
 
 			case DISKMENU_CLASSIC_BUTTON_REFRESH:
-				reload();
+				reload(true, true);
 				break;
 
 			case DISKMENU_CLASSIC_BUTTON_DELETE:
@@ -536,7 +536,8 @@ pp_int32 SectionDiskMenu::handleEvent(PPObject* sender, PPEvent* event)
 	}
 	else if (event->getID() == eFileSystemChanged)
 	{
-		reload();
+		// an overwritten file doesn't change its folder
+		reload(true, true);
 	}
 	else if (event->getID() == eValueChanged)
 	{
@@ -1633,7 +1634,7 @@ void SectionDiskMenu::deleteCurrent()
 	
 	XMFile::remove(fileFullPath);
 	
-	reload();
+	reload(true, true);
 }
 
 void SectionDiskMenu::updateButtonStates(bool repaint/* = true*/)
@@ -1770,7 +1771,7 @@ void SectionDiskMenu::home(bool repaint/* = true*/)
 	updateButtonStates();
 }
 
-void SectionDiskMenu::reload(bool repaint/* = true*/)
+void SectionDiskMenu::reload(bool repaint/* = true*/, bool rescan/* = false*/)
 {
 	PPPathEntry* pathEntry = NULL;
 	const PPPathEntry* src = listBoxFiles->getCurrentSelectedPathEntry();
@@ -1779,19 +1780,13 @@ void SectionDiskMenu::reload(bool repaint/* = true*/)
 		pathEntry = src->clone();
 
 	listBoxFiles->saveState();
-	listBoxFiles->refreshFiles();
+	listBoxFiles->refreshFiles(rescan);
 	listBoxFiles->restoreState(false);
 	
 	if (pathEntry)
 	{
-		for (pp_int32 i = 0; i < listBoxFiles->getNumItems(); i++)
-		{
-			if (pathEntry->compareTo(*listBoxFiles->getPathEntry(i)))
-			{
-				listBoxFiles->setSelectedIndex(i, false);
-				break;
-			}
-		}
+		// picked up later if the folder is still being read
+		listBoxFiles->selectPathEntry(*pathEntry);
 		delete pathEntry;
 	}
 	
@@ -162,7 +162,8 @@ private:
 	void parent(bool repaint = true);
 	void root(bool repaint = true);
 	void home(bool repaint = true);
-	void reload(bool repaint = true);
+	// rescan reads the folder again instead of taking the cached listing
+	void reload(bool repaint = true, bool rescan = false);
 
 	void updateFilter(bool repaint = true);
 	
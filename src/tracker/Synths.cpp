@@ -499,6 +499,7 @@ void Synth::FM( bool init ){
 		}
 	}
 
+	sampleEditor->notifyChangedRange(0, sample->samplen);
 	sampleEditor->notifyListener(SampleEditor::NotificationChanges); // update UI
 	free(smpin);
 }
@@ -843,6 +844,7 @@ void Synth::PL( bool init ){
 		}
 	}
 
+	sampleEditor->notifyChangedRange(0, sample->samplen);
 	sampleEditor->notifyListener(SampleEditor::NotificationChanges); // update UI
 																	 //
 	free(synth_tab);
@@ -2648,6 +2648,8 @@ bool Tracker::loadGenericFileType(const PPSystemString& fileName)
 bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bool suspendPlayer, bool repaint, bool saveCheck)
 {
 	loadingParameters.deleteFile = false;
+	delete loadingParameters.memoryFile;
+	loadingParameters.memoryFile = NULL;
 	loadingParameters.didOpenTab = false;
 	loadingParameters.eType = eType;
 	loadingParameters.filename = fileName;	
@@ -2692,8 +2694,23 @@ bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bo
 	if (type == FileIdentificator::FileTypeCompressed)
 	{
 		// if this is compressed, try to decompress
-		PPSystemString tempFile(ModuleEditor::getTempFilename());
 		Decompressor decompressor(fileName);
+		
+		// modules can be loaded straight from memory
+		if (eType == FileTypes::FileTypeSongAllModules)
+		{
+			XMMemoryFile* memoryFile = new XMMemoryFile();
+			if (decompressor.decompress(*memoryFile, (DecompressorBase::Hints)fileTypeToHint(eType)))
+			{
+				memoryFile->seek(0);
+				loadingParameters.preferredFilename = loadingParameters.filename;
+				loadingParameters.memoryFile = memoryFile;
+				return true;
+			}
+			delete memoryFile;
+		}
+		
+		PPSystemString tempFile(ModuleEditor::getTempFilename());
 		if (decompressor.decompress(tempFile, (DecompressorBase::Hints)fileTypeToHint(eType)))
 		{
 			// we compressed to a temporary file
@@ -2738,6 +2755,9 @@ bool Tracker::finishLoading()
 	if (loadingParameters.deleteFile)
 		Decompressor::removeFile(loadingParameters.filename);
 		
+	delete loadingParameters.memoryFile;
+	loadingParameters.memoryFile = NULL;
+		
 	if (!loadingParameters.res && loadingParameters.didOpenTab)
 		tabManager->closeTab();
 	
@@ -2754,7 +2774,10 @@ bool Tracker::loadTypeFromFile(FileTypes eType, const PPSystemString& fileName,
 	{
 		case FileTypes::FileTypeSongAllModules:
 		{
-			if (loadingParameters.preferredFilename.length())
+			if (loadingParameters.memoryFile)
+				loadingParameters.res = moduleEditor->openSong(*loadingParameters.memoryFile,
+				loadingParameters.preferredFilename);
+			else if (loadingParameters.preferredFilename.length())
 				loadingParameters.res = moduleEditor->openSong(loadingParameters.filename,
 				loadingParameters.preferredFilename);
 			else
@@ -401,11 +401,14 @@ private:
 		bool abortLoading;
 		bool deleteFile;
 		bool didOpenTab;
+		// decompressed file if it could be kept in memory
+		XMMemoryFile* memoryFile;
 		
 		TPrepareLoadingParameters() :
 			abortLoading(false),
 			deleteFile(false),
-			didOpenTab(false)
+			didOpenTab(false),
+			memoryFile(NULL)
 		{
 		}
 	} loadingParameters;
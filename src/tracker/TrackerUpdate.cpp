@@ -871,7 +871,21 @@ void Tracker::doFollowSong()
 		bool showMarksVisibleOld = sampleEditorControl->isVisible() ? sampleEditorControl->showMarksVisible() : false;
 		bool updateSample = false;
 	
-		TXMSample* smp = getSampleEditor()->getSample();
+		// tool running in the background, show its progress and apply the result when it's done
+		SampleEditor* sampleEditor = getSampleEditor();
+		if (sampleEditor->isToolJobRunning())
+		{
+			if (sampleEditor->isToolJobDone())
+				sampleEditor->finishToolJob();
+
+			if (sampleEditorControl->isVisible())
+			{
+				sectionSamples->updateSampleWindow(false);
+				importantRefresh = true;
+			}
+		}
+
+		TXMSample* smp = sampleEditor->getSample();
 
 		for (pp_int32 i = 0; i < playerController->getAllNumPlayingChannels(); i++)
 		{
@@ -24,10 +24,34 @@
 
 #include "Undo.h"
 
+#ifdef HAVE_ZLIB
+#include "zlib.h"
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //														patterns
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+static pp_uint32 calcUndoCheckSum(const pp_uint8* data, pp_uint32 size)
+{
+	pp_uint32 checkSum = 0;
+	for (pp_uint32 i = 0; i < size; i++)
+		checkSum = checkSum*33 + data[i];
+	return checkSum;
+}
+
+void PatternUndoStackEntry::CellRange::include(const CellRange& range)
+{
+	if (range.startChannel < startChannel)
+		startChannel = range.startChannel;
+	if (range.startRow < startRow)
+		startRow = range.startRow;
+	if (range.endChannel > endChannel)
+		endChannel = range.endChannel;
+	if (range.endRow > endRow)
+		endRow = range.endRow;
+}
+
 //---------------------------------------------------------------------------
 // Pre     : 
 // Post    : 
@@ -39,8 +63,16 @@ PatternUndoStackEntry::PatternUndoStackEntry(const TXMPattern& pattern,
 											 const pp_int32 cursorPositionChannel, 
 											 const pp_int32 cursorPositionRow, 
 											 const pp_int32 cursorPositionInner,
-											 const UserData* userData/* = NULL*/) :
-	UndoStackEntry(userData)
+											 const UserData* userData/* = NULL*/,
+											 const CellRange* range/* = NULL*/,
+											 const pp_uint32* checkSum/* = NULL*/) :
+	UndoStackEntry(userData),
+	cells(NULL),
+	cellsLen(0),
+	prevCheckSum(0),
+	nextCheckSum(0),
+	prevCheckSumValid(false),
+	nextCheckSumValid(false)
 {
 	this->cursorPositionChannel = cursorPositionChannel;
 	this->cursorPositionRow = cursorPositionRow;
@@ -48,20 +80,46 @@ PatternUndoStackEntry::PatternUndoStackEntry(const TXMPattern& pattern,
 	
 	if (pattern.patternData)
 	{
-		this->pattern.rows = pattern.rows;
-		this->pattern.channum = pattern.channum;
-		this->pattern.effnum = pattern.effnum;
+		rows = pattern.rows;
+		channum = pattern.channum;
+		effnum = pattern.effnum;
+	}
+	else
+	{
+		rows = channum = effnum = 0;
+	}
 	
-		this->pattern.len = pattern.compress(NULL);
-		
-		this->pattern.patternData = new mp_ubyte[this->pattern.len];
-
-		mp_sint32 len = pattern.compress(this->pattern.patternData);
-		
-		ASSERT(len == (signed)this->pattern.len);
+	this->checkSum = checkSum ? *checkSum : calcCheckSum(pattern);
+	
+	if (range)
+	{
+		this->range = *range;
 	}
 	else
-		memset(&this->pattern, 0, sizeof(pattern));
+	{
+		this->range.startChannel = this->range.startRow = 0;
+		this->range.endChannel = channum - 1;
+		this->range.endRow = rows - 1;
+	}
+
+	if (rows == 0 || channum == 0)
+		return;
+
+	ASSERT(this->range.startChannel >= 0 && this->range.endChannel < channum);
+	ASSERT(this->range.startRow >= 0 && this->range.endRow < rows);
+
+	const pp_uint32 slotSize = 2 + effnum*2;
+	const pp_uint32 rowLen = (this->range.endChannel - this->range.startChannel + 1) * slotSize;
+
+	cellsLen = (this->range.endRow - this->range.startRow + 1) * rowLen;
+	cells = new mp_ubyte[cellsLen];
+	
+	mp_ubyte* dst = cells;
+	for (pp_int32 r = this->range.startRow; r <= this->range.endRow; r++)
+	{
+		memcpy(dst, pattern.patternData + (r*channum + this->range.startChannel)*slotSize, rowLen);
+		dst+=rowLen;
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -72,19 +130,50 @@ PatternUndoStackEntry::PatternUndoStackEntry(const TXMPattern& pattern,
 // Task    : Copy constructor
 //---------------------------------------------------------------------------
 PatternUndoStackEntry::PatternUndoStackEntry(const PatternUndoStackEntry& source) :
-	UndoStackEntry(&source.getUserData())
+	UndoStackEntry(&source.getUserData()),
+	cells(NULL)
+{
+	copy(source);
+}
+
+//---------------------------------------------------------------------------
+// Pre     : 
+// Post    : 
+// Globals : 
+// I/O     : 
+// Task    : Clean up
+//---------------------------------------------------------------------------
+PatternUndoStackEntry::~PatternUndoStackEntry()
+{
+	delete[] cells;
+}
+
+void PatternUndoStackEntry::copy(const PatternUndoStackEntry& source)
 {
 	cursorPositionChannel = source.cursorPositionChannel;
 	cursorPositionRow = source.cursorPositionRow;
 	cursorPositionInner = source.cursorPositionInner;
 
-	pattern.len = source.pattern.len;
-	pattern.rows = source.pattern.rows;
-	pattern.channum = source.pattern.channum;
-	pattern.effnum = source.pattern.effnum;
+	rows = source.rows;
+	channum = source.channum;
+	effnum = source.effnum;
+	range = source.range;
+	
+	checkSum = source.checkSum;
+	prevCheckSum = source.prevCheckSum;
+	nextCheckSum = source.nextCheckSum;
+	prevCheckSumValid = source.prevCheckSumValid;
+	nextCheckSumValid = source.nextCheckSumValid;
+
+	delete[] cells;
+	cells = NULL;
+	cellsLen = source.cellsLen;
 	
-	pattern.patternData = new mp_ubyte[pattern.len];
-	memcpy(pattern.patternData, source.pattern.patternData, pattern.len);
+	if (source.cells)
+	{
+		cells = new mp_ubyte[cellsLen];
+		memcpy(cells, source.cells, cellsLen);
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -92,11 +181,94 @@ PatternUndoStackEntry::PatternUndoStackEntry(const PatternUndoStackEntry& source
 // Post    : 
 // Globals : 
 // I/O     : 
-// Task    : Clean up
+// Task    : Does this entry hold the entire pattern?
 //---------------------------------------------------------------------------
-PatternUndoStackEntry::~PatternUndoStackEntry()
+bool PatternUndoStackEntry::isComplete() const
+{
+	return range.startChannel == 0 && range.startRow == 0 &&
+		range.endChannel == channum - 1 && range.endRow == rows - 1;
+}
+
+//---------------------------------------------------------------------------
+// Pre     : 
+// Post    : 
+// Globals : 
+// I/O     : 
+// Task    : Checksum of all cells, partial entries are only restored on 
+//			 top of the pattern states next to them on the undo stack.
+//			 The cells are combined with xor, so the checksum of a pattern
+//			 can be updated with the checksums of the old and new cells of
+//			 a range without going through the entire pattern
+//---------------------------------------------------------------------------
+pp_uint32 PatternUndoStackEntry::calcCheckSum(const TXMPattern& pattern, const CellRange* range/* = NULL*/)
 {
-	delete[] pattern.patternData;
+	if (pattern.patternData == NULL)
+		return 0;
+
+	const pp_uint32 slotSize = 2 + pattern.effnum*2;
+	
+	pp_int32 startChannel = 0, startRow = 0;
+	pp_int32 endChannel = pattern.channum - 1, endRow = pattern.rows - 1;
+	if (range)
+	{
+		startChannel = range->startChannel;
+		startRow = range->startRow;
+		endChannel = range->endChannel;
+		endRow = range->endRow;
+	}
+	
+	pp_uint32 checkSum = 0;
+	for (pp_int32 r = startRow; r <= endRow; r++)
+	{
+		const mp_ubyte* slot = pattern.patternData + (r*pattern.channum + startChannel)*slotSize;
+		for (pp_int32 c = startChannel; c <= endChannel; c++, slot+=slotSize)
+		{
+			// position goes in as well, equal cells must not cancel out
+			pp_uint32 cellSum = calcUndoCheckSum(slot, slotSize) ^ ((pp_uint32)(r*pattern.channum + c) * 0x9E3779B1);
+			cellSum ^= cellSum >> 16;
+			cellSum *= 0x85EBCA6B;
+			cellSum ^= cellSum >> 13;
+			cellSum *= 0xC2B2AE35;
+			cellSum ^= cellSum >> 16;
+			checkSum ^= cellSum;
+		}
+	}
+	
+	return checkSum;
+}
+
+bool PatternUndoStackEntry::canRestoreFrom(pp_uint32 checkSum) const
+{
+	if (isComplete())
+		return true;
+		
+	return (prevCheckSumValid && checkSum == prevCheckSum) ||
+		(nextCheckSumValid && checkSum == nextCheckSum);
+}
+
+//---------------------------------------------------------------------------
+// Pre     : pattern has the dimensions of this entry
+// Post    : 
+// Globals : 
+// I/O     : 
+// Task    : Write stored cells back into pattern
+//---------------------------------------------------------------------------
+void PatternUndoStackEntry::restore(TXMPattern& pattern) const
+{
+	ASSERT(pattern.rows == rows && pattern.channum == channum && pattern.effnum == effnum);
+
+	if (cells == NULL || pattern.patternData == NULL)
+		return;
+
+	const pp_uint32 slotSize = 2 + effnum*2;
+	const pp_uint32 rowLen = (range.endChannel - range.startChannel + 1) * slotSize;
+	
+	const mp_ubyte* src = cells;
+	for (pp_int32 r = range.startRow; r <= range.endRow; r++)
+	{
+		memcpy(pattern.patternData + (r*channum + range.startChannel)*slotSize, src, rowLen);
+		src+=rowLen;
+	}
 }
 
 //---------------------------------------------------------------------------
@@ -112,21 +284,7 @@ PatternUndoStackEntry& PatternUndoStackEntry::operator=(const PatternUndoStackEn
 	if (this != &source)
 	{
 		copyBasePart(source);
-	
-		cursorPositionChannel = source.cursorPositionChannel;
-		cursorPositionRow = source.cursorPositionRow;
-		cursorPositionInner = source.cursorPositionInner;	
-		
-		if (pattern.patternData)
-			delete[] pattern.patternData;
-	
-		pattern.len = source.pattern.len;
-		pattern.rows = source.pattern.rows;
-		pattern.channum = source.pattern.channum;
-		pattern.effnum = source.pattern.effnum;
-		
-		pattern.patternData = new mp_ubyte[pattern.len];
-		memcpy(pattern.patternData, source.pattern.patternData, pattern.len);
+		copy(source);
 	}
 
 	return *this;
@@ -141,21 +299,14 @@ PatternUndoStackEntry& PatternUndoStackEntry::operator=(const PatternUndoStackEn
 //---------------------------------------------------------------------------
 bool PatternUndoStackEntry::operator==(const PatternUndoStackEntry& source)
 {
-	ASSERT(source.pattern.patternData);
-	ASSERT(pattern.patternData);
-
-	if (pattern.len == source.pattern.len &&
-		pattern.rows == source.pattern.rows &&
-		pattern.channum == source.pattern.channum &&
-		pattern.effnum == source.pattern.effnum)
-	{
-		if (memcmp(pattern.patternData, source.pattern.patternData, pattern.len) == 0)
-			return true;
-		else
-			return false;
-	}
-	else
+	if (rows != source.rows ||
+		channum != source.channum ||
+		effnum != source.effnum ||
+		cellsLen != source.cellsLen ||
+		memcmp(&range, &source.range, sizeof(range)) != 0)
 		return false;
+
+	return cellsLen == 0 || memcmp(cells, source.cells, cellsLen) == 0;
 }
 
 bool PatternUndoStackEntry::operator!=(const PatternUndoStackEntry& source)
@@ -229,26 +380,76 @@ void EnvelopeUndoStackEntry::GetEnvelope(TEnvelope& env) const
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //														samples
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void SampleUndoStackEntry::calcCheckSum()
+pp_uint32 SampleUndoStackEntry::totalMemoryUsage = 0;
+
+pp_uint32 SampleUndoStackEntry::calcCheckSum(const pp_uint8* data, pp_uint32 size)
 {
-	checkSum = 0;
-	if (!buffer)
-		return;
-	mp_uint32 size = (flags & 16) ? samplen*2 : samplen;
-	if (size)
+	return calcUndoCheckSum(data, size);
+}
+
+void SampleUndoStackEntry::init()
+{
+	samplen = loopstart = looplen = 0;
+	relnote = finetune = 0;
+	flags = 0;
+	dataPresent = false;
+	selectionStart = selectionEnd = -1;
+	data = NULL;
+	dataLen = 0;
+	prefixLen = suffixLen = 0;
+	compressed = false;
+	checkSum = prevCheckSum = nextCheckSum = 0;
+	prevCheckSumValid = nextCheckSumValid = false;
+}
+
+void SampleUndoStackEntry::setData(pp_uint8* data, pp_uint32 dataLen, bool compressed)
+{
+	delete[] this->data;
+	totalMemoryUsage-=this->dataLen;
+	
+	this->data = data;
+	this->dataLen = dataLen;
+	this->compressed = compressed;
+	totalMemoryUsage+=dataLen;
+}
+
+void SampleUndoStackEntry::copy(const SampleUndoStackEntry& src)
+{
+	samplen = src.samplen;
+	loopstart = src.loopstart;
+	looplen = src.looplen;	
+	relnote = src.relnote;
+	finetune = src.finetune;
+	flags = src.flags;
+	dataPresent = src.dataPresent;
+	selectionStart = src.selectionStart;
+	selectionEnd = src.selectionEnd;
+	prefixLen = src.prefixLen;
+	suffixLen = src.suffixLen;
+	checkSum = src.checkSum;
+	prevCheckSum = src.prevCheckSum;
+	nextCheckSum = src.nextCheckSum;
+	prevCheckSumValid = src.prevCheckSumValid;
+	nextCheckSumValid = src.nextCheckSumValid;
+	
+	pp_uint8* mem = NULL;
+	if (src.data && src.dataLen)
 	{
-		mp_ubyte* mem = TXMSample::getPadStartAddr(buffer);
-		mp_uint32 realSize = TXMSample::getPaddedSize(size);
-		for (pp_uint32 i = 0; i < realSize; i++)
-			checkSum+=(pp_uint32)mem[i];		
+		mem = new pp_uint8[src.dataLen];
+		memcpy(mem, src.data, src.dataLen);
 	}
+	setData(mem, mem ? src.dataLen : 0, src.compressed);
 }
 
 SampleUndoStackEntry::SampleUndoStackEntry(const TXMSample& sample, 
 										   pp_int32 selectionStart, pp_int32 selectionEnd, 
-										   const UserData* userData/* = NULL*/) :
+										   const UserData* userData/* = NULL*/,
+										   pp_uint32 prefixLen/* = 0*/,
+										   pp_uint32 suffixLen/* = 0*/) :
 	UndoStackEntry(userData)
 {
+	init();
+
 	samplen = sample.samplen;
 	loopstart = sample.loopstart;
 	looplen = sample.looplen;
@@ -258,64 +459,41 @@ SampleUndoStackEntry::SampleUndoStackEntry(const TXMSample& sample,
 	this->selectionStart = selectionStart;
 	this->selectionEnd = selectionEnd;
 	
-	buffer = NULL;
-
-	checkSum = 0;
-	
 	if (sample.samplen && sample.sample)
 	{
-		// 16 bit sample
-		if (flags & 16)
-		{
-			buffer = TXMSample::allocPaddedMem(samplen*2);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, sample.sample, samplen*2);				
-		}
-		else
+		dataPresent = true;
+		
+		pp_uint32 size = getSize();
+		if (prefixLen > size)
+			prefixLen = size;
+		if (suffixLen > size - prefixLen)
+			suffixLen = size - prefixLen;
+		
+		this->prefixLen = prefixLen;
+		this->suffixLen = suffixLen;
+		
+		checkSum = calcCheckSum((const pp_uint8*)sample.sample, size);
+		
+		pp_uint32 len = size - prefixLen - suffixLen;
+		if (len)
 		{
-			buffer = TXMSample::allocPaddedMem(samplen);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, sample.sample, samplen);
+			pp_uint8* mem = new pp_uint8[len];
+			memcpy(mem, (const pp_uint8*)sample.sample + prefixLen, len);
+			setData(mem, len, false);
 		}
-		calcCheckSum();
 	}
 }
 
 SampleUndoStackEntry::SampleUndoStackEntry(const SampleUndoStackEntry& src)	:
 	UndoStackEntry(&src.getUserData())
 {
-	samplen = src.samplen;
-	loopstart = src.loopstart;
-	looplen = src.looplen;	
-	relnote = src.relnote;
-	finetune = src.finetune;
-	flags = src.flags;
-	checkSum = src.checkSum;
-	this->selectionStart = src.selectionStart;
-	this->selectionEnd = src.selectionEnd;
-	
-	buffer = NULL;
-	if (src.buffer && samplen)
-	{	
-		// 16 bit sample
-		if (flags & 16)
-		{			
-			buffer = TXMSample::allocPaddedMem(samplen*2);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, src.buffer, samplen*2);
-		}
-		else
-		{
-			buffer = TXMSample::allocPaddedMem(samplen);
-			if (buffer)
-				TXMSample::copyPaddedMem(buffer, src.buffer, samplen);
-		}	
-	}
+	init();
+	copy(src);
 }
 
 SampleUndoStackEntry::~SampleUndoStackEntry()
 {
-	TXMSample::freePaddedMem(buffer);
+	setData(NULL, 0, false);
 }
 
 // assignment operator
@@ -324,37 +502,7 @@ SampleUndoStackEntry& SampleUndoStackEntry::operator=(const SampleUndoStackEntry
 	if (this != &src)
 	{
 		copyBasePart(src);
-	
-		samplen = src.samplen;
-		loopstart = src.loopstart;
-		looplen = src.looplen;	
-		relnote = src.relnote;
-		finetune = src.finetune;
-		flags = src.flags;
-		checkSum = src.checkSum;
-		
-		if (buffer)
-		{
-			TXMSample::freePaddedMem(buffer);
-			buffer = NULL;
-		}
-		
-		if (src.buffer && samplen)
-		{	
-			// 16 bit sample
-			if (flags & 16)
-			{
-				buffer = TXMSample::allocPaddedMem(samplen*2);
-				if (buffer)
-					TXMSample::copyPaddedMem(buffer, src.buffer, samplen*2);
-			}
-			else
-			{
-				buffer = TXMSample::allocPaddedMem(samplen);
-				if (buffer)
-					TXMSample::copyPaddedMem(buffer, src.buffer, samplen);
-			}	
-		}
+		copy(src);
 	}
 
 	return (*this);
@@ -384,30 +532,175 @@ bool SampleUndoStackEntry::operator==(const SampleUndoStackEntry& src)
 	if (flags != src.flags)
 		return false;
 	
-	if (buffer == NULL && src.buffer != NULL)
+	if (dataPresent != src.dataPresent)
 		return false;
 
-	if (buffer != NULL && src.buffer == NULL)
-		return false;
+	return true;
+}
+
+bool SampleUndoStackEntry::operator!=(const SampleUndoStackEntry& source)
+{
+	return !(*this==source);
+}
+
+const pp_uint8* SampleUndoStackEntry::getBuffer() const
+{
+	return (isComplete() && !compressed) ? data : NULL;
+}
+
+void SampleUndoStackEntry::trim(pp_uint32 prefixLen, pp_uint32 suffixLen)
+{
+	ASSERT(!compressed);
+	if (!dataPresent || compressed)
+		return;
+		
+	pp_uint32 size = getSize();
+	if (prefixLen > size)
+		prefixLen = size;
+	if (suffixLen > size - prefixLen)
+		suffixLen = size - prefixLen;
+
+	// can only drop data
+	if (prefixLen < this->prefixLen || suffixLen < this->suffixLen)
+		return;
 	
-	mp_uint32 size = (flags & 16) ? samplen*2 : samplen;
-	if (size)
+	pp_uint32 len = size - prefixLen - suffixLen;
+	pp_uint8* mem = NULL;
+	if (len)
 	{
-		mp_ubyte* _src = src.buffer;
-		mp_ubyte* _dst = buffer;
-
-		mp_ubyte* srcmem = TXMSample::getPadStartAddr(_src);
-		mp_ubyte* dstmem = TXMSample::getPadStartAddr(_dst);
-		mp_uint32 realSize = TXMSample::getPaddedSize(size);
-		for (pp_uint32 i = 0; i < realSize; i++)
-			if (srcmem[i] != dstmem[i])
-				return false;
+		mem = new pp_uint8[len];
+		memcpy(mem, data + (prefixLen - this->prefixLen), len);
 	}
+	setData(mem, len, false);
+	
+	this->prefixLen = prefixLen;
+	this->suffixLen = suffixLen;
+}
 
+bool SampleUndoStackEntry::canRestoreFrom(pp_uint32 checkSum, pp_uint32 size) const
+{
+	if (isComplete())
+		return true;
+	
+	if (prefixLen + suffixLen > size)
+		return false;
+		
+	return (prevCheckSumValid && checkSum == prevCheckSum) ||
+		(nextCheckSumValid && checkSum == nextCheckSum);
+}
+
+bool SampleUndoStackEntry::restoreData(pp_uint8* dst, const pp_uint8* src, pp_uint32 srcSize) const
+{
+	if (!dataPresent || dst == NULL)
+		return false;
+		
+	if (prefixLen + suffixLen > srcSize)
+		return false;
+	
+	pp_uint32 size = getSize();
+	
+	if (prefixLen)
+		memcpy(dst, src, prefixLen);
+	if (suffixLen)
+		memcpy(dst + size - suffixLen, src + srcSize - suffixLen, suffixLen);
+	
+	pp_uint32 len = size - prefixLen - suffixLen;
+	if (len)
+	{
+		if (compressed)
+			return unpack(dst + prefixLen);
+			
+		memcpy(dst + prefixLen, data, len);
+	}
+	
 	return true;
 }
 
-bool SampleUndoStackEntry::operator!=(const SampleUndoStackEntry& source)
+#ifdef HAVE_ZLIB
+// sample deltas compress a lot better than the sample data itself
+static void deltaEncode(pp_uint8* data, pp_uint32 len, bool is16Bit)
 {
-	return !(*this==source);
+	if (is16Bit)
+	{
+		mp_uword* ptr = (mp_uword*)data;
+		mp_uword last = 0;
+		for (pp_uint32 i = 0; i < (len >> 1); i++)
+		{
+			mp_uword cur = ptr[i];
+			ptr[i] = cur - last;
+			last = cur;
+		}
+	}
+	else
+	{
+		pp_uint8 last = 0;
+		for (pp_uint32 i = 0; i < len; i++)
+		{
+			pp_uint8 cur = data[i];
+			data[i] = cur - last;
+			last = cur;
+		}
+	}
+}
+
+static void deltaDecode(pp_uint8* data, pp_uint32 len, bool is16Bit)
+{
+	if (is16Bit)
+	{
+		mp_uword* ptr = (mp_uword*)data;
+		mp_uword last = 0;
+		for (pp_uint32 i = 0; i < (len >> 1); i++)
+			last = ptr[i] = ptr[i] + last;
+	}
+	else
+	{
+		pp_uint8 last = 0;
+		for (pp_uint32 i = 0; i < len; i++)
+			last = data[i] = data[i] + last;
+	}
+}
+#endif
+
+void SampleUndoStackEntry::pack()
+{
+#ifdef HAVE_ZLIB
+	if (compressed || dataLen < UNDOCOMPRESS_SAMPLEEDITOR)
+		return;
+		
+	bool is16Bit = (flags & 16) != 0;
+		
+	pp_uint8* delta = new pp_uint8[dataLen];
+	memcpy(delta, data, dataLen);
+	deltaEncode(delta, dataLen, is16Bit);
+	
+	uLongf packedLen = compressBound(dataLen);
+	pp_uint8* packed = new pp_uint8[packedLen];
+	
+	// only worth it if it saves a bit of memory
+	if (compress2(packed, &packedLen, delta, dataLen, Z_BEST_SPEED) == Z_OK &&
+		packedLen < dataLen - (dataLen >> 3))
+	{
+		pp_uint8* mem = new pp_uint8[packedLen];
+		memcpy(mem, packed, packedLen);
+		setData(mem, (pp_uint32)packedLen, true);
+	}
+	
+	delete[] packed;
+	delete[] delta;
+#endif
+}
+
+bool SampleUndoStackEntry::unpack(pp_uint8* dst) const
+{
+#ifdef HAVE_ZLIB
+	pp_uint32 len = getSize() - prefixLen - suffixLen;
+	uLongf unpackedLen = len;
+	if (::uncompress(dst, &unpackedLen, data, dataLen) != Z_OK || unpackedLen != len)
+		return false;
+
+	deltaDecode(dst, len, (flags & 16) != 0);
+	return true;
+#else
+	return false;
+#endif
 }
@@ -35,6 +35,10 @@
 
 #define UNDODEPTH_SAMPLEEDITOR			16
 #define UNDOHISTORYSIZE_SAMPLEEDITOR	4
+// memory all sample undo entries may use together, oldest history is dropped first
+#define UNDOBUDGET_SAMPLEEDITOR			(64*1024*1024)
+// sample undo data larger than this is compressed (if zlib is available)
+#define UNDOCOMPRESS_SAMPLEEDITOR		(64*1024)
 
 //--- This is what we save --------------------------------------------------
 class UndoStackEntry
@@ -126,25 +130,63 @@ public:
 class PatternUndoStackEntry : public UndoStackEntry
 {
 public:
-	// Construction (new element)
+	// Rectangle of pattern cells (inclusive)
+	struct CellRange
+	{
+		pp_int32 startChannel;
+		pp_int32 startRow;
+		pp_int32 endChannel;
+		pp_int32 endRow;
+		
+		void include(const CellRange& range);
+	};
+
+	// Construction (new element), without range the whole pattern is stored,
+	// the checksum of the pattern is calculated unless it's passed in
 	PatternUndoStackEntry(const TXMPattern& pattern, 
 						  const pp_int32 cursorPositionChannel, 
 						  const pp_int32 cursorPositionRow, 
 						  const pp_int32 cursorPositionInner,
-						  const UserData* userData = NULL);
+						  const UserData* userData = NULL,
+						  const CellRange* range = NULL,
+						  const pp_uint32* checkSum = NULL);
 	// Copy ctor
 	PatternUndoStackEntry(const PatternUndoStackEntry& source);
 
 	// dtor
 	virtual ~PatternUndoStackEntry();
 
-	// get your pattern
-	const TXMPattern& GetPattern() const { return pattern; }
+	// dimensions of the pattern this entry was taken from
+	pp_int32 getNumRows() const { return rows; }
+	pp_int32 getNumChannels() const { return channum; }
+	pp_int32 getNumEffects() const { return effnum; }
+	
+	const CellRange& getRange() const { return range; }
+	bool isComplete() const;
 
 	pp_int32 getCursorPositionChannel() const { return cursorPositionChannel; }
 	pp_int32 getCursorPositionRow() const { return cursorPositionRow; }
 	pp_int32 getCursorPositionInner() const { return cursorPositionInner; }
 
+	// write stored cells back, pattern must have the same dimensions
+	void restore(TXMPattern& pattern) const;
+
+	// checksums of this state and the neighbouring states on the undo stack
+	pp_uint32 getCheckSum() const { return checkSum; }
+	
+	pp_uint32 getPrevCheckSum() const { return prevCheckSum; }
+	bool hasPrevCheckSum() const { return prevCheckSumValid; }
+	void setPrevCheckSum(pp_uint32 checkSum) { prevCheckSum = checkSum; prevCheckSumValid = true; }
+	
+	void setNextCheckSum(pp_uint32 checkSum) { nextCheckSum = checkSum; nextCheckSumValid = true; }
+	
+	// can the cells be written on top of a pattern with the given checksum?
+	bool canRestoreFrom(pp_uint32 checkSum) const;
+	
+	// checksum of the cells in range (default: all cells), the checksums 
+	// of separate ranges of the same pattern can be combined with xor
+	static pp_uint32 calcCheckSum(const TXMPattern& pattern, const CellRange* range = NULL);
+
 	// assignment operator
 	PatternUndoStackEntry& operator=(const PatternUndoStackEntry& source);
 	
@@ -154,11 +196,24 @@ public:
 
 
 private:	
-	TXMPattern pattern;
+	pp_int32 rows;
+	pp_int32 channum;
+	pp_int32 effnum;
+
+	CellRange range;
+	
+	mp_ubyte* cells;
+	pp_uint32 cellsLen;
+	
+	pp_uint32 checkSum;
+	pp_uint32 prevCheckSum, nextCheckSum;
+	bool prevCheckSumValid, nextCheckSumValid;
 	
 	pp_int32 cursorPositionChannel;
 	pp_int32 cursorPositionRow;
 	pp_int32 cursorPositionInner;
+	
+	void copy(const PatternUndoStackEntry& source);
 };
 
 // Less memory consumption than TEnvelope because XMs can only handle 12 envelope points
@@ -224,18 +279,26 @@ private:
 struct TXMSample;
 
 // Undo information from Sample Editor
+// Only the part of the sample data which differs from the neighbouring
+// states on the undo stack is stored, the rest is taken from the current
+// sample when the entry is restored. Sample data is always compared in its
+// original state (without the loop double buffering applied).
 class SampleUndoStackEntry : public UndoStackEntry
 {
 public:
 	SampleUndoStackEntry() : 
 		UndoStackEntry(NULL)
 	{
+		init();
 	}
 
+	// Store sample data without the given number of bytes at the start and the end
 	SampleUndoStackEntry(const TXMSample& sample, 
 						 pp_int32 selectionStart, 
 						 pp_int32 selectionEnd, 
-						 const UserData* userData = NULL);
+						 const UserData* userData = NULL,
+						 pp_uint32 prefixLen = 0,
+						 pp_uint32 suffixLen = 0);
 						 
 	SampleUndoStackEntry(const SampleUndoStackEntry& src);
 						 
@@ -255,25 +318,76 @@ public:
 	mp_sbyte getRelNote() const { return relnote; }
 	mp_sbyte getFineTune() const { return finetune; }
 	
-	const pp_uint8* getBuffer() const { return buffer; }
-	
 	pp_int32 getSelectionStart() const { return selectionStart; }
 	pp_int32 getSelectionEnd() const { return selectionEnd; }
 	
+	// sample data of this state (in bytes)
+	bool hasData() const { return dataPresent; }
+	pp_uint32 getSize() const { return (flags & 16) ? samplen*2 : samplen; }
+	
+	// stored range of the sample data
+	pp_uint32 getPrefixLen() const { return prefixLen; }
+	pp_uint32 getSuffixLen() const { return suffixLen; }
+	bool isComplete() const { return prefixLen == 0 && suffixLen == 0; }
+	
+	// uncompressed data of a complete entry, NULL otherwise
+	const pp_uint8* getBuffer() const;
+	
+	// drop stored data outside [prefixLen, getSize()-suffixLen)
+	void trim(pp_uint32 prefixLen, pp_uint32 suffixLen);
+	
+	// compress stored data if it's large, no more trimming afterwards
+	void pack();
+	
+	// checksums of this state and the neighbouring states on the undo stack
+	pp_uint32 getCheckSum() const { return checkSum; }
+	
+	pp_uint32 getPrevCheckSum() const { return prevCheckSum; }
+	bool hasPrevCheckSum() const { return prevCheckSumValid; }
+	void setPrevCheckSum(pp_uint32 checkSum) { prevCheckSum = checkSum; prevCheckSumValid = true; }
+	
+	void setNextCheckSum(pp_uint32 checkSum) { nextCheckSum = checkSum; nextCheckSumValid = true; }
+	
+	// can the entry be restored on top of sample data with the given checksum and size?
+	bool canRestoreFrom(pp_uint32 checkSum, pp_uint32 size) const;
+	
+	// build the sample data of this state in dst, the range which is not
+	// stored in the entry is taken from src (which has srcSize bytes)
+	bool restoreData(pp_uint8* dst, const pp_uint8* src, pp_uint32 srcSize) const;
+	
+	// memory used by the entry and all sample undo entries together
+	pp_uint32 getMemoryUsage() const { return dataLen; }
+	static pp_uint32 getTotalMemoryUsage() { return totalMemoryUsage; }
+	
+	static pp_uint32 calcCheckSum(const pp_uint8* data, pp_uint32 size);
+	
 private:
 	// from sample
 	pp_uint32 samplen, loopstart, looplen;
 	mp_sbyte relnote, finetune;
-	pp_uint8* buffer;
 	pp_uint8 flags;
+	bool dataPresent;
 
 	// from sample editor
 	pp_int32 selectionStart;
 	pp_int32 selectionEnd;
 
-	pp_int32 checkSum;
+	// stored part of the sample data
+	pp_uint8* data;
+	pp_uint32 dataLen;
+	pp_uint32 prefixLen, suffixLen;
+	bool compressed;
+
+	pp_uint32 checkSum;
+	pp_uint32 prevCheckSum, nextCheckSum;
+	bool prevCheckSumValid, nextCheckSumValid;
+	
+	static pp_uint32 totalMemoryUsage;
 	
-	void calcCheckSum();
+	void init();
+	void copy(const SampleUndoStackEntry& src);
+	void setData(pp_uint8* data, pp_uint32 dataLen, bool compressed);
+	bool unpack(pp_uint8* dst) const;
 };
 
 // undo history maintainance
@@ -371,6 +485,25 @@ public:
 			
 		return NULL;
 	}
+	
+	// drop the undo stack which has been stored in the history first
+	bool removeOldest()
+	{
+		if (patternHistoryNumEntries == 0)
+			return false;
+		
+		if (patternHistory[0].undoStack != currentUndoStack)
+			delete patternHistory[0].undoStack;
+		
+		for (pp_int32 i = 0; i < patternHistoryNumEntries-1; i++)
+			patternHistory[i] = patternHistory[i+1];
+		
+		patternHistory[patternHistoryNumEntries-1].key = NULL;
+		patternHistory[patternHistoryNumEntries-1].undoStack = NULL;
+		
+		patternHistoryNumEntries--;
+		return true;
+	}
 };
 
 #endif
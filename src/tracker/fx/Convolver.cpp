@@ -1,5 +1,7 @@
 #include "Convolver.h"
+#include "FFT.h"
 #include "VRand.h"
+#include <string.h>
 
 /* Print a vector of complexes as ordered pairs. */
 void Convolver::print_vector(const char* title, complex* x, int n)
@@ -21,84 +23,93 @@ complex Convolver::complex_mult(complex a, complex b)
 	return c;
 }
 
-/*
-  Convolver::fft(v,N):
-   [0] If N==1 then return.
-   [1] For k = 0 to N/2-1, let ve[k] = v[2*k]
-   [2] ComputeConvolver::fft(ve, N/2);
-   [3] For k = 0 to N/2-1, let vo[k] = v[2*k+1]
-   [4] ComputeConvolver::fft(vo, N/2);
-   [5] For m = 0 to N/2-1, do [6] through [9]
-   [6]   Let w.re = cos(2*PI*m/N)
-   [7]   Let w.im = -sin(2*PI*m/N)
-   [8]   Let v[m] = ve[m] + w*vo[m]
-   [9]   Let v[m+N/2] = ve[m] - w*vo[m]
- */
-
-void Convolver::fft(complex* v, int n, complex* tmp)
+bool Convolver::reportProgress(Convolver::FX *fx, int pos, int len)
 {
-	if (n > 1) {			/* otherwise, do nothing and return */
-		int k, m;
-		complex z, w, * vo, * ve;
-		ve = tmp;
-		vo = tmp + n / 2;
-		for (k = 0; k < n / 2; k++) {
-			ve[k] = v[2 * k];
-			vo[k] = v[2 * k + 1];
-		}
-	Convolver::fft(ve, n / 2, v);		/* FFT on even-indexed elements of v[] */
-	Convolver::fft(vo, n / 2, v);		/* FFT on odd-indexed elements of v[] */
-		for (m = 0; m < n / 2; m++) {
-			w.Re = cos(2 * PI * m / (double)n);
-			w.Im = -sin(2 * PI * m / (double)n);
-			z.Re = w.Re * vo[m].Re - w.Im * vo[m].Im;	/* Re(w*vo[m]) */
-			z.Im = w.Re * vo[m].Im + w.Im * vo[m].Re;	/* Im(w*vo[m]) */
-			v[m].Re = ve[m].Re + z.Re;
-			v[m].Im = ve[m].Im + z.Im;
-			v[m + n / 2].Re = ve[m].Re - z.Re;
-			v[m + n / 2].Im = ve[m].Im - z.Im;
-		}
-	}
-	return;
+	return fx->progress == NULL || fx->progress(fx->progressUser, pos, len);
 }
 
-/*
-   Convolver::ifft(v,N):
-   [0] If N == 1 then return.
-   [1] For k = 0 to N/2-1, let ve[k] = v[2*k]
-   [2] Compute Convolver::ifft(ve, N/2);
-   [3] For k = 0 to N/2-1, let vo[k] = v[2*k+1]
-   [4] Compute Convolver::ifft(vo, N/2);
-   [5] For m = 0 to N/2-1, do [6] through [9]
-   [6]   Let w.re = cos(2*PI*m/N)
-   [7]   Let w.im = sin(2*PI*m/N)
-   [8]   Let v[m] = ve[m] + w*vo[m]
-   [9]   Let v[m+N/2] = ve[m] - w*vo[m]
- */
-void Convolver::ifft(complex* v, int n, complex* tmp)
+/* Uniformly partitioned overlap-add: h is cut into blocks of B samples,
+ * each input block of B samples is transformed once (zero padded to 2B)
+ * and multiplied with the spectra of all h blocks, output block j
+ * collects X[j-p]*H[p]. Since h is real, the first and second half of x
+ * are run through the same transforms as real and imaginary part.
+ * Mixing in the dry signal by (1-intensity) is the same as adding a dirac
+ * to h. y has to hold lenX+lenH-1 zeroed samples. Returns false when
+ * cancelled through the progress callback of fx */
+bool Convolver::convolvePartitioned(float* x, float* h, int lenX, int lenH, float intensity, float* y, Convolver::FX *fx)
 {
-	if (n > 1) {			/* otherwise, do nothing and return */
-		int k, m;
-		complex z, w, * vo, * ve;
-		ve = tmp; vo = tmp + n / 2;
-		for (k = 0; k < n / 2; k++) {
-			ve[k] = v[2 * k];
-			vo[k] = v[2 * k + 1];
+	int lenY = lenX + lenH - 1;
+	int half = (lenX + 1) / 2;
+	int lenZ = half + lenH - 1;
+	int B = 1024;
+	while (B < lenH && B < 65536) B *= 2;
+	int N = 2 * B;
+	int P = (lenH + B - 1) / B;
+	int numIn = (half + B - 1) / B;
+	int numOut = (lenZ + B - 1) / B;
+	int i, j, p;
+	bool done = true;
+
+	FFT fft(N);
+	complex* H = (complex*)calloc((size_t)P * N, sizeof(complex));
+	complex* X = (complex*)calloc((size_t)P * N, sizeof(complex));
+	complex* acc = (complex*)calloc(N, sizeof(complex));
+	if (H == NULL || X == NULL || acc == NULL) {
+		printf("Error: unable to allocate memory for convolution. Exiting.\n");
+		exit(1);
+	}
+
+	for (p = 0; p < P; p++) {
+		complex* Hp = H + (size_t)p * N;
+		for (i = 0; i < B && p * B + i < lenH; i++)
+			Hp[i].Re = intensity * h[p * B + i];
+		if (p == 0)
+			Hp[0].Re += 1.0f - intensity;
+		fft.forward(Hp, N);
+	}
+
+	for (j = 0; j < numOut; j++) {
+		if (!Convolver::reportProgress(fx, j, numOut)) {
+			done = false;
+			break;
 		}
-		Convolver::ifft(ve, n / 2, v);		/* FFT on even-indexed elements of v[] */
-		Convolver::ifft(vo, n / 2, v);		/* FFT on odd-indexed elements of v[] */
-		for (m = 0; m < n / 2; m++) {
-			w.Re = cos(2 * PI * m / (double)n);
-			w.Im = sin(2 * PI * m / (double)n);
-			z.Re = w.Re * vo[m].Re - w.Im * vo[m].Im;	/* Re(w*vo[m]) */
-			z.Im = w.Re * vo[m].Im + w.Im * vo[m].Re;	/* Im(w*vo[m]) */
-			v[m].Re = ve[m].Re + z.Re;
-			v[m].Im = ve[m].Im + z.Im;
-			v[m + n / 2].Re = ve[m].Re - z.Re;
-			v[m + n / 2].Im = ve[m].Im - z.Im;
+
+		/* X keeps the spectra of the last P input blocks */
+		complex* Xj = X + (size_t)(j % P) * N;
+		if (j < numIn) {
+			memset(Xj, 0, N * sizeof(complex));
+			for (i = 0; i < B && j * B + i < half; i++) {
+				int n = j * B + i;
+				Xj[i].Re = x[n];
+				Xj[i].Im = n + half < lenX ? x[n + half] : 0.0f;
+			}
+			fft.forward(Xj, N);
+		}
+
+		memset(acc, 0, N * sizeof(complex));
+		for (p = 0; p < P && p <= j; p++) {
+			if (j - p >= numIn) continue;
+			const complex* Xp = X + (size_t)((j - p) % P) * N;
+			const complex* Hp = H + (size_t)p * N;
+			for (i = 0; i < N; i++) {
+				acc[i].Re += Xp[i].Re * Hp[i].Re - Xp[i].Im * Hp[i].Im;
+				acc[i].Im += Xp[i].Re * Hp[i].Im + Xp[i].Im * Hp[i].Re;
+			}
+		}
+		fft.inverse(acc, N);
+
+		for (i = 0; i < N && j * B + i < lenZ; i++) {
+			int n = j * B + i;
+			y[n] += acc[i].Re;
+			if (n + half < lenY)
+				y[n + half] += acc[i].Im;
 		}
 	}
-	return;
+
+	free(acc);
+	free(X);
+	free(H);
+	return done;
 }
 
 /* Convolve signal x with impulse response h.  The return value is
@@ -107,42 +118,17 @@ int Convolver::convolve(float* x, float* h, int lenX, int lenH, float** output,
 {
 	complex* xComp = NULL;
 	complex* hComp = NULL;
-	complex* scratch = NULL;
 	complex* yComp = NULL;
 	complex c;
 
 	int lenY = lenX + lenH - 1;
-	int currPow = 0;
-	int lenY2 = pow(2, currPow);
+	int lenY2 = 1;
 	float m = 0;
 	int i;
 
 	/* Get first first power of two larger than lenY */
 	while (lenY2 < lenY) {
-		currPow++;
-		lenY2 = pow(2, currPow);
-	}
-
-	/* Allocate a lot of memory */
-	scratch = (complex *)calloc(lenY2, sizeof(complex));
-	if (scratch == NULL) {
-		printf("Error: unable to allocate memory for convolution. Exiting.\n");
-		exit(1);
-	}
-	xComp = (complex *)calloc(lenY2, sizeof(complex));
-	if (xComp == NULL) {
-		printf("Error: unable to allocate memory for convolution. Exiting.\n");
-		exit(1);
-	}
-	hComp = (complex*)calloc(lenY2, sizeof(complex));
-	if (hComp == NULL) {
-		printf("Error: unable to allocate memory for convolution. Exiting.\n");
-		exit(1);
-	}
-	yComp = (complex*)calloc(lenY2, sizeof(complex));
-	if (yComp == NULL) {
-		printf("Error: unable to allocate memory for convolution. Exiting.\n");
-		exit(1);
+		lenY2 *= 2;
 	}
 
 	/* Get max absolute value in X */
@@ -152,14 +138,6 @@ int Convolver::convolve(float* x, float* h, int lenX, int lenH, float** output,
 		}
 	}
 
-	/* Copy over real values */
-	for (i = 0; i < lenX; i++) {
-		xComp[i].Re = x[i];
-	}
-	for (i = 0; i < lenH; i++) {
-		hComp[i].Re = h[i];
-	}
-
 	int windowsize = (int)( float(lenY2/100) * fx->windowsize);
 	// clamp to power of 2
 	int pow2 = 1;
@@ -167,97 +145,121 @@ int Convolver::convolve(float* x, float* h, int lenX, int lenH, float** output,
 	if (pow2 > windowsize * 2) pow2 /= 2;
 	windowsize = pow2;
 
-	/* FFT of x */
-	//  Convolver::print_vector("Orig", xComp, 40);
-	Convolver::fft(xComp, lenY2, scratch);
-	//  Convolver::print_vector(" FFT", xComp, windowsize);
-
-	/* FFT of h */
-	//  Convolver::print_vector("Orig", hComp, 50);
-	Convolver::fft(hComp, windowsize, scratch);
-	//  Convolver::print_vector(" FFT", hComp, windowsize);
-	//
-	/* convolve! Multiply ffts of x and h */
+	float intensity = 0.0f;
 	if (fx->convolve > 0.0f) {
-		float intensity = fx->convolve / 100.0f; // scale intensity to 0.0-1.0 range
+		intensity = fx->convolve / 100.0f; // scale intensity to 0.0-1.0 range
 		if( intensity > 0.4 ) intensity = 1.0;
+	}
+
+	*output = (float *)calloc(lenY, sizeof(float));
+	if (*output == NULL) {
+		printf("Error: unable to allocate memory for convolution. Exiting.\n");
+		exit(1);
+	}
+	float* y = *output;
+	bool done = true;
+
+	/* without spectral effects this is a plain linear convolution */
+	if (windowsize == lenY2 && fx->rotation == 0.0f && fx->contrast == 0.0f && fx->randomphase == 0.0f) {
+		done = Convolver::convolvePartitioned(x, h, lenX, lenH, intensity, y, fx);
+	} else {
+		/* Allocate a lot of memory */
+		xComp = (complex *)calloc(lenY2, sizeof(complex));
+		if (xComp == NULL) {
+			printf("Error: unable to allocate memory for convolution. Exiting.\n");
+			exit(1);
+		}
+		hComp = (complex*)calloc(lenY2, sizeof(complex));
+		if (hComp == NULL) {
+			printf("Error: unable to allocate memory for convolution. Exiting.\n");
+			exit(1);
+		}
+		yComp = (complex*)calloc(lenY2, sizeof(complex));
+		if (yComp == NULL) {
+			printf("Error: unable to allocate memory for convolution. Exiting.\n");
+			exit(1);
+		}
+
+		/* Copy over real values */
+		for (i = 0; i < lenX; i++) {
+			xComp[i].Re = x[i];
+		}
+		for (i = 0; i < lenH; i++) {
+			hComp[i].Re = h[i];
+		}
+
+		FFT fft(lenY2);
+
+		/* FFT of x */
+		fft.forward(xComp, lenY2);
+
+		/* FFT of h */
+		fft.forward(hComp, windowsize);
+
+		done = Convolver::reportProgress(fx, 1, 2);
+
+		/* convolve! Multiply ffts of x and h */
 		for (i = 0; i < windowsize; i++) {
 			c = Convolver::complex_mult(xComp[i], hComp[i]);
 			yComp[i].Re = (1.0f - intensity) * xComp[i].Re + intensity * c.Re;
 			yComp[i].Im = (1.0f - intensity) * xComp[i].Im + intensity * c.Im;
 		}
-	} else {
-		// if convolve is 0.0, just copy xComp to yComp
-		for (i = 0; i < windowsize; i++) {
-			yComp[i].Re = xComp[i].Re;
-			yComp[i].Im = xComp[i].Im;
-		}
-	}		
-	//  Convolver::print_vector("Y", yComp, windowsize);
-	//
-	if( fx->rotation != 0.0f ){
-		for (i = 0; i < windowsize; i++) {
-			float angle = atan2(xComp[i].Im, xComp[i].Re);
-			angle += fx->rotation / 100.0f;
-			yComp[i].Re = sqrt(yComp[i].Re * yComp[i].Re + yComp[i].Im * yComp[i].Im) * cos(angle);
-			yComp[i].Im = sqrt(yComp[i].Re * yComp[i].Re + yComp[i].Im * yComp[i].Im) * sin(angle);
+
+		if( fx->rotation != 0.0f ){
+			for (i = 0; i < windowsize; i++) {
+				float angle = complex_arg(xComp[i]) + fx->rotation / 100.0f;
+				yComp[i] = complex_polar(complex_abs(yComp[i]), angle);
+			}
 		}
-	}
 
+		/* Apply contrast-like effect */
+		if( fx->contrast != 0.0f  ){
+			for (i = 0; i < windowsize; i++) {
+				float newMagnitude = pow(complex_abs(yComp[i]), (fx->contrast/100.0f) + 1.0f);
+				yComp[i] = complex_polar(newMagnitude, complex_arg(yComp[i]));
+			}
+		}
 
-	/* Apply contrast-like effect */
-	if( fx->contrast != 0.0f  ){
-		for (i = 0; i < windowsize; i++) {
-			float magnitude = sqrt(yComp[i].Re * yComp[i].Re + yComp[i].Im * yComp[i].Im);
-			float newMagnitude = pow(magnitude, (fx->contrast/100.0f) + 1.0f);
-			float angle = atan2(yComp[i].Im, yComp[i].Re);
-			yComp[i].Re = newMagnitude * cos(angle);
-			yComp[i].Im = newMagnitude * sin(angle);
+		if( fx->randomphase != 0.0f ){
+			for (i = 0; i < windowsize; i++) {
+				float randomAngle = (float)rand() / RAND_MAX * 2 * PI * (fx->randomphase/100.0f);
+				yComp[i] = complex_polar(complex_abs(yComp[i]), complex_arg(yComp[i]) + randomAngle);
+			}
 		}
-	}
 
-	if( fx->randomphase != 0.0f ){
-		for (i = 0; i < windowsize; i++) {
-			float randomAngle = (float)rand() / RAND_MAX * 2 * PI * (fx->randomphase/100.0f);
-			float magnitude = sqrt(yComp[i].Re * yComp[i].Re + yComp[i].Im * yComp[i].Im);
-			float angle = atan2(yComp[i].Im, yComp[i].Re) + randomAngle;
-			yComp[i].Re = magnitude * cos(angle);
-			yComp[i].Im = magnitude * sin(angle);
+		/* Take the inverse FFT of Y */
+		if (done) {
+			fft.inverse(yComp, lenY2);
+
+			for (i = 0; i < lenY; i++) {
+				y[i] = yComp[i].Re;
+			}
 		}
+
+		free(xComp);
+		free(hComp);
+		free(yComp);
 	}
 
-	/* Take the inverse FFT of Y */
-	Convolver::ifft(yComp, lenY2, scratch);
-	//  Convolver::print_vector("iFFT", yComp, lenY2);    
+	/* a cancelled convolution is thrown away by the caller */
+	if (!done)
+		return lenY;
 
-	/* Take just the first N elements and find the largest value for scaling purposes */
+	/* Find the largest value for scaling purposes */
 	float maxY = 0;
 	for (i = 0; i < lenY; i++) {
-		if (fabsf(yComp[i].Re) > maxY) {
-			maxY = fabsf(yComp[i].Re);
+		if (fabsf(y[i]) > maxY) {
+			maxY = fabsf(y[i]);
 		}
 	}
 
 	/* Scale so that values are between 1 and -1 */
 	m = m / maxY;
 
-	free(scratch);
-	free(xComp);
-	free(hComp);
-
-	*output = (float *)calloc(lenY, sizeof(float));
-	if (output == NULL) {
-		printf("Error: unable to allocate memory for convolution. Exiting.\n");
-		exit(1);
-	}
-
 	for (i = 0; i < lenY; i++) {
-		yComp[i].Re = yComp[i].Re * m;
-		(*output)[i] = yComp[i].Re;
+		y[i] = y[i] * m;
 	}
-	//  Convolver::print_vector("Final", yComp, 400);
 
-	free(yComp);
 	return lenY;
 }
 
@@ -284,7 +286,7 @@ void Convolver::envelope_follow(float input, struct EnvelopeFollow* e) {
 	}
 }
 
-int Convolver::reverb( float *smpin, float **smpout, int frames, int size ){
+int Convolver::reverb( float *smpin, float **smpout, int frames, int size, Convolver::FX *fx ){
 	// create IR float array
 	float* impulseResponse;
 	impulseResponse = (float*)malloc(size * sizeof(float));
@@ -295,8 +297,8 @@ int Convolver::reverb( float *smpin, float **smpout, int frames, int size ){
       f = rand.white() * (1.0f - ((1.0f / (float)size) * (float)i));
       impulseResponse[i] = f;
 	}
-	Convolver::FX fx;
-	int length = reverb(smpin, smpout, frames, size, impulseResponse, &fx );
+	Convolver::FX defaults;
+	int length = reverb(smpin, smpout, frames, size, impulseResponse, fx ? fx : &defaults );
 	free(impulseResponse);
 	return length;
 }
@@ -26,11 +26,8 @@
  *
  * M. Farbood, August 5, 2011
  *
- * Function that convolves two signals.
- * Factored discrete Fourier transform, or FFT, and its inverse iFFT.
+ * Function that convolves two signals, the FFT is in FFT.h.
  *
- * fft and ifft are taken from code for the book,
- * Mathematics for Multimedia by Mladen Victor Wickerhauser
  * The function convolve is based on Stephen G. McGovern's fconv.m
  * Matlab implementation.
  *
@@ -76,17 +73,22 @@ public:
 		float rotation       = 0.0f;   //  0.0f...630.0f
 		float randomphase    = 0.0f;   //  0.0f...100.0f
 		float windowsize     = 100.0f; //  0.0f...100.0f
+		// called while busy, returning false stops the convolution
+		bool (*progress)(void* user, int pos, int len) = NULL;
+		void* progressUser   = NULL;
 	};
 
 	static void print_vector(const char* title, complex* x, int n);
 	static complex complex_mult(complex a, complex b);
-	static void fft(complex* v, int n, complex* tmp);
-	static void ifft(complex* v, int n, complex* tmp);
 	static int convolve(float* x, float* h, int lenX, int lenH, float** output, Convolver::FX *fx);
-	static int reverb( float *smpin, float **smpout, int frames, int size );
+	static int reverb( float *smpin, float **smpout, int frames, int size, Convolver::FX *fx = NULL );
 	static int reverb( float *smpin, float **smpout, int frames, int size, float *ir, Convolver::FX *fx);
 	static void envelope_follow(float input, struct EnvelopeFollow* e);
 
+private:
+	static bool reportProgress(Convolver::FX *fx, int pos, int len);
+	static bool convolvePartitioned(float* x, float* h, int lenX, int lenH, float intensity, float* y, Convolver::FX *fx);
+
 };
 
 #endif
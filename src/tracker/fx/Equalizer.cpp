@@ -67,3 +67,23 @@ void Equalizer::Filter(double xL, double xR, double &yL, double &yR)
 	yR2 = yR1;
 	yR1 = yR;
 }
+
+void Equalizer::ClearHistory()
+{
+	xL1 = xL2 = xR1 = xR2 = 0;
+	yL1 = yL2 = yR1 = yR2 = 0;
+}
+
+void Equalizer::AddHistory(const Equalizer& eq)
+{
+	xL1 += eq.xL1; xL2 += eq.xL2;
+	xR1 += eq.xR1; xR2 += eq.xR2;
+	yL1 += eq.yL1; yL2 += eq.yL2;
+	yR1 += eq.yR1; yR2 += eq.yR2;
+}
+
+bool Equalizer::IsSilent(double threshold) const
+{
+	return fabs(xL1) < threshold && fabs(xL2) < threshold && fabs(xR1) < threshold && fabs(xR2) < threshold &&
+		   fabs(yL1) < threshold && fabs(yL2) < threshold && fabs(yR1) < threshold && fabs(yR2) < threshold;
+}
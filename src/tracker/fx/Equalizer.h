@@ -33,6 +33,11 @@ public:
 	void CalcCoeffs(float centre, float width, float rate, float gain);
 	void Filter(double xL, double xR, double &yL, double &yR);
 
+	// filter history, the filter is linear so histories can be added
+	void ClearHistory();
+	void AddHistory(const Equalizer& eq);
+	bool IsSilent(double threshold) const;
+
 	// Calculate frequency from 20Hz to 20,000 Hz, a value of 0 to 1 should be passed (as is normally used in linear controls)
 	static float CalcFreq(float f) { return (float)(pow(1000.0f,f)*20); }
 
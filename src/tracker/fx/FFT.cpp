@@ -0,0 +1,118 @@
+/*
+ *  tracker/fx/FFT.cpp
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FFT.h"
+
+FFT::FFT(int size) :
+	size(size)
+{
+	/* stage of length len keeps its len/2 twiddles at len/2-1 */
+	twiddles = (complex*)calloc(size > 1 ? size - 1 : 1, sizeof(complex));
+	if (twiddles == NULL) {
+		printf("Error: unable to allocate memory for FFT. Exiting.\n");
+		exit(1);
+	}
+	if (size < 2) return;
+
+	/* only the last stage needs cos/sin, the others are every 2nd entry of the next one */
+	complex* w = twiddles + size / 2 - 1;
+	for (int k = 0; k < size / 2; k++) {
+		w[k].Re = (real)cos(2 * PI * k / (double)size);
+		w[k].Im = (real)-sin(2 * PI * k / (double)size);
+	}
+	for (int len = size / 2; len >= 2; len /= 2) {
+		complex* src = twiddles + len - 1;
+		complex* dst = twiddles + len / 2 - 1;
+		for (int k = 0; k < len / 2; k++)
+			dst[k] = src[2 * k];
+	}
+}
+
+FFT::~FFT()
+{
+	free(twiddles);
+}
+
+/*
+  In-place iterative FFT, n must be a power of two <= size:
+   [1] reorder v[] into bit reversed order
+   [2] do the first two stages as one radix-4 pass, their twiddles are 1 and -i
+   [3] do the remaining radix-2 stages with twiddles from the table
+  sign is -1 for the forward and 1 for the (unscaled) inverse transform
+ */
+void FFT::transform(complex* v, int n, real sign) const
+{
+	int i, j, k, len;
+	assert(n <= size && (n & (n - 1)) == 0);
+
+	/* a single value is its own transform */
+	if (n < 2)
+		return;
+
+	for (i = 1, j = 0; i < n; i++) {
+		int bit = n >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if (i < j) {
+			complex t = v[i]; v[i] = v[j]; v[j] = t;
+		}
+	}
+
+	if (n == 2) {
+		complex a = v[0], b = v[1];
+		v[0].Re = a.Re + b.Re; v[0].Im = a.Im + b.Im;
+		v[1].Re = a.Re - b.Re; v[1].Im = a.Im - b.Im;
+		return;
+	}
+
+	for (i = 0; i < n; i += 4) {
+		complex* q = v + i;
+		real t0r = q[0].Re + q[1].Re, t0i = q[0].Im + q[1].Im;
+		real t1r = q[0].Re - q[1].Re, t1i = q[0].Im - q[1].Im;
+		real t2r = q[2].Re + q[3].Re, t2i = q[2].Im + q[3].Im;
+		/* (q[2]-q[3]) rotated by -i (forward) or i (inverse) */
+		real t3r = -sign * (q[2].Im - q[3].Im), t3i = sign * (q[2].Re - q[3].Re);
+		q[0].Re = t0r + t2r; q[0].Im = t0i + t2i;
+		q[2].Re = t0r - t2r; q[2].Im = t0i - t2i;
+		q[1].Re = t1r + t3r; q[1].Im = t1i + t3i;
+		q[3].Re = t1r - t3r; q[3].Im = t1i - t3i;
+	}
+
+	for (len = 8; len <= n; len <<= 1) {
+		int half = len / 2;
+		const complex* w = twiddles + half - 1;
+		for (i = 0; i < n; i += len) {
+			complex* a = v + i;
+			complex* b = a + half;
+			for (k = 0; k < half; k++) {
+				real wr = w[k].Re, wi = -sign * w[k].Im;
+				real zr = wr * b[k].Re - wi * b[k].Im;
+				real zi = wr * b[k].Im + wi * b[k].Re;
+				b[k].Re = a[k].Re - zr;
+				b[k].Im = a[k].Im - zi;
+				a[k].Re += zr;
+				a[k].Im += zi;
+			}
+		}
+	}
+}
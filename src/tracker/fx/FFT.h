@@ -0,0 +1,79 @@
+/*
+ *  tracker/fx/FFT.h
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * FFT shared by the sample editor tools.
+ * Uses the complex type of the Convolver.
+ */
+
+#ifndef __FFT_H__
+#define __FFT_H__
+
+#include "Convolver.h"
+
+// In-place iterative FFT for any power of two size up to the one given
+// on construction, twiddles are computed once
+class FFT
+{
+private:
+	int size;
+	complex* twiddles;
+
+	void transform(complex* v, int n, real sign) const;
+
+public:
+	FFT(int size);
+	~FFT();
+
+	int getSize() const { return size; }
+
+	void forward(complex* v, int n) const { transform(v, n, -1.0f); }
+	// not scaled by 1/n
+	void inverse(complex* v, int n) const { transform(v, n, 1.0f); }
+};
+
+/* Polar form of a bin */
+static inline real complex_abs(complex a)
+{
+	return (real)sqrt(a.Re * a.Re + a.Im * a.Im);
+}
+
+static inline real complex_arg(complex a)
+{
+	return (real)atan2(a.Im, a.Re);
+}
+
+static inline complex complex_polar(real magnitude, real angle)
+{
+	complex c;
+	c.Re = magnitude * (real)cos(angle);
+	c.Im = magnitude * (real)sin(angle);
+	return c;
+}
+
+/* Wrap a phase into -PI..PI */
+static inline real wrap_phase(real phase)
+{
+	return (real)(phase - 2 * PI * floor(phase / (2 * PI) + 0.5));
+}
+
+#endif
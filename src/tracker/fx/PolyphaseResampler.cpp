@@ -0,0 +1,179 @@
+/*
+ *  tracker/fx/PolyphaseResampler.cpp
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "PolyphaseResampler.h"
+#include <math.h>
+
+#define NUMPHASES	256
+// downsampling widens the filter, this keeps extreme ratios affordable
+#define MAXTAPS		1024
+// input samples read per block on top of the filter length
+#define BLOCKSIZE	4096
+
+static const struct
+{
+	pp_int32 taps;		// filter length when not downsampling
+	double beta;		// Kaiser window shape, higher = more stopband attenuation
+	double rolloff;		// passband edge relative to the lower Nyquist frequency
+} presets[] =
+{
+	{ 16, 6.0, 0.90 },		// QualityFast
+	{ 48, 8.0, 0.94 },		// QualityGood
+	{ 128, 10.0, 0.97 }		// QualityBest
+};
+
+// zeroth order modified Bessel function of the first kind
+static double besselI0(double x)
+{
+	double sum = 1.0, term = 1.0;
+	for (pp_int32 k = 1; k < 64; k++)
+	{
+		term *= (x * 0.5) / k;
+		sum += term * term;
+		if (term * term < sum * 1e-14)
+			break;
+	}
+	return sum;
+}
+
+PolyphaseResampler::PolyphaseResampler(Source& source, pp_uint32 inputLength, float oldRate, float newRate, Qualities quality) :
+	source(source),
+	inputLength(inputLength),
+	numPhases(NUMPHASES),
+	windowStart(0),
+	outputPos(0)
+{
+	float factor = oldRate / newRate;
+	outputLength = inputLength ? (pp_uint32)ceil(inputLength/factor) : 0;
+	step = (double)oldRate / (double)newRate;
+
+	// when downsampling the cutoff moves down to the new Nyquist frequency
+	double ratio = newRate < oldRate ? (double)newRate / (double)oldRate : 1.0;
+	double cutoff = presets[quality].rolloff * ratio;
+
+	// multiple of 4 for the unrolled filter loop
+	numTaps = ((pp_int32)ceil(presets[quality].taps / ratio) + 3) & ~3;
+	if (numTaps > MAXTAPS)
+		numTaps = MAXTAPS;
+
+	// row p is the kernel for an output position p/numPhases past an input
+	// sample, tap j is applied to input sample j - (numTaps/2 - 1) from there
+	coeffs = new float[(numPhases + 1) * numTaps];
+
+	const double halfLength = numTaps * 0.5;
+	const double norm = 1.0 / besselI0(presets[quality].beta);
+	for (pp_int32 p = 0; p <= numPhases; p++)
+	{
+		float* row = coeffs + p * numTaps;
+		double sum = 0.0;
+		for (pp_int32 j = 0; j < numTaps; j++)
+		{
+			double t = (j - (numTaps/2 - 1)) - (double)p / numPhases;
+			double x = t / halfLength;
+			double w = x > -1.0 && x < 1.0 ? besselI0(presets[quality].beta * sqrt(1.0 - x*x)) * norm : 0.0;
+			double s = t == 0.0 ? 1.0 : sin(M_PI * cutoff * t) / (M_PI * cutoff * t);
+			row[j] = (float)(s * w);
+			sum += row[j];
+		}
+
+		// unity gain for every phase
+		for (pp_int32 j = 0; j < numTaps; j++)
+			row[j] = (float)(row[j] / sum);
+	}
+
+	windowSize = numTaps + BLOCKSIZE;
+	window = new float[windowSize];
+
+	// the signal is continued with its first and last value
+	firstValue = lastValue = 0.0f;
+	if (inputLength)
+	{
+		source.read(0, 1, &firstValue);
+		source.read(inputLength - 1, 1, &lastValue);
+	}
+
+	fillWindow(-(numTaps/2 - 1));
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+	delete[] window;
+	delete[] coeffs;
+}
+
+void PolyphaseResampler::fillWindow(pp_int32 start)
+{
+	windowStart = start;
+
+	pp_int32 end = start + windowSize;
+	pp_int32 from = start > 0 ? start : 0;
+	pp_int32 to = end < (pp_int32)inputLength ? end : (pp_int32)inputLength;
+
+	for (pp_int32 i = start; i < from && i < end; i++)
+		window[i - start] = firstValue;
+
+	if (from < to)
+		source.read(from, to - from, window + (from - start));
+
+	for (pp_int32 i = to > from ? to : from; i < end; i++)
+		window[i - start] = lastValue;
+}
+
+pp_uint32 PolyphaseResampler::process(float* dest, pp_uint32 count)
+{
+	if (count > outputLength - outputPos)
+		count = outputLength - outputPos;
+
+	for (pp_uint32 i = 0; i < count; i++, outputPos++)
+	{
+		double pos = outputPos * step;
+		pp_int32 ipos = (pp_int32)floor(pos);
+		double phase = (pos - ipos) * numPhases;
+		pp_int32 p = (pp_int32)phase;
+		float frac = (float)(phase - p);
+
+		pp_int32 first = ipos - (numTaps/2 - 1);
+		if (first + numTaps > windowStart + windowSize)
+			fillWindow(first);
+
+		const float* x = window + (first - windowStart);
+		const float* c0 = coeffs + p * numTaps;
+		const float* c1 = c0 + numTaps;
+
+		// independent sums so the compiler can keep them in one vector register
+		float a[4] = {0.0f, 0.0f, 0.0f, 0.0f}, b[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+		for (pp_int32 j = 0; j < numTaps; j += 4)
+		{
+			for (pp_int32 k = 0; k < 4; k++)
+			{
+				a[k] += c0[j+k] * x[j+k];
+				b[k] += c1[j+k] * x[j+k];
+			}
+		}
+
+		float sa = (a[0] + a[1]) + (a[2] + a[3]);
+		float sb = (b[0] + b[1]) + (b[2] + b[3]);
+		dest[i] = sa + (sb - sa) * frac;
+	}
+
+	return count;
+}
@@ -0,0 +1,107 @@
+/*
+ *  tracker/fx/PolyphaseResampler.h
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Band-limited mono resampler for offline use.
+ * A Kaiser windowed sinc is stored as a table of phases, output samples
+ * interpolate between the two nearest phases. Input is pulled in blocks
+ * from a Source and output is produced in blocks, so neither side has to
+ * be held in memory as floats.
+ */
+
+#ifndef __POLYPHASERESAMPLER_H__
+#define __POLYPHASERESAMPLER_H__
+
+#include "BasicTypes.h"
+
+class PolyphaseResampler
+{
+public:
+	enum Qualities
+	{
+		QualityFast,
+		QualityGood,
+		QualityBest
+	};
+
+	// delivers input as floats in [-1,1], indices are always within the input
+	class Source
+	{
+	public:
+		virtual ~Source() {}
+		virtual void read(pp_uint32 index, pp_uint32 count, float* dest) = 0;
+	};
+
+	// 8 bit, 16 bit or float buffers
+	template<class T>
+	class BufferSource : public Source
+	{
+	private:
+		const T* buffer;
+		float scale;
+
+	public:
+		BufferSource(const T* buffer, float scale) :
+			buffer(buffer),
+			scale(scale)
+		{
+		}
+
+		virtual void read(pp_uint32 index, pp_uint32 count, float* dest)
+		{
+			for (pp_uint32 i = 0; i < count; i++)
+				dest[i] = (float)buffer[index + i] * scale;
+		}
+	};
+
+private:
+	Source& source;
+	pp_uint32 inputLength;
+	pp_uint32 outputLength;
+	double step;
+
+	pp_int32 numTaps;
+	pp_int32 numPhases;
+	// numPhases+1 rows of numTaps coefficients
+	float* coeffs;
+
+	// the part of the input the filter currently sees
+	float* window;
+	pp_int32 windowSize;
+	pp_int32 windowStart;
+	float firstValue, lastValue;
+
+	pp_uint32 outputPos;
+
+	void fillWindow(pp_int32 start);
+
+public:
+	PolyphaseResampler(Source& source, pp_uint32 inputLength, float oldRate, float newRate, Qualities quality);
+	~PolyphaseResampler();
+
+	pp_uint32 getOutputLength() const { return outputLength; }
+
+	// write the next count output samples, returns how many were written
+	pp_uint32 process(float* dest, pp_uint32 count);
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ *  tracker/fx/STFT.cpp
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "STFT.h"
+
+STFT::STFT(int frameSize, int hop) :
+	frameSize(frameSize),
+	hop(hop),
+	fft(frameSize)
+{
+	window = (float*)malloc(frameSize * sizeof(float));
+	if (window == NULL) {
+		printf("Error: unable to allocate memory for STFT. Exiting.\n");
+		exit(1);
+	}
+	hann(window, frameSize);
+
+	/* the squared windows of overlapping frames add up to this,
+	   exact for hops of frameSize/4 and smaller */
+	gain = 0.0f;
+	for (int i = 0; i < frameSize; i++)
+		gain += window[i] * window[i];
+	gain /= hop;
+}
+
+STFT::~STFT()
+{
+	free(window);
+}
+
+void STFT::hann(float* w, int n)
+{
+	for (int i = 0; i < n; i++)
+		w[i] = (float)(0.5 - 0.5 * cos(2 * PI * i / (double)n));
+}
+
+void STFT::analyze(const float* in, int length, int pos, complex* bins) const
+{
+	for (int i = 0; i < frameSize; i++) {
+		int j = pos + i;
+		bins[i].Re = j >= 0 && j < length ? in[j] * window[i] : 0.0f;
+		bins[i].Im = 0.0f;
+	}
+	fft.forward(bins, frameSize);
+}
+
+void STFT::synthesize(complex* bins, float* out, int length, int pos) const
+{
+	int i;
+	/* spectrum of a real signal */
+	for (i = 1; i < frameSize / 2; i++) {
+		bins[frameSize - i].Re = bins[i].Re;
+		bins[frameSize - i].Im = -bins[i].Im;
+	}
+	fft.inverse(bins, frameSize);
+
+	float scale = 1.0f / (frameSize * gain);
+	for (i = 0; i < frameSize; i++) {
+		int j = pos + i;
+		if (j >= 0 && j < length)
+			out[j] += bins[i].Re * window[i] * scale;
+	}
+}
+
+PhaseVocoder::PhaseVocoder(int frameSize) :
+	frameSize(frameSize),
+	first(true)
+{
+	lastPhase = (float*)calloc(frameSize / 2 + 1, sizeof(float));
+	sumPhase = (float*)calloc(frameSize / 2 + 1, sizeof(float));
+	if (lastPhase == NULL || sumPhase == NULL) {
+		printf("Error: unable to allocate memory for phase vocoder. Exiting.\n");
+		exit(1);
+	}
+}
+
+PhaseVocoder::~PhaseVocoder()
+{
+	free(sumPhase);
+	free(lastPhase);
+}
+
+void PhaseVocoder::analyze(const complex* bins, int hop, float* magnitude, float* frequency)
+{
+	for (int k = 0; k <= frameSize / 2; k++) {
+		float phase = complex_arg(bins[k]);
+		magnitude[k] = complex_abs(bins[k]);
+		frequency[k] = (float)k;
+		if (!first && hop > 0) {
+			/* deviation from the phase advance of the bin center */
+			float expected = (float)(2 * PI * k * hop / frameSize);
+			float delta = wrap_phase(phase - lastPhase[k] - expected);
+			frequency[k] += (float)(delta * frameSize / (2 * PI * hop));
+		}
+		lastPhase[k] = phase;
+	}
+}
+
+void PhaseVocoder::synthesize(const float* magnitude, const float* frequency, int hop, complex* bins)
+{
+	for (int k = 0; k <= frameSize / 2; k++) {
+		/* the first frame keeps the phases of the analysis */
+		if (first)
+			sumPhase[k] = lastPhase[k];
+		else
+			sumPhase[k] = wrap_phase(sumPhase[k] + (float)(2 * PI * frequency[k] * hop / frameSize));
+		bins[k] = complex_polar(magnitude[k], sumPhase[k]);
+	}
+	first = false;
+}
@@ -0,0 +1,84 @@
+/*
+ *  tracker/fx/STFT.h
+ *
+ *  Copyright 2026 The MilkyTracker Team
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Short-time Fourier transform with overlap-add resynthesis and a
+ * phase vocoder working on its frames.
+ */
+
+#ifndef __STFT_H__
+#define __STFT_H__
+
+#include "FFT.h"
+
+// Hann windowed frames of a real signal, frames are hop samples apart
+class STFT
+{
+private:
+	int frameSize;
+	int hop;
+	FFT fft;
+	float* window;
+	float gain;
+
+public:
+	STFT(int frameSize, int hop);
+	~STFT();
+
+	int getFrameSize() const { return frameSize; }
+	int getHop() const { return hop; }
+
+	// periodic Hann window of n samples
+	static void hann(float* w, int n);
+
+	// transform the frame starting at in[pos] into frameSize bins,
+	// samples outside of 0..length-1 are taken as silence
+	void analyze(const float* in, int length, int pos, complex* bins) const;
+	// transform bins 0..frameSize/2 back and add the frame to out[pos],
+	// bins is overwritten
+	void synthesize(complex* bins, float* out, int length, int pos) const;
+};
+
+// Tracks the phase of bins 0..frameSize/2 from frame to frame,
+// analyze and synthesize are called once per frame
+class PhaseVocoder
+{
+private:
+	int frameSize;
+	float* lastPhase;
+	float* sumPhase;
+	bool first;
+
+public:
+	PhaseVocoder(int frameSize);
+	~PhaseVocoder();
+
+	void reset() { first = true; }
+
+	// magnitude and true frequency (in bins) of each bin, hop is the
+	// distance in samples to the previously analyzed frame
+	void analyze(const complex* bins, int hop, float* magnitude, float* frequency);
+	// bins with their phases advanced by hop samples at the given frequencies
+	void synthesize(const float* magnitude, const float* frequency, int hop, complex* bins);
+};
+
+#endif